@@ -135,7 +135,10 @@ public:
     explicit ExpressionBuilder(Document& doc);
     ExpressionFragments& getExpressions();
 
-    void add_position(uint32_t position, uint32_t offset, uint32_t line, std::shared_ptr<std::string> path) override;
+    uint32_t add_path(std::string_view path) override;
+    bool is_truncated() const override { return document.is_truncated(); }
+    void add_position(uint32_t position, uint32_t offset, uint32_t line, uint32_t path) override;
+    void set_source(uint32_t path, uint32_t offset, uint32_t length) override;
 
     void handle_error(const TypeException&) override;
     void handle_warning(const TypeException&) override;
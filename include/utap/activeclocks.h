@@ -0,0 +1,78 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_ACTIVECLOCKS_H
+#define UTAP_ACTIVECLOCKS_H
+
+#include "utap/document.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace UTAP {
+/**
+ * Live clock analysis of a type checked document. A clock is active
+ * in a location if its value may be read, by an invariant, a guard,
+ * an update or a function called by them, before the clock is
+ * assigned. Only assignments to whole clocks at the top level of an
+ * update count as assignments, thus a clock array is active as a
+ * whole. Clocks read by the system wide before/after updates are
+ * active everywhere. Queries are not taken into account.
+ *
+ * The active clocks of a process are given in terms of the symbols
+ * of its template, i.e. parameters are not replaced. A clock of the
+ * system is active in a global state if it is active in the location
+ * of any of the processes.
+ */
+class ActiveClocks
+{
+public:
+    using clocks_t = std::set<symbol_t>;
+    using classes_t = std::vector<std::vector<symbol_t>>;
+
+    explicit ActiveClocks(Document& document);
+
+    /** Returns the clocks which are active in the location. */
+    const clocks_t& get_active(const location_t& location) const;
+    /** Returns the clocks which are active in some location of the template. */
+    const clocks_t& get_used(const template_t& templ) const;
+    /**
+     * Groups the local clocks of the template into classes of clocks
+     * which are never active at the same point, i.e. in the same
+     * location or branchpoint or between two steps of the update of
+     * an edge. A clock being assigned counts as active together with
+     * the clocks active after the assignment. The clocks of a class
+     * can share a single clock as every clock is assigned before it
+     * becomes active.
+     */
+    const classes_t& get_classes(const template_t& templ) const;
+
+private:
+    std::map<const location_t*, clocks_t> active;
+    std::map<const template_t*, clocks_t> used;
+    std::map<const template_t*, classes_t> classes;
+
+    void analyse(const template_t& templ, const clocks_t& always);
+};
+}  // namespace UTAP
+
+#endif /* UTAP_ACTIVECLOCKS_H */
@@ -28,6 +28,7 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace UTAP {
@@ -95,11 +96,24 @@ public:
 
     virtual ~ParserBuilder() noexcept = default;
 
+    /**
+     * Registers the XPath of an XML element and returns an id to be
+     * used in add_position. Equal paths yield equal ids.
+     */
+    virtual uint32_t add_path(std::string_view path) = 0;
+
     /**
      * Add mapping from an absolute position to a relative XML
-     * element.
+     * element identified by the id returned from add_path.
      */
-    virtual void add_position(uint32_t position, uint32_t offset, uint32_t line, std::shared_ptr<std::string> path) = 0;
+    virtual void add_position(uint32_t position, uint32_t offset, uint32_t line, uint32_t path) = 0;
+
+    /**
+     * Records the byte range of the contents of the XML element
+     * identified by the id returned from add_path. Only called when
+     * the model is read from an in-memory buffer.
+     */
+    virtual void set_source(uint32_t path, uint32_t offset, uint32_t length) {}
 
     /**
      * Sets the current position. The current position indicates
@@ -114,6 +128,13 @@ public:
     // Called when a warning is issued
     virtual void handle_warning(const TypeException&) = 0;
 
+    /**
+     * Returns true if the builder does not accept any more input
+     * (e.g. the error budget is exceeded). The parsers check it
+     * between elements and stop early.
+     */
+    virtual bool is_truncated() const { return false; }
+
     /**
      * Must return true if and only if name is registered in the
      * symbol table as a named type, for instance, "int" or "bool" or
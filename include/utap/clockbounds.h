@@ -0,0 +1,98 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_CLOCKBOUNDS_H
+#define UTAP_CLOCKBOUNDS_H
+
+#include "utap/document.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+
+namespace UTAP {
+/** The largest constants a clock is compared with from below (L) and from above (U). */
+struct clock_bound_t
+{
+    static constexpr int32_t none = std::numeric_limits<int32_t>::min();     /**< The clock is not compared */
+    static constexpr int32_t infinity = std::numeric_limits<int32_t>::max(); /**< Compared with a non-constant */
+
+    int32_t lower{none}; /**< L: the largest c in x > c, x >= c and x == c */
+    int32_t upper{none}; /**< U: the largest c in x < c, x <= c and x == c */
+
+    /** Returns the maximal constant of the clock, i.e. max(L, U). */
+    int32_t get_max() const { return std::max(lower, upper); }
+    /** Includes the other bounds, returns true if these bounds changed. */
+    bool join(const clock_bound_t& other);
+    bool operator==(const clock_bound_t& other) const { return lower == other.lower && upper == other.upper; }
+    bool operator!=(const clock_bound_t& other) const { return !(*this == other); }
+};
+
+using clock_bounds_t = std::map<symbol_t, clock_bound_t>;
+
+/**
+ * Computes the LU bounds of the clocks of a type checked document for
+ * extrapolation. Constants are evaluated per process, thus they may be
+ * constant expressions over constants and template parameters. A
+ * comparison with an expression which is not computable at compile
+ * time yields clock_bound_t::infinity, except for bounded integers
+ * (e.g. select variables) which contribute their upper bound. A clock
+ * array is treated as one clock, i.e. all its elements share bounds.
+ * A difference constraint x - y ~ c contributes |c| to both bounds of
+ * x and y.
+ */
+class ClockBounds
+{
+public:
+    explicit ClockBounds(Document& document);
+
+    /**
+     * Returns the bounds over all processes. Clock parameters of templates
+     * are replaced by the clocks given as arguments.
+     */
+    const clock_bounds_t& get_global() const { return global; }
+    /** Returns the global bounds of the clock, empty bounds if the clock is not compared. */
+    const clock_bound_t& get_global(symbol_t clock) const;
+    /**
+     * Returns the bounds of the clocks used by the template, joined over
+     * all its processes. Clock parameters are not replaced.
+     */
+    const clock_bounds_t& get_template(const template_t& templ) const;
+    /**
+     * Returns the location dependent bounds: the constraints of the
+     * invariant and the outgoing edges, including those reachable
+     * through edges which do not reset the clock.
+     */
+    const clock_bounds_t& get_location(const location_t& location) const;
+    /** Returns true if the document compares clock differences, which LU extrapolation does not support. */
+    bool has_diagonals() const { return diagonals; }
+
+private:
+    clock_bounds_t global;
+    std::map<const template_t*, clock_bounds_t> templates;
+    std::map<const location_t*, clock_bounds_t> locations;
+    bool diagonals{false};
+
+    void analyse(const template_t& templ, const instance_t* process, bool in_system);
+};
+}  // namespace UTAP
+
+#endif /* UTAP_CLOCKBOUNDS_H */
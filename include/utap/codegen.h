@@ -0,0 +1,117 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_CODEGEN_H
+#define UTAP_CODEGEN_H
+
+#include "utap/document.h"
+#include "utap/library.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace UTAP {
+class StateLayout;
+
+/** A compiled guard or invariant: returns non-zero if it holds. */
+using native_guard_t = int32_t (*)(const int32_t* state, const double* clocks);
+/** A compiled update. */
+using native_update_t = void (*)(int32_t* state, double* clocks);
+
+/**
+ * Generates C++ source for the guards, invariants and updates of the
+ * processes of a type checked document and for the functions they
+ * call, against a flat state ABI:
+ * - the discrete state is the unpacked state of the StateLayout, one
+ *   int32_t per field, and the clock valuation holds one double per
+ *   clock of the layout after the reference clock at index 0;
+ * - processes are numbered in the order of the layout, with process
+ *   sets expanded, and their edges in the order of template_t::edges;
+ * - `utap_guards[utap_edges[p] + e]` is the native_guard_t of edge e of
+ *   process p and `utap_updates[utap_edges[p] + e]` its native_update_t;
+ * - `utap_invariants[utap_locations[p] + l]` is the native_guard_t of
+ *   the invariant of location number l of process p;
+ * - `utap_process_count` is the number of processes.
+ *
+ * Constants and constant parameters are folded into the code, while
+ * mutable by-value parameters are fields of the process. Guards,
+ * invariants and updates using what the generator does not support,
+ * e.g. doubles, clock rates, external functions or arrays passed to
+ * functions, get a null entry and are listed by get_unsupported, so
+ * callers may interpret them instead. Array indices and the ranges of
+ * assigned values are not checked.
+ */
+class CodeGenerator
+{
+public:
+    CodeGenerator(Document& document, const StateLayout& layout);
+
+    /** Returns the generated C++ source. */
+    const std::string& get_source() const { return source; }
+    /**
+     * Returns what was not compiled, one line per guard, invariant, update or function with the reason,
+     * e.g. "P.edge1.guard: Function f".
+     */
+    const std::vector<std::string>& get_unsupported() const { return unsupported; }
+
+private:
+    std::string source;
+    std::vector<std::string> unsupported;
+};
+
+/**
+ * The code of a CodeGenerator compiled by the system compiler into a
+ * shared library and loaded through Library.
+ */
+class NativeModule
+{
+public:
+    /**
+     * Compiles the source into a library in the directory with the
+     * compiler, by default the one named by the CXX environment variable
+     * or c++. Throws std::runtime_error if compiling or loading fails.
+     */
+    NativeModule(const std::string& source, const std::filesystem::path& directory, std::string compiler = {});
+
+    size_t get_process_count() const { return process_count; }
+    /** Returns the guard of the edge of the process, nullptr if it was not compiled. */
+    native_guard_t get_guard(size_t process, size_t edge) const { return guards[edges[process] + edge]; }
+    /** Returns the update of the edge of the process, nullptr if it was not compiled. */
+    native_update_t get_update(size_t process, size_t edge) const { return updates[edges[process] + edge]; }
+    /** Returns the invariant of the location of the process, nullptr if it was not compiled. */
+    native_guard_t get_invariant(size_t process, size_t location) const
+    {
+        return invariants[locations[process] + location];
+    }
+
+private:
+    Library library;
+    size_t process_count{0};
+    const uint32_t* edges{nullptr};
+    const uint32_t* locations{nullptr};
+    const native_guard_t* guards{nullptr};
+    const native_update_t* updates{nullptr};
+    const native_guard_t* invariants{nullptr};
+};
+}  // namespace UTAP
+
+#endif /* UTAP_CODEGEN_H */
@@ -0,0 +1,91 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_COSTMODEL_H
+#define UTAP_COSTMODEL_H
+
+#include "utap/document.h"
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace UTAP {
+class Statement;
+
+/**
+ * A static estimate of the cost of the functions, guards, invariants
+ * and updates of a type checked document, in abstract operations:
+ * every operator, assignment and call counts one, reading variables
+ * and constants is free, a branch costs as much as its most expensive
+ * alternative and a call adds the cost of the function body. External
+ * functions count as one operation.
+ *
+ * Loops multiply the cost of their body by a bound on the number of
+ * iterations (trips):
+ * - a range loop `for (i : T)`, a quantifier or a sum iterates once
+ *   per value of T;
+ * - a for loop with a counter, e.g. `for (i = a; i < b; i += k)` with
+ *   <, <=, >, >= or != and ++, --, += k, -= k or i = i + k, iterates
+ *   (b - a) / k times if a, b and k are constant, otherwise as often
+ *   as the declared range of the counter allows. The body must not
+ *   assign the counter;
+ * - a while or do-while loop is bounded only if its condition is the
+ *   constant false.
+ * Costs saturate at unbounded, the cost of unbounded loops and of
+ * recursive functions. Template parameters are not evaluated, as the
+ * templates are shared by their processes.
+ */
+class CostModel
+{
+public:
+    static constexpr uint64_t unbounded = std::numeric_limits<uint64_t>::max();
+
+    /** A loop of a function and the bound of its iterations, nothing if there is none. */
+    struct loop_t
+    {
+        const function_t* function;
+        const Statement* statement;
+        std::optional<uint64_t> trips;
+    };
+
+    explicit CostModel(Document& document);
+
+    /** Returns the cost of a call of the function, not including the evaluation of the arguments. */
+    uint64_t get_cost(const function_t& function) const { return functions.at(&function); }
+    uint64_t get_guard_cost(const edge_t& edge) const { return guards.at(&edge); }
+    uint64_t get_update_cost(const edge_t& edge) const { return updates.at(&edge); }
+    uint64_t get_invariant_cost(const location_t& location) const { return invariants.at(&location); }
+    /** Returns the loops of all functions. */
+    const std::vector<loop_t>& get_loops() const { return loops; }
+
+private:
+    std::map<const function_t*, uint64_t> functions;
+    std::map<const edge_t*, uint64_t> guards;
+    std::map<const edge_t*, uint64_t> updates;
+    std::map<const location_t*, uint64_t> invariants;
+    std::vector<loop_t> loops;
+};
+}  // namespace UTAP
+
+#endif /* UTAP_COSTMODEL_H */
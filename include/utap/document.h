@@ -30,9 +30,11 @@
 
 #include <algorithm>  // find
 #include <deque>
+#include <initializer_list>
 #include <list>
 #include <map>
 #include <optional>
+#include <string_view>
 #include <vector>
 
 namespace UTAP {
@@ -131,6 +133,7 @@ struct function_t : stringify_t<function_t>
     symbol_t uid;                                  /**< The symbol of the function. */
     std::set<symbol_t> changes{};                  /**< Variables changed by this function. */
     std::set<symbol_t> depends{};                  /**< Variables the function depends on. */
+    bool has_side_effects{true};                   /**< Cleared by the type checker if calls change nothing. */
     std::list<variable_t> variables{};             /**< Local variables. List is used for stable pointers. */
     std::unique_ptr<BlockStatement> body{nullptr}; /**< Pointer to the block. */
     function_t() = default;
@@ -476,12 +479,38 @@ struct query_t
 };
 using queries_t = std::vector<query_t>;
 
+/**
+ * Limits the number of errors and warnings a document collects.
+ * Zero means unlimited. Once a limit is exceeded, further messages are
+ * dropped and the document is marked as truncated, which makes the
+ * parser and type checker stop early.
+ */
+struct error_budget_t
+{
+    size_t errors{0};
+    size_t warnings{0};
+};
+
+/** Returned by the parse functions when parsing stopped early because the error budget was exceeded. */
+constexpr int32_t PARSE_TRUNCATED = 1;
+
 class Document;
+class ActiveClocks;
+class ClockBounds;
+class CostModel;
+class EdgeIndex;
+class ExpressionTable;
+class GuardForms;
+class PriorityTable;
+class Symmetry;
+class ValueRanges;
 
 class DocumentVisitor
 {
 public:
     virtual ~DocumentVisitor() noexcept = default;
+    /** Returns true if the traversal should stop before visiting further elements. */
+    virtual bool isDone() const { return false; }
     virtual void visitDocBefore(Document&) {}
     virtual void visitDocAfter(Document&) {}
     virtual void visitVariable(variable_t&) {}
@@ -502,6 +531,66 @@ public:
     virtual void visitUpdate(update_t&) {}
 };
 
+/**
+ * Runs several visitors in as few traversals of a document as possible.
+ * Every element is handed to the visitors in the order in which they were
+ * added, thus a visitor may rely on the effects earlier visitors had on
+ * the same element. A visitor which requires the complete results of other
+ * visitors is deferred to a later traversal. Visitors which are done are
+ * skipped and a traversal stops once all of its visitors are done.
+ */
+class DocumentVisitorPipeline : public DocumentVisitor
+{
+public:
+    /** Adds a visitor which is run after the visitors in \a after have traversed the whole document. */
+    DocumentVisitorPipeline& add(DocumentVisitor& visitor, std::initializer_list<const DocumentVisitor*> after = {});
+    /** Runs the visitors, one traversal per stage. */
+    void run(Document& document);
+    /** Runs the first stage over the global declarations added so far, see Document::accept_globals. */
+    size_t run_globals(Document& document);
+    /** Completes the traversals after run_globals() returned the given number of global declarations. */
+    void run(Document& document, size_t globals);
+    /** Returns the number of traversals run() makes. */
+    size_t get_stage_count() const;
+
+    bool isDone() const override;
+    void visitDocBefore(Document&) override;
+    void visitDocAfter(Document&) override;
+    void visitVariable(variable_t&) override;
+    bool visitTemplateBefore(template_t&) override;
+    void visitTemplateAfter(template_t&) override;
+    void visitLocation(location_t&) override;
+    void visitEdge(edge_t&) override;
+    void visitInstance(instance_t&) override;
+    void visitProcess(instance_t&) override;
+    void visitFunction(function_t&) override;
+    void visitTypeDef(symbol_t) override;
+    void visitIODecl(iodecl_t&) override;
+    void visitProgressMeasure(progress_t&) override;
+    void visitGanttChart(gantt_t&) override;
+    void visitInstanceLine(instance_line_t&) override;
+    void visitMessage(message_t&) override;
+    void visitCondition(condition_t&) override;
+    void visitUpdate(update_t&) override;
+
+private:
+    struct pass_t
+    {
+        DocumentVisitor* visitor;
+        size_t stage;
+    };
+    std::vector<pass_t> passes;
+    std::vector<DocumentVisitor*> stage;    /**< Visitors of the current traversal */
+    std::vector<DocumentVisitor*> accepted; /**< Visitors which accepted the current template */
+    bool in_template{false};
+
+    /** Makes the visitors of the given stage the current ones. */
+    void select(size_t s);
+
+    template <typename Fn>
+    void dispatch(Fn&& fn);
+};
+
 class Document
 {
 public:
@@ -527,8 +616,14 @@ public:
     /** Returns the queries enclosed in the model. */
     const queries_t& get_queries() const { return queries; }
 
-    void add_position(uint32_t position, uint32_t offset, uint32_t line, std::shared_ptr<std::string> path);
-    const position_index_t::line_t& find_position(uint32_t position) const;
+    /** Interns the XML element path and returns its id for add_position(). */
+    uint32_t add_path(std::string_view path);
+    void add_position(uint32_t position, uint32_t offset, uint32_t line, uint32_t path);
+    position_index_t::line_t find_position(uint32_t position) const;
+    /** Records the byte range in the XML buffer of the element with the given path id. */
+    void set_source(uint32_t path, uint32_t offset, uint32_t length);
+    /** Returns the byte range in the XML buffer of the element with the given XPath, if known. */
+    std::optional<position_index_t::source_t> find_source(std::string_view path) const;
 
     variable_t* add_variable_to_function(function_t*, frame_t, type_t, const std::string&, expression_t initital,
                                          position_t);
@@ -554,6 +649,16 @@ public:
     void add_process(instance_t& instance, position_t);
     void add_gantt(declarations_t*, gantt_t);  // copies gantt_t and moves it
     void accept(DocumentVisitor&);
+    /**
+     * Visits the global declarations added so far, starting with
+     * visitDocBefore, and returns their number. The traversal can be
+     * completed with accept(visitor, globals) once the document is
+     * complete, e.g. to check the global declarations while the rest
+     * of the document is still being parsed.
+     */
+    size_t accept_globals(DocumentVisitor&);
+    /** Visits the document skipping visitDocBefore and the given number of global declarations. */
+    void accept(DocumentVisitor&, size_t globals);
 
     void set_before_update(expression_t);
     expression_t get_before_update();
@@ -576,6 +681,8 @@ public:
 
     /** Returns process priority for process \a name. */
     int get_proc_priority(const char* name) const;
+    /** Returns the process priorities by process name. */
+    const std::map<std::string, int>& get_proc_priorities() const { return proc_priority; }
 
     /** Returns true if document has some priority declaration. */
     bool has_priority_declaration() const { return hasPriorities; }
@@ -650,28 +757,65 @@ protected:
                              position_t);
 
     std::string location;
-    std::vector<Library> libraries;
+    std::vector<std::shared_ptr<SharedLibrary>> libraries;
     InternedStrings strings;
     SupportedMethods supported_methods{};
 
 public:
     void add(Library&& lib);
+    /** Adds a library shared with other documents, see SharedLibrary::load. */
+    void add(std::shared_ptr<SharedLibrary> lib);
     /** Returns the last successfully loaded library, or throws std::runtime_error. */
-    Library& last_library();
+    SharedLibrary& last_library();
     void add_error(position_t, std::string msg, std::string ctx = "");
     void add_warning(position_t, const std::string& msg, const std::string& ctx = "");
     bool has_errors() const { return !errors.empty(); }
     bool has_warnings() const { return !warnings.empty(); }
     const std::vector<error_t>& get_errors() const { return errors; }
     const std::vector<error_t>& get_warnings() const { return warnings; }
-    void clear_errors() const { errors.clear(); }
-    void clear_warnings() const { warnings.clear(); }
+    void clear_errors() const
+    {
+        errors.clear();
+        errors_dropped = false;
+    }
+    void clear_warnings() const
+    {
+        warnings.clear();
+        warnings_dropped = false;
+    }
+    void set_error_budget(const error_budget_t& budget) { error_budget = budget; }
+    const error_budget_t& get_error_budget() const { return error_budget; }
+    /** Returns true if some errors or warnings were dropped because the error budget was exceeded. */
+    bool is_truncated() const { return errors_dropped || warnings_dropped; }
     bool is_modified() const { return modified; }
     void set_modified(bool mod) { modified = mod; }
     iodecl_t* add_io_decl();
     void set_supported_methods(const SupportedMethods& supportedMethods);
     const SupportedMethods& get_supported_methods() const { return supported_methods; }
-    const position_index_t& get_positions() const { return positions; }
+    const position_index_t& get_positions() const { return *positions; }
+    /**
+     * Returns the lower and upper bounds clocks are compared with, see ClockBounds.
+     * Computed on first use, thus the document must be type checked by then.
+     */
+    const ClockBounds& get_clock_bounds();
+    /** Returns the clocks which are active per location, see ActiveClocks. Computed on first use like the bounds. */
+    const ActiveClocks& get_active_clocks();
+    /** Returns the ranges of the integer variables, see ValueRanges. Computed on first use like the bounds. */
+    const ValueRanges& get_value_ranges();
+    /** Returns the outgoing edge and channel indices of the templates, see EdgeIndex. Computed on first use. */
+    const EdgeIndex& get_edge_index();
+    /** Returns the guards and invariants in normal form, see GuardForms. Computed on first use. */
+    const GuardForms& get_guard_forms();
+    /** Returns the scalarsets and what is permuted with them, see Symmetry. Computed on first use. */
+    const Symmetry& get_symmetry();
+    /** Returns the channel and process priorities as flat tables, see PriorityTable. Computed on first use. */
+    const PriorityTable& get_priority_table();
+    /** Returns the estimated costs of the functions and edges, see CostModel. Computed on first use. */
+    const CostModel& get_cost_model();
+    /** Returns the hash-consing table of the document, see ExpressionTable. Only interned expressions are shared. */
+    ExpressionTable& get_expression_table();
+    /** Drops the analyses computed so far, must be called after modifying the templates. */
+    void reset_analyses();
     void add_channel(bool is_broadcast);
     bool all_broadcast() const { return !hasNonBroadcastChan; }
 
@@ -679,7 +823,19 @@ private:
     // TODO: move errors & warnings to ParserBuilder to get rid of mutable
     mutable std::vector<error_t> errors;
     mutable std::vector<error_t> warnings;
-    position_index_t positions;
+    mutable bool errors_dropped{false};
+    mutable bool warnings_dropped{false};
+    error_budget_t error_budget{};
+    std::shared_ptr<position_index_t> positions{std::make_shared<position_index_t>()}; /**< Shared with errors */
+    std::shared_ptr<const ClockBounds> clock_bounds;   /**< Computed by get_clock_bounds */
+    std::shared_ptr<const ActiveClocks> active_clocks; /**< Computed by get_active_clocks */
+    std::shared_ptr<const ValueRanges> value_ranges;   /**< Computed by get_value_ranges */
+    std::shared_ptr<const EdgeIndex> edge_index;       /**< Computed by get_edge_index */
+    std::shared_ptr<const GuardForms> guard_forms;     /**< Computed by get_guard_forms */
+    std::shared_ptr<const Symmetry> symmetry;          /**< Computed by get_symmetry */
+    std::shared_ptr<const CostModel> cost_model;       /**< Computed by get_cost_model */
+    std::shared_ptr<const PriorityTable> priorities;   /**< Computed by get_priority_table */
+    std::shared_ptr<ExpressionTable> expression_table; /**< Created by get_expression_table */
 };
 }  // namespace UTAP
 
@@ -0,0 +1,137 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_EDGEINDEX_H
+#define UTAP_EDGEINDEX_H
+
+#include "utap/document.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace UTAP {
+/** A view of a contiguous sequence of edges, valid as long as the index it came from. */
+class edge_view_t
+{
+    const edge_t* const* first{nullptr};
+    const edge_t* const* last{nullptr};
+
+public:
+    edge_view_t() = default;
+    edge_view_t(const edge_t* const* first, const edge_t* const* last): first{first}, last{last} {}
+    const edge_t* const* begin() const { return first; }
+    const edge_t* const* end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    const edge_t& operator[](size_t i) const { return *first[i]; }
+};
+
+/**
+ * Immutable compressed sparse row indices of the edges of one template:
+ * the outgoing edges of every location and branchpoint, and the edges
+ * sending and receiving on every channel. Edges are kept in the order
+ * of the template.
+ *
+ * Channels are identified by the symbols of the template, i.e. a
+ * channel parameter is not replaced by its argument. An element of a
+ * channel array is identified by its row-major index. An edge whose
+ * index is not computable at compile time is listed for every element
+ * of the array, thus a lookup yields all edges which may synchronise
+ * on the element. If the size of the array is not computable either,
+ * the edge is listed under any_element only.
+ */
+class TemplateEdges
+{
+public:
+    static constexpr int32_t any_element = -1;
+
+    TemplateEdges() = default;
+    explicit TemplateEdges(const template_t& templ);
+
+    edge_view_t get_outgoing(const location_t& location) const { return row(outgoing, location.nr); }
+    edge_view_t get_outgoing(const branchpoint_t& branchpoint) const
+    {
+        return row(outgoing, locations + branchpoint.bpNr);
+    }
+    /** Returns the edges which may send on the channel (element). */
+    edge_view_t get_senders(const symbol_t& channel, int32_t element = 0) const
+    {
+        return row(senders, find(channel, element));
+    }
+    /** Returns the edges which may receive on the channel (element). */
+    edge_view_t get_receivers(const symbol_t& channel, int32_t element = 0) const
+    {
+        return row(receivers, find(channel, element));
+    }
+    /** Returns the edges without synchronisation. */
+    edge_view_t get_unsynchronised() const
+    {
+        return {unsynchronised.data(), unsynchronised.data() + unsynchronised.size()};
+    }
+
+private:
+    struct csr_t
+    {
+        std::vector<uint32_t> offsets{0};
+        std::vector<const edge_t*> edges;
+    };
+    struct channel_t
+    {
+        symbol_t symbol;
+        int32_t element;
+        bool operator<(const channel_t& other) const
+        {
+            return symbol < other.symbol || (symbol == other.symbol && element < other.element);
+        }
+    };
+
+    size_t locations{0};
+    csr_t outgoing;
+    std::vector<channel_t> channels; /**< Sorted, the rows of senders and receivers */
+    csr_t senders;
+    csr_t receivers;
+    std::vector<const edge_t*> unsynchronised;
+
+    size_t find(const symbol_t& channel, int32_t element) const;
+    static edge_view_t row(const csr_t& csr, size_t i)
+    {
+        if (i + 1 >= csr.offsets.size())
+            return {};
+        return {csr.edges.data() + csr.offsets[i], csr.edges.data() + csr.offsets[i + 1]};
+    }
+};
+
+/** The edge indices of all templates of a type checked document, including dynamic templates. */
+class EdgeIndex
+{
+public:
+    explicit EdgeIndex(Document& document);
+
+    /** Returns the index of the template, an empty index for templates unknown to the document. */
+    const TemplateEdges& get(const template_t& templ) const;
+
+private:
+    std::map<const template_t*, TemplateEdges> templates;
+};
+}  // namespace UTAP
+
+#endif /* UTAP_EDGEINDEX_H */
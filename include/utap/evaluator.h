@@ -0,0 +1,59 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_EVALUATOR_H
+#define UTAP_EVALUATOR_H
+
+#include "utap/expression.h"
+
+#include <map>
+#include <optional>
+
+namespace UTAP {
+struct instance_t;
+
+/**
+ * Evaluates integer and boolean expressions which are computable at
+ * compile time: literals, constant variables (including elements of
+ * constant arrays) and constant by-value template parameters bound by
+ * an instance.
+ * Expressions over anything else, or whose value does not fit into
+ * int32_t, have no value. The document must be type checked.
+ */
+class ConstantEvaluator
+{
+    const std::map<symbol_t, expression_t>* mapping{nullptr};
+
+    std::optional<expression_t> resolve(const expression_t& expr) const;
+
+public:
+    ConstantEvaluator() = default;
+    /** Evaluates constant by-value template parameters to the arguments of the instance. */
+    explicit ConstantEvaluator(const instance_t& instance);
+
+    /** Returns the value of the expression if it is computable at compile time. */
+    std::optional<int32_t> evaluate(const expression_t& expr) const;
+    /** Returns the largest value the expression may take: its value or the upper bound of its range type. */
+    std::optional<int32_t> evaluate_upper(const expression_t& expr) const;
+};
+}  // namespace UTAP
+
+#endif /* UTAP_EVALUATOR_H */
@@ -27,6 +27,8 @@
 #include "utap/string_interning.h"
 #include "utap/symbols.h"
 
+#include <functional>
+#include <map>
 #include <memory>  // shared_ptr
 #include <set>
 #include <string_view>
@@ -85,6 +87,13 @@ public:
     /** Make a shallow clone of the expression. */
     expression_t clone() const;
 
+    /** Returns the expression with every non-empty subexpression replaced by rewrite of it. The node is
+     * cloned on the first change only, as it may be shared, thus it is returned itself if nothing changes. */
+    expression_t rewrite_children(const std::function<expression_t(const expression_t&)>& rewrite) const;
+
+    /** Returns the number of nodes of the expression tree, 0 if empty. */
+    size_t count_nodes() const;
+
     /** Makes a deep clone of the expression. */
     expression_t clone_deeper() const;
 
@@ -96,6 +105,10 @@ public:
      * with a symbol from the given frame(s), with the same name */
     expression_t clone_deeper(frame_t frame, frame_t select = {}) const;
 
+    /** Makes a deep clone of the expression placed at the given position, the identifiers of
+     * the bound symbols are replaced by their expressions, which are shared, not cloned. */
+    expression_t clone_deeper(const std::map<symbol_t, expression_t>& bindings, const position_t& position) const;
+
     /** Returns the kind of the expression. */
     Constants::kind_t get_kind() const;
 
@@ -156,6 +169,15 @@ public:
     /** Equality operator */
     bool equal(const expression_t&) const;
 
+    /**
+     * Returns a structural hash, equal for expressions which are
+     * equal(). Symbols are hashed by name, thus the hash is the same
+     * across runs. Memoised per node; modifying a node through
+     * operator[] or get() recomputes it, modifying a shared
+     * subexpression in place does not update its ancestors.
+     */
+    size_t hash() const;
+
     /**
      *  Returns the symbol of a variable reference. The expression
      *  must be a left-hand side value. In case of
@@ -194,6 +216,10 @@ public:
             identified by the given symbols. */
     bool changes_variable(const std::set<symbol_t>&) const;
 
+    /** True if this expression can change a variable for which the
+        predicate holds. Stops at the first such variable. */
+    bool changes_variable_if(const std::function<bool(symbol_t)>&) const;
+
     /** True if this expression can change any variable at all. */
     bool changes_any_variable() const;
 
@@ -201,6 +227,10 @@ public:
         any of the symbols in the given set. */
     bool depends_on(const std::set<symbol_t>&) const;
 
+    /** True if the evaluation of this expression depends on a symbol
+        for which the predicate holds. Stops at the first such symbol. */
+    bool depends_on_if(const std::function<bool(symbol_t)>&) const;
+
     void collect_possible_writes(std::set<symbol_t>&) const;
     void collect_possible_reads(std::set<symbol_t>&, bool collectRandom = false) const;
 
@@ -0,0 +1,101 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_EXTERNAL_H
+#define UTAP_EXTERNAL_H
+
+#include "utap/type.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace UTAP {
+/** How an argument or the result of an external function is passed. */
+enum class external_kind_t {
+    Void,   /**< No result */
+    Int,    /**< int32_t, for integers and ranges */
+    Bool,   /**< bool */
+    Double, /**< double */
+    Pointer /**< Arrays, strings and references, passed as a pointer to the (first) element */
+};
+
+/** An argument or the result of an external function call, interpreted according to its external_kind_t. */
+union external_value_t {
+    int32_t i;
+    bool b;
+    double d;
+    void* p;
+
+    external_value_t(): p{nullptr} {}
+    external_value_t(int32_t value): i{value} {}
+    external_value_t(bool value): b{value} {}
+    external_value_t(double value): d{value} {}
+    external_value_t(void* value): p{value} {}
+    external_value_t(const void* value): p{const_cast<void*>(value)} {}
+};
+
+/**
+ * A type safe invoker of a function imported from a library: the
+ * calling convention is derived from the FUNCTION_EXTERNAL type once,
+ * when the function is declared, and fixed in a trampoline which calls
+ * the symbol through a function pointer of the exact signature.
+ * Signatures of up to max_arity parameters are supported.
+ */
+class ExternalFunction
+{
+public:
+    static constexpr size_t max_arity = 4;
+
+    /** Throws std::logic_error if the signature of the FUNCTION_EXTERNAL type is not supported. */
+    ExternalFunction(void* symbol, const type_t& type);
+
+    /** Returns how a value of the type is passed, nothing if it cannot be. */
+    static std::optional<external_kind_t> classify(const type_t& type);
+
+    /** Calls the function with one value per parameter. */
+    external_value_t operator()(const external_value_t* arguments) const { return invoke(symbol, arguments); }
+    /**
+     * Calls the function count times, the arguments of the calls are
+     * consecutive rows of get_parameters().size() values. The results
+     * are stored in results, unless the function returns void.
+     */
+    void call(const external_value_t* arguments, size_t count, external_value_t* results) const
+    {
+        invoke_batch(symbol, arguments, count, results);
+    }
+
+    external_kind_t get_result() const { return result; }
+    const std::vector<external_kind_t>& get_parameters() const { return parameters; }
+
+    using trampoline_t = external_value_t (*)(void*, const external_value_t*);
+    using batch_trampoline_t = void (*)(void*, const external_value_t*, size_t, external_value_t*);
+
+private:
+    void* symbol;
+    external_kind_t result;
+    std::vector<external_kind_t> parameters;
+    trampoline_t invoke{nullptr};
+    batch_trampoline_t invoke_batch{nullptr};
+};
+}  // namespace UTAP
+
+#endif /* UTAP_EXTERNAL_H */
@@ -30,12 +30,18 @@ namespace UTAP {
 class FeatureChecker : public DocumentVisitor, public AbstractStatementVisitor
 {
 private:
+    Document& document;
     SupportedMethods supported_methods{};
 
 public:
     explicit FeatureChecker(Document& document);
+    /** Registers the checker with the pipeline, the features are known once the pipeline has run. */
+    FeatureChecker(Document& document, DocumentVisitorPipeline& pipeline);
     SupportedMethods get_supported_methods() { return supported_methods; }
 
+    bool isDone() const override { return document.is_truncated(); }
+    void visitDocAfter(Document&) override;
+
     void visitEdge(edge_t& edge) override;
     void visitAssignment(expression_t& ass);
     void visitGuard(expression_t& guard);
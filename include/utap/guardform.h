@@ -0,0 +1,107 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_GUARDFORM_H
+#define UTAP_GUARDFORM_H
+
+#include "utap/document.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace UTAP {
+class ConstantEvaluator;
+
+/** A clock, an element of a clock array or the reference clock, which is always 0. */
+struct clock_term_t
+{
+    static constexpr int32_t any_element = -1;
+
+    symbol_t clock;     /**< The clock (array), empty for the reference clock */
+    int32_t element{0}; /**< Row-major index of the array element, any_element if not computable */
+    expression_t expr;  /**< The term as written, empty for the reference clock */
+
+    bool is_reference() const { return clock == symbol_t{}; }
+};
+
+/** A canonical clock constraint first - second < bound, or <= bound if not strict. */
+struct clock_constraint_t
+{
+    clock_term_t first;
+    clock_term_t second;
+    expression_t bound; /**< A constant if computable */
+    bool strict{false};
+};
+
+/**
+ * A guard or invariant split into the parts engines handle separately.
+ * The original expression is equivalent to the conjunction of all
+ * parts.
+ */
+struct guard_form_t
+{
+    expression_t data;                      /**< Conjunction of the clock free predicates, empty if none */
+    std::vector<clock_constraint_t> clocks; /**< Conjunction of canonical clock constraints */
+    std::vector<expression_t> rates;        /**< Rate specifications x' == e */
+    expression_t residual;                  /**< Conjunction of the remaining clock constraints, empty if none */
+    bool unsatisfiable{false};              /**< Some conjunct is constantly false */
+
+    /** Returns true if the clock constraints are all canonical. */
+    bool is_simple() const { return residual.empty(); }
+};
+
+/**
+ * Splits the top level conjunction of a guard or invariant. Clock free
+ * conjuncts go to the data part, comparisons of a clock or a
+ * difference of clocks with a clock free bound become canonical
+ * constraints, and anything else using clocks, e.g. disjunctions,
+ * negations or universal quantifiers, is kept as residual. Conjuncts
+ * which evaluate to true are dropped, bounds and array indices are
+ * evaluated where computable.
+ */
+guard_form_t normalise_guard(const expression_t& expr, const ConstantEvaluator& evaluator);
+
+/**
+ * The normal forms of the guards and invariants of all templates of a
+ * type checked document, including dynamic templates. Template
+ * parameters are not evaluated; use normalise_guard with the evaluator
+ * of an instance to fold them as well.
+ */
+class GuardForms
+{
+public:
+    explicit GuardForms(Document& document);
+
+    /** Returns the normal form of the guard, an empty form for edges unknown to the document. */
+    const guard_form_t& get_guard(const edge_t& edge) const;
+    /** Returns the normal form of the invariant, an empty form for locations unknown to the document. */
+    const guard_form_t& get_invariant(const location_t& location) const;
+
+private:
+    std::map<const edge_t*, guard_form_t> guards;
+    std::map<const location_t*, guard_form_t> invariants;
+
+    void add(const template_t& templ);
+};
+}  // namespace UTAP
+
+#endif /* UTAP_GUARDFORM_H */
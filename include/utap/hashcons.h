@@ -0,0 +1,69 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_HASHCONS_H
+#define UTAP_HASHCONS_H
+
+#include "utap/expression.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace UTAP {
+struct template_t;
+
+/**
+ * Hash-consing of expressions: interning returns the same node for
+ * all equal() expressions of the same type, so identical
+ * subexpressions are stored once and evaluators may cache results per
+ * node. Only typed expressions without side effects are shared, the
+ * others are rebuilt from shared subexpressions. A shared node keeps
+ * the position of its first occurrence and must not be modified in
+ * place.
+ */
+class ExpressionTable
+{
+public:
+    /** Returns the shared expression equal to the expression. */
+    expression_t intern(const expression_t& expr);
+    /** Returns the number of shared nodes. */
+    size_t size() const { return table.size(); }
+
+private:
+    std::unordered_multimap<size_t, expression_t> table;
+
+    expression_t intern(const expression_t& expr, bool pure);
+};
+
+/**
+ * Shares the equal subexpressions of the guards, invariants,
+ * synchronisations and updates of the template through the table and
+ * returns the compound subexpressions occurring more than once, in
+ * order of first occurrence. Subexpressions of updates only count if
+ * they do not read a variable written by the update, thus all
+ * occurrences evaluate to the same value in a state and evaluating
+ * them once per state suffices. Subexpressions of a returned
+ * expression are only returned if they also occur elsewhere.
+ */
+std::vector<expression_t> eliminate_common_subexpressions(template_t& templ, ExpressionTable& table);
+}  // namespace UTAP
+
+#endif /* UTAP_HASHCONS_H */
@@ -0,0 +1,82 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_INLINER_H
+#define UTAP_INLINER_H
+
+#include "utap/document.h"
+
+#include <string>
+#include <vector>
+
+namespace UTAP {
+/** Bounds the functions inline_calls substitutes. */
+struct inline_limits_t
+{
+    size_t size{32}; /**< The largest number of nodes of an inlined function body */
+};
+
+/** A call replaced by inline_functions, located at the call. */
+struct inlining_t
+{
+    const template_t* templ;
+    position_t position;  /**< The position of the call */
+    std::string function; /**< The name of the inlined function */
+    std::string original; /**< The call */
+    std::string result;   /**< The expression replacing the call */
+};
+
+/**
+ * Returns the expression a call of the function may be replaced by,
+ * the empty expression if the function cannot be inlined. A function
+ * is inlined if it has no side effects and no local variables, and its
+ * body is a single return statement or if statements choosing between
+ * return statements, which become conditional expressions. The
+ * expression returned has no side effects either and at most
+ * limits.size nodes.
+ */
+expression_t inline_body(const function_t& function, const inline_limits_t& limits = {});
+
+/**
+ * Replaces the calls of inlinable functions, see inline_body, by their
+ * body with the parameters replaced by the arguments. Calls in the
+ * inlined bodies are inlined as well, recursive functions are not. Returns
+ * the expression itself if nothing changed. Shared subexpressions are
+ * not modified; the nodes of the inlined bodies are placed at the
+ * call, the arguments keep their own positions. Calls with arguments
+ * having side effects, or whose type differs from the parameter beyond
+ * the range of an integer, are kept: the range of integer parameters
+ * is not checked once inlined.
+ */
+expression_t inline_calls(const expression_t& expr, const inline_limits_t& limits = {});
+
+/**
+ * Inlines the calls in the guards, invariants, synchronisations and
+ * updates of the templates of a type checked document, see
+ * inline_calls. The functions themselves are kept. Cached analyses of
+ * the document are dropped.
+ *
+ * Returns the calls replaced, for diagnostics.
+ */
+std::vector<inlining_t> inline_functions(Document& document, const inline_limits_t& limits = {});
+}  // namespace UTAP
+
+#endif /* UTAP_INLINER_H */
@@ -1,7 +1,10 @@
 #ifndef UTAP_LIBRARY_HPP
 #define UTAP_LIBRARY_HPP
 
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>  // move, swap
 
 namespace UTAP {
@@ -55,5 +58,36 @@ public:
     static const std::string& file_extension();
 };
 
+/// A library loaded once per process and shared by the documents importing it, with its symbols cached.
+/// The cache may be used from several threads, e.g. by documents evaluated or destroyed concurrently,
+/// but the parser is not reentrant, so models must still be parsed one at a time.
+class SharedLibrary
+{
+    Library library;
+    std::mutex mutex;
+    std::unordered_map<std::string, void*> symbols;
+    std::unordered_map<std::string, std::string> missing;  ///< Error messages of symbols not found
+
+public:
+    /// Wraps a library loaded outside the process-wide cache.
+    explicit SharedLibrary(Library&& library): library{std::move(library)} {}
+
+    /** Returns the library with specified name (path), loading it unless it is held already.
+     * Libraries are identified by their resolved path, names without a directory are searched by the OS.
+     * The library is unloaded when the last reference is dropped. Failures are cached as well and rethrown
+     * without probing the file system again, until clear_failures is called. The library is loaded
+     * without holding the cache lock, thus its constructors may load other libraries; when two threads
+     * load the same library at once, both succeed and one of the handles is closed again.
+     * Throws std::runtime_error upon errors.
+     */
+    static std::shared_ptr<SharedLibrary> load(const std::string& name);
+
+    /// Forgets the libraries which failed to load, e.g. after installing them.
+    static void clear_failures();
+
+    /// Finds the symbol in the library, looking it up once. Throws std::runtime_error upon errors.
+    void* get_symbol(const std::string& name);
+};
+
 }  // namespace UTAP
 #endif  // UTAP_LIBRARY_HPP
@@ -23,11 +23,16 @@
 #ifndef UTAP_POSITION
 #define UTAP_POSITION
 
+#include <deque>
 #include <iosfwd>
 #include <limits>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
+#include <cstdint>
 
 namespace UTAP {
 /** Records the absolute position in the source file.
@@ -61,53 +66,131 @@ struct position_t
  * the line numbers refer to the line number in the input file. In
  * essence, the whole input file is treated as if it were a single
  * XML element.
+ *
+ * Paths are interned: each distinct path is stored once and lines
+ * refer to it by a 32-bit id. Lines are stored delta-encoded in
+ * blocks, each block starting with an absolute checkpoint, so that
+ * find() is a binary search over the checkpoints followed by
+ * decoding of at most one block.
  */
 class position_index_t
 {
 public:
     struct line_t
     {
-        uint32_t position;
-        uint32_t offset;
-        uint32_t line;
-        std::shared_ptr<std::string> path;
-        line_t(uint32_t position, uint32_t offset, uint32_t line, std::shared_ptr<std::string> path):
-            position(position), offset(offset), line(line), path{std::move(path)}
+        uint32_t position{0};
+        uint32_t offset{0};
+        uint32_t line{0};
+        uint32_t path{0}; /**< Id of the path, @see get_path() */
+        line_t() = default;
+        line_t(uint32_t position, uint32_t offset, uint32_t line, uint32_t path):
+            position{position}, offset{offset}, line{line}, path{path}
         {}
     };
 
+    /** Byte range of the contents of an XML element in the original buffer. */
+    struct source_t
+    {
+        uint32_t offset{0};
+        uint32_t length{0};
+        /** Returns the raw (still escaped) element contents within the given buffer. */
+        std::string_view text(std::string_view buffer) const { return buffer.substr(offset, length); }
+    };
+
 private:
-    std::vector<line_t> lines;
-    const line_t& find(uint32_t position, uint32_t first, uint32_t last) const;
+    /** Number of lines per delta-encoded block. */
+    static constexpr uint32_t block_size = 64;
+    std::vector<line_t> checkpoints;    /**< The first line of each block, stored absolute. */
+    std::vector<uint32_t> block_starts; /**< Offset of each block into deltas. */
+    std::vector<uint8_t> deltas;        /**< Encoded lines following the checkpoints. */
+    line_t last{};                      /**< The most recently added line. */
+    size_t count{0};                    /**< Number of lines in the container. */
+    std::deque<std::string> paths;      /**< Interned paths, deque for stable references. */
+    std::unordered_map<std::string_view, uint32_t> path_ids;
+    std::vector<source_t> sources; /**< Source ranges indexed by path id, length no_source if unknown. */
+    static constexpr uint32_t no_source = std::numeric_limits<uint32_t>::max();
+
+    void encode(const line_t& line);
+    template <typename Fn>
+    void decode(size_t block, Fn&& fn) const;
 
 public:
+    /** Id of the empty path, used for non-XML input. */
+    static constexpr uint32_t no_path = 0;
+
+    position_index_t();
+
+    /** Stores the path (if new) and returns its id. */
+    uint32_t add_path(std::string_view path);
+
+    /** Returns the path with the given id. */
+    const std::string& get_path(uint32_t id) const { return paths[id]; }
+
+    /** Returns the number of distinct paths. */
+    size_t get_path_count() const { return paths.size(); }
+
+    /** Returns the id of the given path if it has been added. */
+    std::optional<uint32_t> find_path(std::string_view path) const;
+
+    /** Records the byte range of the XML element with the given path id. */
+    void set_source(uint32_t path, source_t source);
+
+    /** Returns the byte range of the XML element with the given path id, if known. */
+    std::optional<source_t> find_source(uint32_t path) const;
+
+    /** Returns the byte range of the XML element with the given XPath, if known. */
+    std::optional<source_t> find_source(std::string_view path) const;
+
     /** Add information about a line to the container. */
-    void add(uint32_t position, uint32_t offset, uint32_t line, std::shared_ptr<std::string> path);
+    void add(uint32_t position, uint32_t offset, uint32_t line, uint32_t path);
 
     /**
      * Retrieves information about the line containing the given
      * position. The last line in the container is considered to
      * extend to inifinity (until another line is added).
      */
-    const line_t& find(uint32_t position) const;
+    line_t find(uint32_t position) const;
+
+    /** Returns the number of lines in the container. */
+    size_t size() const { return count; }
+
+    /** Returns true if no lines have been added. */
+    bool empty() const { return count == 0; }
+
+    /** Returns the approximate number of bytes used by the line table (excluding paths). */
+    size_t memory_usage() const;
 
     /** Dump table to stdout. */
     std::ostream& print(std::ostream&) const;
 };
 
+/**
+ * An error or warning message. The line and column numbers are not
+ * stored, but resolved on demand from the position index of the
+ * document in which the message was reported.
+ */
 struct error_t
 {
     using line_t = position_index_t::line_t;
-    line_t start;
-    line_t end;
     position_t position;
     std::string msg;
     std::string context;
 
-    error_t(line_t start, line_t end, position_t pos, std::string msg, std::string ctx = {}):
-        start{std::move(start)}, end{std::move(end)}, position{pos}, msg{std::move(msg)}, context{std::move(ctx)}
+    error_t(std::shared_ptr<const position_index_t> index, position_t pos, std::string msg, std::string ctx = {}):
+        position{pos}, msg{std::move(msg)}, context{std::move(ctx)}, index{std::move(index)}
     {}
+    /** Returns the line containing the start of the message position. */
+    line_t get_start() const;
+    /** Returns the line containing the end of the message position. */
+    line_t get_end() const;
+    /** Returns the XPath of the element containing the start of the message position. */
+    const std::string& get_path() const;
+    /** Returns the byte range of the XML element containing the message, if known. */
+    std::optional<position_index_t::source_t> get_source() const;
     std::string str() const;
+
+private:
+    std::shared_ptr<const position_index_t> index;
 };
 }  // namespace UTAP
 
@@ -55,7 +55,8 @@ private:
 public:
     PrettyPrinter(std::ostream& stream);
 
-    void add_position(uint32_t position, uint32_t offset, uint32_t line, std::shared_ptr<std::string> path) override;
+    uint32_t add_path(std::string_view path) override;
+    void add_position(uint32_t position, uint32_t offset, uint32_t line, uint32_t path) override;
 
     void handle_error(const TypeException&) override;
     void handle_warning(const TypeException&) override;
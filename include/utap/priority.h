@@ -0,0 +1,99 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_PRIORITY_H
+#define UTAP_PRIORITY_H
+
+#include "utap/document.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace UTAP {
+/**
+ * The channel and process priorities of a type checked document
+ * resolved into flat tables of dense priority levels, 0 being the
+ * lowest, such that deciding which transitions are enabled under
+ * priorities needs no evaluation of the priority declarations.
+ *
+ * Global channels are numbered in the order of declaration, with
+ * arrays flattened row-major; the channel after the last one stands
+ * for edges without synchronisation (tau). Channels and elements not
+ * mentioned in a priority declaration, and tau, get the priority of
+ * default, which is the lowest level if default is not mentioned.
+ * Channel expressions of the declarations are statically indexable,
+ * as the type checker requires; an array, or a partially indexed
+ * array, sets the priority of all its elements.
+ *
+ * Processes are numbered in the order of Document::get_processes(),
+ * the elements of a process set share its priority.
+ */
+class PriorityTable
+{
+public:
+    explicit PriorityTable(Document& document);
+
+    /** Returns true if the document declares channel or process priorities. */
+    bool has_priorities() const { return priorities; }
+
+    /** Returns the number of the channel (element), nothing if it is not a global channel. */
+    std::optional<uint32_t> get_channel(const symbol_t& channel, int32_t element = 0) const;
+    /** Returns the channel number of edges without synchronisation. */
+    uint32_t get_tau() const { return static_cast<uint32_t>(channel_levels.size() - 1); }
+
+    uint32_t get_channel_priority(uint32_t channel) const { return channel_levels[channel]; }
+    uint32_t get_process_priority(size_t process) const { return process_levels[process]; }
+    /** Returns the priorities of the channels indexed by channel number, tau included. */
+    const std::vector<uint32_t>& get_channel_priorities() const { return channel_levels; }
+    /** Returns the priorities of the processes indexed by process number. */
+    const std::vector<uint32_t>& get_process_priorities() const { return process_levels; }
+
+    /** Returns the highest priority of the channels, e.g. of the enabled transitions, 0 if there are none. */
+    uint32_t max_channel_priority(const uint32_t* channels, size_t count) const
+    {
+        auto res = uint32_t{0};
+        for (size_t i = 0; i < count; ++i)
+            res = std::max(res, channel_levels[channels[i]]);
+        return res;
+    }
+    /** Returns the highest priority of the processes, 0 if there are none. */
+    uint32_t max_process_priority(const size_t* processes, size_t count) const
+    {
+        auto res = uint32_t{0};
+        for (size_t i = 0; i < count; ++i)
+            res = std::max(res, process_levels[processes[i]]);
+        return res;
+    }
+
+private:
+    bool priorities{false};
+    /** The first number and the number of elements of every global channel (array) */
+    std::map<symbol_t, std::pair<uint32_t, uint32_t>> channels;
+    std::vector<uint32_t> channel_levels;
+    std::vector<uint32_t> process_levels;
+};
+}  // namespace UTAP
+
+#endif /* UTAP_PRIORITY_H */
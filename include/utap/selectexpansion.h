@@ -0,0 +1,104 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_SELECTEXPANSION_H
+#define UTAP_SELECTEXPANSION_H
+
+#include "utap/document.h"
+
+#include <limits>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace UTAP {
+class ConstantEvaluator;
+
+/** An edge with its select variables bound to values, see SelectExpansion. */
+struct edge_instance_t
+{
+    const edge_t* edge;
+    std::vector<int32_t> values; /**< The values of the select variables, in the order of edge_t::select */
+    expression_t guard;          /**< Empty if true */
+    expression_t sync;
+    expression_t assign;
+};
+
+/**
+ * The bindings of the select variables of an edge: the product of
+ * their ranges, enumerated in lexicographic order with the last
+ * variable changing fastest. The number of bindings saturates at
+ * unbounded, in which case they cannot be enumerated.
+ */
+class select_bindings_t
+{
+public:
+    static constexpr size_t unbounded = std::numeric_limits<size_t>::max();
+
+    select_bindings_t() = default;
+    explicit select_bindings_t(std::vector<std::pair<int32_t, int32_t>> ranges);
+
+    /** Returns the number of bindings, or unbounded if it does not fit. */
+    size_t size() const { return count; }
+    /** Writes the values of the binding to values, one per select variable. */
+    void get(size_t index, int32_t* values) const;
+    const std::vector<std::pair<int32_t, int32_t>>& get_ranges() const { return ranges; }
+
+private:
+    std::vector<std::pair<int32_t, int32_t>> ranges; /**< Inclusive bounds per select variable */
+    std::vector<size_t> strides;                     /**< The index distance between consecutive values */
+    size_t count{1};
+};
+
+/**
+ * Expands the select variables of the edges of a template. Edges
+ * with at most threshold bindings are materialised into edge
+ * instances with the values substituted and the guard, synchronisation
+ * and update folded by fold_constants; instances whose guard is false
+ * are left out. Edges without select variables have one instance with
+ * their own expressions. Larger edges only get their binding table.
+ *
+ * Use the evaluator of an instance to expand selects whose range
+ * depends on template parameters, which are then folded as well.
+ * Throws std::logic_error if a select range is not computable.
+ */
+class SelectExpansion
+{
+public:
+    static constexpr size_t default_threshold = 256;
+
+    SelectExpansion(const template_t& templ, const ConstantEvaluator& evaluator,
+                    size_t threshold = default_threshold);
+
+    /** Returns true if the edge is materialised, false if it has too many bindings. */
+    bool is_expanded(const edge_t& edge) const { return instances.count(&edge) > 0; }
+    /** Returns the instances of an expanded edge whose guard may hold. */
+    const std::vector<edge_instance_t>& get_instances(const edge_t& edge) const { return instances.at(&edge); }
+    /** Returns the bindings of the select variables of the edge, a single empty binding without select. */
+    const select_bindings_t& get_bindings(const edge_t& edge) const { return bindings.at(&edge); }
+
+private:
+    std::map<const edge_t*, std::vector<edge_instance_t>> instances;
+    std::map<const edge_t*, select_bindings_t> bindings;
+};
+}  // namespace UTAP
+
+#endif /* UTAP_SELECTEXPANSION_H */
@@ -0,0 +1,73 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_SIMPLIFIER_H
+#define UTAP_SIMPLIFIER_H
+
+#include "utap/document.h"
+
+#include <string>
+#include <vector>
+
+namespace UTAP {
+class ConstantEvaluator;
+
+enum class simplification_kind_t {
+    Folded,             /**< An expression was replaced by a simpler one */
+    RemovedEdge,        /**< The guard of an edge is false */
+    UnreachableLocation /**< A location cannot be reached, its outgoing edges were removed */
+};
+
+/** A change made by simplify, located at the original expression. */
+struct simplification_t
+{
+    simplification_kind_t kind;
+    const template_t* templ;
+    position_t position;  /**< The position of the original expression, or of the location */
+    std::string original; /**< The original expression, or the name of the location */
+    std::string result;   /**< The simplified expression, empty for removals */
+};
+
+/**
+ * Folds the subexpressions which are computable at compile time, i.e.
+ * those ConstantEvaluator evaluates, and simplifies the boolean
+ * operators and conditional expressions around them. Returns the
+ * expression itself if nothing changed. Shared subexpressions are not
+ * modified; new nodes keep the position of the expression they
+ * replace.
+ */
+expression_t fold_constants(const expression_t& expr, const ConstantEvaluator& evaluator);
+
+/**
+ * Simplifies the templates of a type checked document: folds guards,
+ * invariants, synchronisations and updates, removes edges whose guard
+ * is false and the outgoing edges of locations which are no longer
+ * reachable from the initial location. The locations themselves are
+ * kept, as symbols and properties refer to them. Edges are renumbered.
+ * Template parameters are not evaluated, as the templates are shared
+ * by their processes. Cached analyses of the document are dropped.
+ *
+ * Returns the changes made, for diagnostics.
+ */
+std::vector<simplification_t> simplify(Document& document);
+}  // namespace UTAP
+
+#endif /* UTAP_SIMPLIFIER_H */
@@ -0,0 +1,90 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_SLICING_H
+#define UTAP_SLICING_H
+
+#include "utap/document.h"
+
+#include <set>
+#include <utility>
+
+namespace UTAP {
+/**
+ * The cone of influence of a property: the processes and variables
+ * which may influence whether the property holds. The property is the
+ * intermediate expression of a query, see PropInfo::intermediate.
+ *
+ * Variables are identified by the process owning them, nullptr for
+ * global variables, and their symbol in the template. A process is
+ * relevant if the property refers to it, if it may write a relevant
+ * variable, if it may synchronise on a relevant channel or if it has
+ * committed locations. Processes with invariants, urgent locations or
+ * synchronisations on urgent channels are relevant once a clock is.
+ * Within a relevant process all locations and edges are kept, guards,
+ * invariants and synchronisations are read, while only the updates
+ * writing relevant variables are. Properties using deadlock make every
+ * process relevant. Broadcast senders do not depend on their receivers.
+ *
+ * Only safety properties (E<> and A[]) are sliced: verifying them on
+ * the system restricted to the relevant processes, without the
+ * updates of irrelevant variables, gives the same result. Removing
+ * processes changes the maximal paths, thus for any other property,
+ * and for systems with priorities, the slice is complete, i.e. every
+ * process, variable and update is relevant.
+ */
+class Slice
+{
+public:
+    using variable_t = std::pair<const instance_t*, symbol_t>;
+
+    Slice(Document& document, const expression_t& property);
+
+    const std::set<const instance_t*>& get_processes() const { return processes; }
+    const std::set<variable_t>& get_variables() const { return variables; }
+
+    /** Returns true if the slice keeps the whole system. The variables are then not enumerated. */
+    bool is_complete() const { return complete; }
+    bool is_relevant(const instance_t& process) const { return processes.count(&process) > 0; }
+    /** Returns true if the variable, nullptr process for global variables, is relevant. */
+    bool is_relevant(const instance_t* process, const symbol_t& variable) const
+    {
+        return complete || variables.count({process, variable}) > 0;
+    }
+    /** Returns true if the update of the process, one element of an assignment list, must be kept. */
+    bool is_relevant_update(const instance_t& process, const expression_t& update) const;
+
+private:
+    std::set<const instance_t*> processes;
+    std::set<variable_t> variables;
+    bool has_clocks{false};
+    bool complete{false};
+
+    variable_t resolve(const instance_t* process, const symbol_t& symbol) const;
+    void use(const instance_t* process, const symbol_t& symbol);
+    void read(const expression_t& expr, const instance_t* process);
+    void members(const expression_t& expr);
+    bool writes(const expression_t& expr, const instance_t& process) const;
+    void add(const instance_t& process);
+};
+}  // namespace UTAP
+
+#endif /* UTAP_SLICING_H */
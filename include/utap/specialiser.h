@@ -0,0 +1,99 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_SPECIALISER_H
+#define UTAP_SPECIALISER_H
+
+#include "utap/document.h"
+
+#include <deque>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace UTAP {
+/** An edge of a residual template, see Specialiser. */
+struct residual_edge_t
+{
+    const edge_t* edge; /**< The edge of the template, for its locations, select and positions */
+    expression_t guard; /**< Empty if true */
+    expression_t sync;
+    expression_t assign;
+};
+
+/** The code of a template with the arguments of its processes substituted. */
+struct residual_template_t
+{
+    const template_t* templ;
+    std::vector<expression_t> invariants; /**< By location number, empty if true */
+    std::vector<residual_edge_t> edges;   /**< The edges which may be enabled, in template order */
+    size_t size{0};                       /**< The number of expression nodes */
+    bool generic{false};                  /**< The arguments were not substituted */
+};
+
+/**
+ * Specialises the templates to the processes of a type checked
+ * document. Constant and reference parameters are replaced by their
+ * arguments, after which array indices, conditionals and boolean
+ * operators are folded with fold_constants and edges whose guard is
+ * false are dropped. Unbound parameters of process sets and value
+ * parameters stay symbolic.
+ *
+ * Processes whose residual code is identical share it, e.g. when a
+ * parameter is only used by the declarations. A template gets at most
+ * limits_t::variants specialised residual templates and all of them
+ * together at most limits_t::size expression nodes; processes beyond
+ * the limits share the generic residual template of their template,
+ * where only global constants are folded.
+ */
+class Specialiser
+{
+public:
+    struct limits_t
+    {
+        size_t variants{std::numeric_limits<size_t>::max()}; /**< Residual templates per template */
+        size_t size{std::numeric_limits<size_t>::max()};     /**< Expression nodes in all specialised templates */
+    };
+
+    explicit Specialiser(Document& document): Specialiser{document, limits_t{}} {}
+    Specialiser(Document& document, limits_t limits);
+
+    /** Returns the residual template of the process, which must be one of the document. */
+    const residual_template_t& get(const instance_t& process) const { return *residuals.at(&process); }
+    /** Returns the residual templates, without duplicates. */
+    const std::deque<residual_template_t>& get_templates() const { return templates; }
+
+private:
+    limits_t limits;
+    size_t size{0}; /**< The expression nodes of the specialised templates */
+    std::deque<residual_template_t> templates;
+    std::map<const instance_t*, const residual_template_t*> residuals;
+    std::map<std::pair<const template_t*, std::string>, const residual_template_t*> shared;
+    std::map<const template_t*, size_t> variants;
+    std::map<const template_t*, const residual_template_t*> generic;
+
+    const residual_template_t& get_generic(const template_t& templ);
+    const residual_template_t* add(residual_template_t&& residual);
+};
+}  // namespace UTAP
+
+#endif /* UTAP_SPECIALISER_H */
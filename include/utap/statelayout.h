@@ -0,0 +1,124 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_STATELAYOUT_H
+#define UTAP_STATELAYOUT_H
+
+#include "utap/document.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace UTAP {
+class ValueRanges;
+
+/**
+ * A component of the state vector: the location of a process, an integer
+ * (element) of a variable or, for the clock valuation, a clock (element).
+ */
+struct layout_field_t
+{
+    std::string name;                   /**< e.g. P.location, P(1).x or a[1].f */
+    const instance_t* process{nullptr}; /**< The owning process (set), nullptr for global variables */
+    std::vector<int32_t> arguments;     /**< The values of the unbound parameters of a process set */
+    symbol_t symbol;                    /**< The variable, or the process for locations */
+    std::vector<int32_t> path;          /**< The array indices and record field numbers of the element */
+    int32_t lower{0};                   /**< Smallest value, stored as value - lower */
+    int32_t upper{0};                   /**< Largest value */
+    uint32_t width{0};                  /**< Bits needed for upper - lower */
+    uint32_t bit_offset{0};             /**< Offset in the packed layout */
+    uint32_t byte_offset{0};            /**< Offset in the byte aligned layout */
+    uint32_t bytes{0};                  /**< Alignment class: 1, 2 or 4 bytes, 0 if there is a single value */
+};
+
+/**
+ * Plans the layout of the discrete part of the state vector of the
+ * instantiated system: one field for the location of each process
+ * and one for each integer or boolean of the global and process local
+ * variables, including the by-value parameters which are not constant,
+ * with arrays and records flattened. Constants are not
+ * stored, neither are clocks, which get an index in the clock
+ * valuation instead (index 0 is the reference clock). A process set,
+ * i.e. a process with unbound parameters, is expanded into one process
+ * per combination of arguments. Dynamically spawned processes are not
+ * part of the layout.
+ *
+ * The fields keep the order of the declarations in the unpacked
+ * state, which is an array of int32_t with one value per field. Two
+ * compact representations are provided:
+ * - packed: each field takes the bits needed for its range, fields
+ *   are placed first fit decreasing into 64 bit words such that no
+ *   field straddles two words.
+ * - byte aligned: each field takes 1, 2 or 4 bytes, sorted by
+ *   decreasing alignment class such that every field is naturally
+ *   aligned and no padding is needed between fields.
+ * Fields with a single value take no space. Values must be within the
+ * range of their field when packed. Documents with double variables, or
+ * other variables without a computable range, are rejected with
+ * std::logic_error.
+ */
+class StateLayout
+{
+public:
+    /**
+     * Plans the layout from the declared ranges of the type checked
+     * document, or from the ranges computed by the value range analysis
+     * when given, which may be tighter.
+     */
+    explicit StateLayout(Document& document, const ValueRanges* ranges = nullptr);
+
+    const std::vector<layout_field_t>& get_fields() const { return fields; }
+    /** Returns the clocks in the order of their index in the clock valuation, starting from index 1. */
+    const std::vector<layout_field_t>& get_clocks() const { return clocks; }
+    /** Returns the number of 64 bit words of a packed state. */
+    size_t get_packed_words() const { return packed_words; }
+    /** Returns the number of bytes of a byte aligned state, a multiple of its largest alignment. */
+    size_t get_aligned_bytes() const { return aligned_bytes; }
+
+    /** Packs the values of all fields into get_packed_words() words. */
+    void pack(const int32_t* values, uint64_t* packed) const;
+    /** Unpacks a packed state into one value per field. */
+    void unpack(const uint64_t* packed, int32_t* values) const;
+    /** Stores the values of all fields into get_aligned_bytes() bytes. */
+    void pack_aligned(const int32_t* values, uint8_t* aligned) const;
+    /** Loads a byte aligned state into one value per field. */
+    void unpack_aligned(const uint8_t* aligned, int32_t* values) const;
+
+    /** Reads a single field of a packed state. */
+    int32_t get(const uint64_t* packed, size_t field) const;
+    /** Writes a single field of a packed state. */
+    void set(uint64_t* packed, size_t field, int32_t value) const;
+
+    /** Returns the arguments of every element of a process set, a single empty list for other processes. */
+    static std::vector<std::vector<int32_t>> enumerate_arguments(const instance_t& process);
+
+private:
+    std::vector<layout_field_t> fields;
+    std::vector<layout_field_t> clocks;
+    size_t packed_words{0};
+    size_t aligned_bytes{0};
+
+    void plan();
+};
+}  // namespace UTAP
+
+#endif /* UTAP_STATELAYOUT_H */
@@ -24,8 +24,11 @@
 
 #include "utap/document.h"
 #include "utap/expression.h"
+#include "utap/external.h"
 #include "utap/symbols.h"
 
+#include <optional>
+
 #define INDENT "\t"
 
 namespace UTAP {
@@ -157,14 +160,18 @@ public:
 class ExternalBlockStatement : public BlockStatement
 {
 public:
-    ExternalBlockStatement(frame_t frame, void* fp, bool ret): BlockStatement{frame}, functionptr{fp}, doesReturn{ret}
+    ExternalBlockStatement(frame_t frame, void* fp, bool ret, std::optional<ExternalFunction> invoker = {}):
+        BlockStatement{frame}, functionptr{fp}, doesReturn{ret}, invoker{std::move(invoker)}
     {}
     bool returns() override;
     void* getFP() { return functionptr; }
+    /** Returns the typed invoker of the function, nullptr if the symbol is missing or the signature unsupported. */
+    const ExternalFunction* get_invoker() const { return invoker ? &*invoker : nullptr; }
 
 private:
     void* functionptr;
     bool doesReturn;
+    std::optional<ExternalFunction> invoker;
 };
 
 class SwitchStatement : public BlockStatement
@@ -282,6 +289,8 @@ public:
 
 class ExpressionVisitor : public AbstractStatementVisitor
 {
+    friend class ExpressionVisitorPipeline;
+
 protected:
     virtual void visitExpression(expression_t) = 0;
 
@@ -329,5 +338,16 @@ public:
     explicit CollectDynamicExpressions(std::list<expression_t>& expressions): expressions{expressions} {}
 };
 
+/** Hands every expression of a single statement traversal to several expression visitors. */
+class ExpressionVisitorPipeline : public ExpressionVisitor
+{
+protected:
+    std::vector<ExpressionVisitor*> visitors;
+    void visitExpression(expression_t) override;
+
+public:
+    ExpressionVisitorPipeline(std::initializer_list<ExpressionVisitor*> visitors): visitors{visitors} {}
+};
+
 }  // namespace UTAP
 #endif /* UTAP_STATEMENT_H */
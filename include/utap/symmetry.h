@@ -0,0 +1,130 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_SYMMETRY_H
+#define UTAP_SYMMETRY_H
+
+#include "utap/document.h"
+#include "utap/statelayout.h"
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace UTAP {
+/** A scalarset and the parts of the system which are permuted together with its elements. */
+struct scalarset_t
+{
+    std::string name;                         /**< The name of the typedef, if any */
+    int32_t size{0};                          /**< The number of elements */
+    std::vector<const instance_t*> processes; /**< Process sets with an unbound parameter of the scalarset */
+    std::vector<symbol_t> arrays;             /**< Variables with an array dimension of the scalarset */
+    std::vector<symbol_t> values;             /**< Variables holding elements of the scalarset */
+};
+
+/**
+ * Identifies the global scalarsets of a type checked document. The
+ * type checker ensures that elements of a scalarset are only compared
+ * for equality, assigned and used as array indices, thus every
+ * permutation of the elements maps a state to an equivalent state,
+ * provided the elements are permuted consistently in the process sets,
+ * arrays and variables listed for the scalarset. Scalarsets declared
+ * in templates are local to each process and are not reported.
+ */
+class Symmetry
+{
+public:
+    explicit Symmetry(Document& document);
+
+    const std::vector<scalarset_t>& get_scalarsets() const { return scalarsets; }
+    /** Returns the index of the scalarset of the type, nothing if it is not a global scalarset type. */
+    std::optional<size_t> find(const type_t& type) const;
+
+private:
+    std::vector<scalarset_t> scalarsets;
+    std::map<std::string, size_t> index; /**< Internal scalarset label to index */
+
+    std::optional<size_t> add(const type_t& type);
+    void collect(const symbol_t& variable, const type_t& type);
+};
+
+/**
+ * Maps states of a StateLayout to a representative of their symmetry
+ * class. For each scalarset in turn the elements are sorted by the
+ * values of the fields indexed by them (array elements and process set
+ * elements), then the fields are permuted accordingly and the values of
+ * variables of the scalarset are renamed. States mapped to the same
+ * representative are equivalent, while equivalent states may still
+ * have different representatives, e.g. if they differ in elements
+ * indexed twice by the same scalarset.
+ */
+class Canonicaliser
+{
+public:
+    Canonicaliser(const Symmetry& symmetry, const StateLayout& layout);
+
+    /**
+     * Replaces the packed state by its representative. If clocks is
+     * given, it receives for every clock index of the representative
+     * the clock index in the original state, index 0 being the
+     * reference clock, to permute the clock valuation the same way.
+     */
+    void canonicalise(uint64_t* packed, std::vector<uint32_t>* clocks = nullptr) const;
+
+private:
+    using key_t = std::tuple<const instance_t*, std::vector<int32_t>, symbol_t, std::vector<int32_t>>;
+
+    /** The positions in the arguments and in the path of a field which are elements of one scalarset. */
+    struct coordinates_t
+    {
+        std::vector<size_t> arguments;
+        std::vector<size_t> path;
+        size_t count() const { return arguments.size() + path.size(); }
+    };
+    struct shared_t
+    {
+        size_t index;
+        coordinates_t coordinates;
+    };
+    /** How the fields and clocks are permuted with the elements of one scalarset. */
+    struct permutation_t
+    {
+        std::vector<std::vector<size_t>> blocks;       /**< Per element: the fields indexed by it exactly once */
+        std::vector<std::vector<size_t>> clock_blocks; /**< Per element: the clocks indexed by it exactly once */
+        std::vector<shared_t> shared;                  /**< Fields indexed several times by the scalarset */
+        std::vector<shared_t> shared_clocks;           /**< Clocks indexed several times by the scalarset */
+        std::vector<size_t> renamed;                   /**< Fields holding an element of the scalarset */
+    };
+
+    const StateLayout& layout;
+    std::vector<permutation_t> permutations;
+    std::map<key_t, size_t> field_keys;
+    std::map<key_t, size_t> clock_keys;
+
+    static size_t move(const std::map<key_t, size_t>& keys, const layout_field_t& field,
+                       const coordinates_t& coordinates, const std::vector<int32_t>& rename);
+};
+}  // namespace UTAP
+
+#endif /* UTAP_SYMMETRY_H */
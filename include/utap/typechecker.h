@@ -44,6 +44,7 @@ private:
 public:
     void visitVariable(variable_t&) override;
     void visitInstance(instance_t&) override;
+    bool visitTemplateBefore(template_t&) override;
     void add_symbol(symbol_t);
     bool contains(symbol_t) const;
 };
@@ -51,8 +52,8 @@ public:
 /**
  * A visitor which type checks the document it visits.  The type
  * checker can only visit the document given in the constructor. The
- * type checker must not be constructed before the document has been
- * parsed.
+ * type checker must not be constructed (or, when registered with a
+ * pipeline, run) before the document has been parsed.
  */
 class TypeChecker : public DocumentVisitor, public AbstractStatementVisitor
 {
@@ -61,6 +62,7 @@ private:
     CompileTimeComputableValues compileTimeComputableValues;
     function_t* function; /**< Current function being type checked. */
     bool refinementWarnings;
+    bool deferUpdates{false}; /**< Check the system wide updates in visitDocAfter. */
 
     template <class T>
     void handleError(T, const std::string&);
@@ -88,9 +90,13 @@ private:
 public:
     static bool areEquivalent(type_t, type_t);
     explicit TypeChecker(Document& doc, bool refinement = false);
+    /** Registers the checker with the pipeline instead of traversing the document on its own. */
+    TypeChecker(Document& doc, DocumentVisitorPipeline& pipeline, bool refinement = false);
     void visitTemplateAfter(template_t&) override;
     bool visitTemplateBefore(template_t&) override;
     void visitDocAfter(Document&) override;
+    /** Stops the traversal once the error budget of the document is exceeded. */
+    bool isDone() const override { return document.is_truncated(); }
     void visitVariable(variable_t&) override;
     void visitLocation(location_t&) override;
     void visitEdge(edge_t&) override;
@@ -117,7 +123,7 @@ public:
     int32_t visitIfStatement(IfStatement* stat) override;
     int32_t visitReturnStatement(ReturnStatement* stat) override;
 
-    bool checkDynamicExpressions(Statement* stat);
+    bool checkDynamicExpressions(const std::list<expression_t>& dynamic);
     /** Type check an expression */
     bool checkExpression(expression_t);
     bool checkSpawnParameterCompatible(type_t param, expression_t arg);
@@ -30,15 +30,85 @@
 #include "utap/symbols.h"
 
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <vector>
 
-bool parse_XTA(FILE*, UTAP::Document*, bool newxta);
-bool parse_XTA(const char* buffer, UTAP::Document*, bool newxta);
+/*
+ * The optional error budget overrides the one set on the document. When
+ * it is exceeded, parsing and type checking stop early, the document
+ * reports is_truncated() and the XML functions return PARSE_TRUNCATED.
+ */
+bool parse_XTA(FILE*, UTAP::Document*, bool newxta, std::optional<UTAP::error_budget_t> budget = {});
+bool parse_XTA(const char* buffer, UTAP::Document*, bool newxta, std::optional<UTAP::error_budget_t> budget = {});
 int32_t parse_XML_buffer(const char* buffer, UTAP::Document*, bool newxta,
-                         const std::vector<std::filesystem::path>& libpaths = {});
+                         const std::vector<std::filesystem::path>& libpaths = {},
+                         std::optional<UTAP::error_budget_t> budget = {});
 int32_t parse_XML_file(const char* buffer, UTAP::Document*, bool newxta,
-                       const std::vector<std::filesystem::path>& libpaths = {});
-int32_t parse_XML_fd(int fd, UTAP::Document*, bool newxta, const std::vector<std::filesystem::path>& libpaths = {});
+                       const std::vector<std::filesystem::path>& libpaths = {},
+                       std::optional<UTAP::error_budget_t> budget = {});
+int32_t parse_XML_fd(int fd, UTAP::Document*, bool newxta, const std::vector<std::filesystem::path>& libpaths = {},
+                     std::optional<UTAP::error_budget_t> budget = {});
+/**
+ * Decodes the character and entity references, CDATA sections and line ends of raw
+ * XML element contents, e.g. the text of a Document::find_source() range.
+ */
+std::string unescape_XML(std::string_view text);
+namespace UTAP {
+class ParserBuilder;
+
+/**
+ * Parses an XML model pushed in chunks, e.g. as it arrives over a pipe.
+ * The chunks are handed to the libxml2 push parser by feed(), which
+ * then drives the ParserBuilder callbacks for every element of the
+ * project which is complete, thus global declarations are parsed (and
+ * type checked by the Document constructor) while later templates are
+ * still in flight. All callbacks run on the thread calling feed() and
+ * finish(). Like the other parse functions, no other model may be
+ * parsed concurrently.
+ */
+class XMLModelStream
+{
+public:
+    /** Reports the model to the given builder. */
+    XMLModelStream(ParserBuilder& builder, bool newxta);
+    /**
+     * Builds the document and type checks the global declarations as
+     * soon as they are complete, the rest of the static analysis runs
+     * in finish() like in parse_XML_buffer.
+     */
+    XMLModelStream(Document& doc, bool newxta, const std::vector<std::filesystem::path>& libpaths = {},
+                   std::optional<error_budget_t> budget = {});
+    XMLModelStream(const XMLModelStream&) = delete;
+    XMLModelStream& operator=(const XMLModelStream&) = delete;
+    /** Aborts the parsing unless finish() has been called, the builder is not told that the model is done. */
+    ~XMLModelStream();
+
+    /** Appends the next chunk of the XML document. */
+    void feed(const char* data, size_t size);
+    /**
+     * Marks the end of the input and parses the rest of the model.
+     * Returns the same status as parse_XML_buffer and rethrows its
+     * exceptions, also those raised while parsing in feed().
+     */
+    int32_t finish();
+
+private:
+    /** Called once the global declarations are parsed and once the whole input is parsed */
+    struct hooks_t
+    {
+        std::function<void()> on_globals;
+        std::function<int32_t(int32_t)> on_finish;
+    };
+    struct state_t;
+    std::unique_ptr<state_t> state;
+    XMLModelStream(std::unique_ptr<ParserBuilder> builder, bool newxta, hooks_t hooks);
+};
+}  // namespace UTAP
+
 UTAP::expression_t parse_expression(const char* buffer, UTAP::Document*, bool);
 int32_t write_XML_file(const char* filename, UTAP::Document* doc);
 
@@ -0,0 +1,75 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#ifndef UTAP_VALUERANGES_H
+#define UTAP_VALUERANGES_H
+
+#include "utap/document.h"
+#include "utap/range.h"
+
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace UTAP {
+/**
+ * Interval analysis of the integer and boolean variables of a type
+ * checked document. The values a variable may take in any reachable
+ * state are over-approximated by a single range, starting from the
+ * initialisers and following the guards and updates of all edges,
+ * including the bodies of the functions they call. Guards on integers
+ * narrow the ranges of the variables they compare, e.g. an edge with
+ * the guard i < N and the update i++ keeps i within [0,N].
+ *
+ * The analysis is flow insensitive with respect to locations, i.e. a
+ * variable has the same range in all locations. The elements of an
+ * array share one range. Records, clocks and doubles are not analysed.
+ * Local variables of templates are joined over all processes.
+ */
+class ValueRanges
+{
+public:
+    using range_type = range_t<int32_t>;
+
+    /** An assignment whose value is never within the declared range of the variable. */
+    struct violation_t
+    {
+        expression_t expr;   /**< The assignment */
+        range_type value;    /**< The values which may be assigned */
+        range_type declared; /**< The declared range of the variable */
+    };
+
+    explicit ValueRanges(Document& document);
+
+    /** Returns the values the variable may take, nothing if the variable is not analysed. */
+    std::optional<range_type> get_range(const symbol_t& variable) const;
+    /** Returns the ranges of all analysed global and template variables. */
+    const std::map<symbol_t, range_type>& get_ranges() const { return ranges; }
+    /** Returns the assignments which fail whenever they are executed. */
+    const std::vector<violation_t>& get_violations() const { return violations; }
+
+private:
+    std::map<symbol_t, range_type> ranges;
+    std::vector<violation_t> violations;
+};
+}  // namespace UTAP
+
+#endif /* UTAP_VALUERANGES_H */
@@ -69,10 +69,16 @@ ExpressionBuilder::ExpressionBuilder(Document& doc): document{doc}
     scalar_count = 0;
 }
 
-void ExpressionBuilder::add_position(uint32_t position, uint32_t offset, uint32_t line,
-                                     std::shared_ptr<std::string> path)
+uint32_t ExpressionBuilder::add_path(std::string_view path) { return document.add_path(path); }
+
+void ExpressionBuilder::add_position(uint32_t position, uint32_t offset, uint32_t line, uint32_t path)
+{
+    document.add_position(position, offset, line, path);
+}
+
+void ExpressionBuilder::set_source(uint32_t path, uint32_t offset, uint32_t length)
 {
-    document.add_position(position, offset, line, std::move(path));
+    document.set_source(path, offset, length);
 }
 
 void ExpressionBuilder::handle_error(const TypeException& ex) { document.add_error(position, ex.what()); }
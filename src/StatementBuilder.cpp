@@ -416,7 +416,7 @@ void StatementBuilder::dynamic_load_lib(const char* lib)
     for (const auto& dir : libpaths) {
         auto path = dir / name;
         try {
-            document.add(Library{path.string().c_str()});
+            document.add(SharedLibrary::load(path.string()));
             success = true;
             break;
         } catch (const std::runtime_error& ex) {
@@ -457,7 +457,16 @@ void StatementBuilder::decl_external_func(const char* name, const char* alias)
     }
     push_frame(frame_t::create(frames.top()));
     params.move_to(frames.top());  // params is emptied here
-    currentFun->body = std::make_unique<ExternalBlockStatement>(frames.top(), fp, !return_type.is_void());
+    auto invoker = std::optional<ExternalFunction>{};
+    if (fp != nullptr) {
+        try {
+            invoker.emplace(fp, type);
+        } catch (const std::logic_error&) {
+            // consumers derive the calling convention from the type themselves
+        }
+    }
+    currentFun->body =
+        std::make_unique<ExternalBlockStatement>(frames.top(), fp, !return_type.is_void(), std::move(invoker));
     decl_func_end();
 }
 
@@ -0,0 +1,252 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/activeclocks.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+using namespace UTAP;
+using namespace Constants;
+
+using clocks_t = ActiveClocks::clocks_t;
+
+static bool is_clock(const symbol_t& symbol) { return symbol.get_type().strip_array().is_clock(); }
+
+/** Collects the clocks whose values the expression may read. Rates do not read the clock. */
+static void collect_reads(const expression_t& expr, clocks_t& clocks)
+{
+    if (expr.empty() || expr.get_kind() == RATE)
+        return;
+    switch (expr.get_kind()) {
+    case IDENTIFIER:
+        if (is_clock(expr.get_symbol()))
+            clocks.insert(expr.get_symbol());
+        return;
+    case FUN_CALL:
+    case FUN_CALL_EXT: {
+        auto symbol = expr[0].get_symbol();
+        if ((symbol.get_type().is_function() || symbol.get_type().is_function_external()) && symbol.get_data()) {
+            for (const auto& read : static_cast<const function_t*>(symbol.get_data())->depends)
+                if (is_clock(read))
+                    clocks.insert(read);
+        }
+        for (uint32_t i = 1; i < expr.get_size(); ++i)
+            collect_reads(expr[i], clocks);
+        return;
+    }
+    default:
+        for (uint32_t i = 0; i < expr.get_size(); ++i)
+            collect_reads(expr[i], clocks);
+    }
+}
+
+namespace {
+/** A single effect of an edge: the clocks read followed by the clocks assigned. */
+struct step_t
+{
+    clocks_t reads;
+    clocks_t assigned;
+};
+
+/** The effect of an edge on the active clocks: active = gen + (active of target - kill) */
+struct transfer_t
+{
+    clocks_t gen;
+    clocks_t kill;
+    std::vector<step_t> steps;
+
+    /** Appends an effect taking place after the effects so far. */
+    void then(const clocks_t& reads, const clocks_t& assigned)
+    {
+        for (const auto& clock : reads)
+            if (kill.count(clock) == 0)
+                gen.insert(clock);
+        kill.insert(assigned.begin(), assigned.end());
+        steps.push_back({reads, assigned});
+    }
+
+    void sequence(const expression_t& expr)
+    {
+        if (expr.empty())
+            return;
+        auto reads = clocks_t{};
+        if (expr.get_kind() == COMMA) {
+            sequence(expr[0]);
+            sequence(expr[1]);
+        } else if (expr.get_kind() == ASSIGN && expr[0].get_kind() == IDENTIFIER && is_clock(expr[0].get_symbol())) {
+            collect_reads(expr[1], reads);
+            then(reads, {expr[0].get_symbol()});
+        } else {
+            collect_reads(expr, reads);
+            then(reads, {});
+        }
+    }
+
+    bool apply(const clocks_t& target, clocks_t& source) const
+    {
+        auto size = source.size();
+        source.insert(gen.begin(), gen.end());
+        for (const auto& clock : target)
+            if (kill.count(clock) == 0)
+                source.insert(clock);
+        return source.size() != size;
+    }
+
+    /**
+     * Adds the clocks active at every point within the edge to points
+     * given the clocks active in the target. An assigned clock is
+     * counted together with the clocks active after the assignment.
+     */
+    void within(const clocks_t& target, std::vector<clocks_t>& points) const
+    {
+        auto clocks = target;
+        for (auto step = steps.rbegin(); step != steps.rend(); ++step) {
+            if (!step->assigned.empty()) {
+                auto& point = points.emplace_back(clocks);
+                point.insert(step->assigned.begin(), step->assigned.end());
+                for (const auto& clock : step->assigned)
+                    clocks.erase(clock);
+            }
+            auto size = clocks.size();
+            clocks.insert(step->reads.begin(), step->reads.end());
+            if (clocks.size() != size)
+                points.push_back(clocks);
+        }
+    }
+};
+}  // namespace
+
+void ActiveClocks::analyse(const template_t& templ, const clocks_t& always)
+{
+    // Nodes are the locations followed by the branchpoints
+    auto nodes = std::unordered_map<const void*, size_t>{};
+    for (const auto& location : templ.locations)
+        nodes.emplace(&location, nodes.size());
+    for (const auto& branchpoint : templ.branchpoints)
+        nodes.emplace(&branchpoint, nodes.size());
+    auto node = [&nodes](const location_t* location, const branchpoint_t* branchpoint) {
+        return nodes.at(location ? static_cast<const void*>(location) : branchpoint);
+    };
+
+    auto live = std::vector<clocks_t>(nodes.size(), always);
+    for (const auto& location : templ.locations)
+        collect_reads(location.invariant, live[node(&location, nullptr)]);
+
+    struct arc_t
+    {
+        size_t source;
+        transfer_t transfer;
+    };
+    auto incoming = std::vector<std::vector<arc_t>>(nodes.size());
+    for (const auto& edge : templ.edges) {
+        auto& arc = incoming[node(edge.dst, edge.dstb)].emplace_back(arc_t{node(edge.src, edge.srcb), {}});
+        auto reads = clocks_t{};
+        collect_reads(edge.guard, reads);
+        collect_reads(edge.sync, reads);
+        collect_reads(edge.prob, reads);
+        arc.transfer.then(reads, {});
+        arc.transfer.sequence(edge.assign);
+    }
+
+    auto waiting = std::vector<size_t>(nodes.size());
+    for (size_t i = 0; i < waiting.size(); ++i)
+        waiting[i] = i;
+    while (!waiting.empty()) {
+        auto target = waiting.back();
+        waiting.pop_back();
+        for (const auto& arc : incoming[target])
+            if (arc.transfer.apply(live[target], live[arc.source]))
+                waiting.push_back(arc.source);
+    }
+
+    auto& template_used = used[&templ];
+    for (const auto& location : templ.locations) {
+        const auto& clocks = live[node(&location, nullptr)];
+        active[&location] = clocks;
+        template_used.insert(clocks.begin(), clocks.end());
+    }
+    for (const auto& branchpoint : templ.branchpoints) {
+        const auto& clocks = live[node(nullptr, &branchpoint)];
+        template_used.insert(clocks.begin(), clocks.end());
+    }
+
+    // Clocks interfere if they are active at the same point: a location, a branchpoint or within an edge
+    auto points = live;
+    for (size_t target = 0; target < incoming.size(); ++target)
+        for (const auto& arc : incoming[target])
+            arc.transfer.within(live[target], points);
+
+    // Greedy colouring of the local clocks
+    auto local = std::vector<symbol_t>{};
+    for (uint32_t i = 0; i < templ.frame.get_size(); ++i)
+        if (is_clock(templ.frame[i]) && !templ.parameters.contains(templ.frame[i]))
+            local.push_back(templ.frame[i]);
+    auto& template_classes = classes[&templ];
+    for (const auto& clock : local) {
+        auto interferes = [&](const std::vector<symbol_t>& members) {
+            return std::any_of(points.begin(), points.end(), [&](const clocks_t& clocks) {
+                return clocks.count(clock) > 0 && std::any_of(members.begin(), members.end(), [&](auto& member) {
+                           return clocks.count(member) > 0;
+                       });
+            });
+        };
+        auto it = std::find_if_not(template_classes.begin(), template_classes.end(), interferes);
+        if (it == template_classes.end())
+            template_classes.push_back({clock});
+        else
+            it->push_back(clock);
+    }
+}
+
+ActiveClocks::ActiveClocks(Document& document)
+{
+    auto always = clocks_t{};
+    collect_reads(document.get_before_update(), always);
+    collect_reads(document.get_after_update(), always);
+    for (const auto& templ : document.get_templates())
+        if (templ.is_TA)
+            analyse(templ, always);
+    for (const auto* templ : document.get_dynamic_templates())
+        if (templ->is_TA)
+            analyse(*templ, always);
+}
+
+const clocks_t& ActiveClocks::get_active(const location_t& location) const
+{
+    static const auto empty = clocks_t{};
+    auto it = active.find(&location);
+    return it != active.end() ? it->second : empty;
+}
+
+const clocks_t& ActiveClocks::get_used(const template_t& templ) const
+{
+    static const auto empty = clocks_t{};
+    auto it = used.find(&templ);
+    return it != used.end() ? it->second : empty;
+}
+
+const ActiveClocks::classes_t& ActiveClocks::get_classes(const template_t& templ) const
+{
+    static const auto empty = classes_t{};
+    auto it = classes.find(&templ);
+    return it != classes.end() ? it->second : empty;
+}
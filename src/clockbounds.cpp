@@ -0,0 +1,285 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/clockbounds.h"
+
+#include "utap/evaluator.h"
+
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+using namespace UTAP;
+using namespace Constants;
+
+bool clock_bound_t::join(const clock_bound_t& other)
+{
+    auto joined = clock_bound_t{std::max(lower, other.lower), std::max(upper, other.upper)};
+    if (joined == *this)
+        return false;
+    *this = joined;
+    return true;
+}
+
+/** Returns true if the expression denotes a clock or an element of a clock array. */
+static bool is_clock_term(const expression_t& expr)
+{
+    return (expr.get_kind() == IDENTIFIER || expr.get_kind() == ARRAY) && expr.get_type().is_clock();
+}
+
+/** Collects the clocks occurring in the expression, rates excluded. */
+static void collect_clocks(const expression_t& expr, std::set<symbol_t>& clocks)
+{
+    if (expr.empty() || expr.get_kind() == RATE)
+        return;
+    if (is_clock_term(expr)) {
+        clocks.insert(expr.get_symbol());
+        return;
+    }
+    for (uint32_t i = 0; i < expr.get_size(); ++i)
+        collect_clocks(expr[i], clocks);
+}
+
+namespace {
+/** Collects the bounds of the clock constraints in expressions evaluated in the context of one process. */
+class BoundCollector
+{
+    const ConstantEvaluator& evaluator;
+    bool& diagonals;
+
+    int32_t upper_value(const expression_t& expr) const
+    {
+        return evaluator.evaluate_upper(expr).value_or(clock_bound_t::infinity);
+    }
+
+    static void add(clock_bounds_t& bounds, symbol_t clock, kind_t op, int32_t value)
+    {
+        auto bound = clock_bound_t{};
+        if (op != LT && op != LE)
+            bound.lower = value;
+        if (op != GT && op != GE)
+            bound.upper = value;
+        bounds[clock].join(bound);
+    }
+
+    static kind_t mirror(kind_t op)
+    {
+        switch (op) {
+        case LT: return GT;
+        case LE: return GE;
+        case GT: return LT;
+        case GE: return LE;
+        default: return op;
+        }
+    }
+
+    void comparison(kind_t op, const expression_t& left, const expression_t& right, clock_bounds_t& bounds)
+    {
+        if (left.get_kind() == RATE || right.get_kind() == RATE)
+            return;
+        auto left_clocks = std::set<symbol_t>{};
+        auto right_clocks = std::set<symbol_t>{};
+        collect_clocks(left, left_clocks);
+        collect_clocks(right, right_clocks);
+        if (left_clocks.empty() && right_clocks.empty())
+            return;
+        if (is_clock_term(left) && right_clocks.empty()) {
+            add(bounds, left.get_symbol(), op, upper_value(right));
+        } else if (is_clock_term(right) && left_clocks.empty()) {
+            add(bounds, right.get_symbol(), mirror(op), upper_value(left));
+        } else if (left.get_kind() == MINUS && is_clock_term(left[0]) && is_clock_term(left[1]) &&
+                   right_clocks.empty()) {
+            diagonals = true;
+            auto value = evaluator.evaluate(right);
+            auto constant = value ? std::max(*value, -*value) : clock_bound_t::infinity;
+            for (const auto& clock : left_clocks)
+                bounds[clock].join({constant, constant});
+        } else {
+            // not a simple or difference constraint: give up on the clocks involved
+            left_clocks.insert(right_clocks.begin(), right_clocks.end());
+            for (const auto& clock : left_clocks)
+                bounds[clock].join({clock_bound_t::infinity, clock_bound_t::infinity});
+        }
+    }
+
+public:
+    BoundCollector(const ConstantEvaluator& evaluator, bool& diagonals): evaluator{evaluator}, diagonals{diagonals} {}
+
+    void collect(const expression_t& expr, clock_bounds_t& bounds)
+    {
+        if (expr.empty())
+            return;
+        switch (expr.get_kind()) {
+        case RATE: return;
+        case LT:
+        case LE:
+        case EQ:
+        case NEQ:
+        case GE:
+        case GT: comparison(expr.get_kind(), expr[0], expr[1], bounds); return;
+        default:
+            for (uint32_t i = 0; i < expr.get_size(); ++i)
+                collect(expr[i], bounds);
+        }
+    }
+};
+
+/** Describes how the clock bounds of the target of an edge carry over to its source. */
+struct transfer_t
+{
+    std::set<symbol_t> resets;                        /**< Clocks which are assigned a constant */
+    std::vector<std::pair<symbol_t, symbol_t>> copies; /**< Assignments x = e: the bounds of x apply to clocks of e */
+};
+
+void collect_transfer(const expression_t& expr, const ConstantEvaluator& evaluator, transfer_t& transfer)
+{
+    if (expr.empty())
+        return;
+    if (expr.get_kind() == COMMA) {
+        collect_transfer(expr[0], evaluator, transfer);
+        collect_transfer(expr[1], evaluator, transfer);
+    } else if (expr.get_kind() == ASSIGN && expr[0].get_kind() == IDENTIFIER && expr[0].get_type().is_clock()) {
+        auto clock = expr[0].get_symbol();
+        auto from = std::set<symbol_t>{};
+        collect_clocks(expr[1], from);
+        if (from.empty() && evaluator.evaluate(expr[1]))
+            transfer.resets.insert(clock);
+        for (const auto& source : from)
+            transfer.copies.emplace_back(clock, source);
+    }
+}
+}  // namespace
+
+void ClockBounds::analyse(const template_t& templ, const instance_t* process, bool in_system)
+{
+    auto evaluator = process ? ConstantEvaluator{*process} : ConstantEvaluator{};
+    auto collector = BoundCollector{evaluator, diagonals};
+
+    // Nodes are the locations followed by the branchpoints
+    auto nodes = std::unordered_map<const void*, size_t>{};
+    for (const auto& location : templ.locations)
+        nodes.emplace(&location, nodes.size());
+    for (const auto& branchpoint : templ.branchpoints)
+        nodes.emplace(&branchpoint, nodes.size());
+    auto node = [&nodes](const location_t* location, const branchpoint_t* branchpoint) {
+        return nodes.at(location ? static_cast<const void*>(location) : branchpoint);
+    };
+
+    auto bounds = std::vector<clock_bounds_t>(nodes.size());
+    for (const auto& location : templ.locations)
+        collector.collect(location.invariant, bounds[node(&location, nullptr)]);
+
+    struct arc_t
+    {
+        size_t source;
+        transfer_t transfer;
+    };
+    auto incoming = std::vector<std::vector<arc_t>>(nodes.size());
+    for (const auto& edge : templ.edges) {
+        auto source = node(edge.src, edge.srcb);
+        collector.collect(edge.guard, bounds[source]);
+        auto& arc = incoming[node(edge.dst, edge.dstb)].emplace_back(arc_t{source, {}});
+        collect_transfer(edge.assign, evaluator, arc.transfer);
+    }
+
+    // Propagate the bounds backwards along edges which do not reset the clock
+    auto waiting = std::vector<size_t>(nodes.size());
+    for (size_t i = 0; i < waiting.size(); ++i)
+        waiting[i] = i;
+    while (!waiting.empty()) {
+        auto target = waiting.back();
+        waiting.pop_back();
+        for (const auto& arc : incoming[target]) {
+            bool changed = false;
+            for (const auto& [clock, bound] : bounds[target])
+                if (arc.transfer.resets.count(clock) == 0)
+                    changed |= bounds[arc.source][clock].join(bound);
+            for (const auto& [clock, source] : arc.transfer.copies)
+                if (auto it = bounds[target].find(clock); it != bounds[target].end())
+                    changed |= bounds[arc.source][source].join(it->second);
+            if (changed)
+                waiting.push_back(arc.source);
+        }
+    }
+
+    auto& template_bounds = templates[&templ];
+    for (const auto& location : templ.locations) {
+        const auto& local = bounds[node(&location, nullptr)];
+        auto& location_bounds = locations[&location];
+        for (const auto& [clock, bound] : local) {
+            location_bounds[clock].join(bound);
+            template_bounds[clock].join(bound);
+        }
+    }
+    for (const auto& branchpoint : templ.branchpoints)
+        for (const auto& [clock, bound] : bounds[node(nullptr, &branchpoint)])
+            template_bounds[clock].join(bound);
+
+    if (!in_system)
+        return;
+    for (const auto& [clock, bound] : template_bounds) {
+        auto actual = clock;
+        if (process != nullptr) {
+            if (auto it = process->mapping.find(clock); it != process->mapping.end() && is_clock_term(it->second))
+                actual = it->second.get_symbol();
+        }
+        global[actual].join(bound);
+    }
+}
+
+ClockBounds::ClockBounds(Document& document)
+{
+    auto instantiated = std::set<const template_t*>{};
+    for (const auto& process : document.get_processes()) {
+        if (process.templ == nullptr || !process.templ->is_TA)
+            continue;
+        analyse(*process.templ, &process, true);
+        instantiated.insert(process.templ);
+    }
+    // Parameters of templates without processes are at their upper bound, only spawned ones are part of the system
+    for (const auto& templ : document.get_templates())
+        if (templ.is_TA && instantiated.count(&templ) == 0)
+            analyse(templ, nullptr, false);
+    for (const auto* templ : document.get_dynamic_templates())
+        if (templ->is_TA && instantiated.count(templ) == 0)
+            analyse(*templ, nullptr, true);
+}
+
+const clock_bound_t& ClockBounds::get_global(symbol_t clock) const
+{
+    static const auto empty = clock_bound_t{};
+    auto it = global.find(clock);
+    return it != global.end() ? it->second : empty;
+}
+
+const clock_bounds_t& ClockBounds::get_template(const template_t& templ) const
+{
+    static const auto empty = clock_bounds_t{};
+    auto it = templates.find(&templ);
+    return it != templates.end() ? it->second : empty;
+}
+
+const clock_bounds_t& ClockBounds::get_location(const location_t& location) const
+{
+    static const auto empty = clock_bounds_t{};
+    auto it = locations.find(&location);
+    return it != locations.end() ? it->second : empty;
+}
@@ -0,0 +1,706 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/codegen.h"
+
+#include "utap/evaluator.h"
+#include "utap/statelayout.h"
+#include "utap/statement.h"
+
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <cstdlib>
+
+using namespace UTAP;
+using namespace Constants;
+
+namespace {
+/** Thrown when an expression or statement cannot be compiled. */
+struct Unsupported : std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+/** A process of the layout, the unbound parameters of a process set bound to its arguments. */
+struct element_t
+{
+    const instance_t* process{nullptr}; /**< nullptr for the global declarations */
+    std::vector<int32_t> arguments;
+    instance_t bound; /**< The process with the arguments added to the mapping */
+    std::string name;
+};
+
+using key_t = std::tuple<const instance_t*, std::vector<int32_t>, symbol_t>;
+
+class Generator;
+
+/** Translates expressions and statements in the scope of a process, or of the globals. */
+class Emitter : public StatementVisitor
+{
+    Generator& generator;
+    const element_t& element;
+    ConstantEvaluator evaluator;
+    std::map<symbol_t, std::string> locals; /**< Parameters, local and bound variables of functions */
+    std::ostream* out{nullptr};
+    int indent{1};
+    size_t parameters{0}; /**< The parameters in the frame of the function body, declared already */
+
+    /** A place in the state or a local variable, being indexed. */
+    struct place_t
+    {
+        std::string base;   /**< The field index, or the local variable */
+        std::string offset; /**< Added to the field index */
+        bool state;
+    };
+
+    std::ostream& line() { return *out << std::string(4 * indent, ' '); }
+    int32_t evaluate(const expression_t& expr) const;
+    size_t count(const type_t& type, bool clock) const;
+    place_t place(const expression_t& expr, bool clock);
+    std::string call(const expression_t& expr);
+    std::string quantifier(const expression_t& expr);
+    void statement(Statement* stat);
+    void declare(BlockStatement& block);
+
+public:
+    Emitter(Generator& generator, const element_t& element):
+        generator{generator}, element{element}, evaluator{element.bound}
+    {}
+
+    /** Returns the C++ expression. */
+    std::string expr(const expression_t& expr);
+    /** Returns the C++ lvalue of a variable (element). */
+    std::string lvalue(const expression_t& expr);
+    /** Writes the definition of the function named name. */
+    void function(const function_t& function, const std::string& name, std::ostream& os);
+
+    int32_t visitEmptyStatement(EmptyStatement* stat) override;
+    int32_t visitExprStatement(ExprStatement* stat) override;
+    int32_t visitAssertStatement(AssertStatement* stat) override;
+    int32_t visitForStatement(ForStatement* stat) override;
+    int32_t visitIterationStatement(IterationStatement* stat) override;
+    int32_t visitWhileStatement(WhileStatement* stat) override;
+    int32_t visitDoWhileStatement(DoWhileStatement* stat) override;
+    int32_t visitBlockStatement(BlockStatement* stat) override;
+    int32_t visitSwitchStatement(SwitchStatement* stat) override;
+    int32_t visitCaseStatement(CaseStatement* stat) override;
+    int32_t visitDefaultStatement(DefaultStatement* stat) override;
+    int32_t visitIfStatement(IfStatement* stat) override;
+    int32_t visitBreakStatement(BreakStatement* stat) override;
+    int32_t visitContinueStatement(ContinueStatement* stat) override;
+    int32_t visitReturnStatement(ReturnStatement* stat) override;
+};
+
+class Generator
+{
+    std::deque<element_t> elements; /**< The global scope first, then the processes of the layout */
+    std::map<key_t, size_t> fields;
+    std::map<key_t, size_t> clocks;
+    std::set<const function_t*> global_functions;
+    /** The names of the generated functions, empty if not supported */
+    std::map<std::pair<const element_t*, const function_t*>, std::string> functions;
+    std::ostringstream definitions;
+    std::vector<std::string>& unsupported;
+    size_t names{0};
+
+public:
+    Generator(Document& document, const StateLayout& layout, std::vector<std::string>& unsupported);
+
+    std::string fresh(const std::string& prefix) { return prefix + std::to_string(names++); }
+    const element_t& global() const { return elements.front(); }
+    std::optional<size_t> find(bool clock, const element_t& element, const symbol_t& symbol) const;
+    /** Returns the name of the function generated for the scope, throws Unsupported if it cannot be. */
+    const std::string& function(const element_t& element, const function_t& function);
+    std::string generate();
+};
+}  // namespace
+
+int32_t Emitter::evaluate(const expression_t& expr) const
+{
+    auto value = evaluator.evaluate(expr);
+    if (!value)
+        throw Unsupported("Not computable at compile time: " + expr.str());
+    return *value;
+}
+
+/** Counts the fields, or clocks, of the type like StateLayout flattens it. */
+size_t Emitter::count(const type_t& type, bool clock) const
+{
+    if (type.is_constant())
+        return 0;
+    if (type.is_array()) {
+        auto [first, last] = type.get_array_size().get_range();
+        return static_cast<size_t>(int64_t{evaluate(last)} - evaluate(first) + 1) * count(type.get_sub(), clock);
+    }
+    if (type.is_record()) {
+        auto res = size_t{0};
+        for (uint32_t i = 0; i < type.get_record_size(); ++i)
+            res += count(type.get_sub(i), clock);
+        return res;
+    }
+    if (type.is_clock())
+        return clock ? 1 : 0;
+    if (type.is(BOOL) || ((type.is_integral() || type.is_scalar()) && type.is_range()))
+        return clock ? 0 : 1;
+    return 0;
+}
+
+Emitter::place_t Emitter::place(const expression_t& expr, bool clock)
+{
+    switch (expr.get_kind()) {
+    case IDENTIFIER: {
+        auto symbol = expr.get_symbol();
+        if (auto it = locals.find(symbol); it != locals.end())
+            return {it->second, {}, false};
+        // mutable by-value parameters are variables of the process like the declared ones
+        if (auto index = generator.find(clock, element, symbol))
+            return {std::to_string(*index), {}, true};
+        if (auto it = element.bound.mapping.find(symbol); it != element.bound.mapping.end()) {
+            if (auto type = symbol.get_type(); !type.is(REF)) {
+                // constant parameters are folded
+                throw Unsupported((type.is_constant() ? "Not a variable: " : "Mutable parameter ") + symbol.get_name());
+            }
+            // the argument is in the scope of the system declarations
+            return Emitter{generator, generator.global()}.place(it->second, clock);
+        }
+        throw Unsupported("Not in the state: " + symbol.get_name());
+    }
+    case ARRAY: {
+        auto array = place(expr[0], clock);
+        auto type = expr[0].get_type();
+        auto lower = evaluate(type.get_array_size().get_range().first);
+        auto index = expr[1].get_kind() == CONSTANT ? std::to_string(expr[1].get_value() - lower)
+                                                     : "(" + this->expr(expr[1]) + " - " + std::to_string(lower) + ")";
+        if (array.state)
+            array.offset += " + " + index + " * " + std::to_string(count(type.get_sub(), clock));
+        else
+            array.base += "[" + index + "]";
+        return array;
+    }
+    case DOT: {
+        auto type = expr[0].get_type();
+        if (!type.is_record())
+            throw Unsupported("Not a record: " + expr.str());
+        auto record = place(expr[0], clock);
+        if (!record.state)
+            throw Unsupported("Local record: " + expr.str());
+        auto offset = size_t{0};
+        for (int32_t i = 0; i < expr.get_index(); ++i)
+            offset += count(type.get_sub(i), clock);
+        record.offset += " + " + std::to_string(offset);
+        return record;
+    }
+    default: throw Unsupported("Not a variable: " + expr.str());
+    }
+}
+
+std::string Emitter::lvalue(const expression_t& expr)
+{
+    auto clock = expr.get_type().is_clock();
+    auto at = place(expr, clock);
+    if (!at.state)
+        return at.base;
+    return std::string{clock ? "c[1 + " : "s["} + at.base + at.offset + "]";
+}
+
+std::string Emitter::call(const expression_t& expr)
+{
+    const auto* data = expr[0].get_symbol().get_data();
+    if (data == nullptr)
+        throw Unsupported("Unknown function: " + expr.str());
+    const auto& fun = *static_cast<const function_t*>(data);
+    const auto& name = generator.function(element, fun);
+    auto type = fun.uid.get_type();
+    auto res = name + "(s, c";
+    for (uint32_t i = 1; i < expr.get_size(); ++i) {
+        auto parameter = type[i];
+        if (parameter.is_array() || parameter.is_record())
+            throw Unsupported("Array or record argument: " + expr.str());
+        res += ", " + (parameter.is(REF) && !parameter.is_constant() ? lvalue(expr[i]) : this->expr(expr[i]));
+    }
+    return res + ")";
+}
+
+std::string Emitter::quantifier(const expression_t& expr)
+{
+    auto symbol = expr[0].get_symbol();
+    auto [first, last] = symbol.get_type().get_range();
+    auto name = generator.fresh("v");
+    auto range = "for (int32_t " + name + " = " + std::to_string(evaluate(first)) + "; " + name +
+                 " <= " + std::to_string(evaluate(last)) + "; ++" + name + ") ";
+    locals[symbol] = name;
+    auto body = this->expr(expr[1]);
+    locals.erase(symbol);
+    switch (expr.get_kind()) {
+    case FORALL: return "[&] { " + range + "if (!(" + body + ")) return false; return true; }()";
+    case EXISTS: return "[&] { " + range + "if (" + body + ") return true; return false; }()";
+    default: return "[&] { int32_t sum = 0; " + range + "sum += " + body + "; return sum; }()";
+    }
+}
+
+/** Returns the C++ operator of the kind, nullptr if it has none. */
+static const char* binary_operator(kind_t kind)
+{
+    switch (kind) {
+    case PLUS: return "+";
+    case MINUS: return "-";
+    case MULT: return "*";
+    case DIV: return "/";
+    case MOD: return "%";
+    case BIT_AND: return "&";
+    case BIT_OR: return "|";
+    case BIT_XOR: return "^";
+    case BIT_LSHIFT: return "<<";
+    case BIT_RSHIFT: return ">>";
+    case AND: return "&&";
+    case OR: return "||";
+    case LT: return "<";
+    case LE: return "<=";
+    case EQ: return "==";
+    case NEQ: return "!=";
+    case GE: return ">=";
+    case GT: return ">";
+    case ASSIGN: return "=";
+    case ASS_PLUS: return "+=";
+    case ASS_MINUS: return "-=";
+    case ASS_DIV: return "/=";
+    case ASS_MOD: return "%=";
+    case ASS_MULT: return "*=";
+    case ASS_AND: return "&=";
+    case ASS_OR: return "|=";
+    case ASS_XOR: return "^=";
+    case ASS_LSHIFT: return "<<=";
+    case ASS_RSHIFT: return ">>=";
+    default: return nullptr;
+    }
+}
+
+std::string Emitter::expr(const expression_t& expr)
+{
+    auto type = expr.get_type();
+    if ((type.is(INT) || type.is(BOOL)) && !type.is_array() && !type.is_record() && !expr.changes_any_variable()) {
+        if (auto value = evaluator.evaluate(expr))
+            return std::to_string(*value);
+    }
+    const auto kind = expr.get_kind();
+    if (const auto* op = binary_operator(kind)) {
+        auto left = kind >= ASSIGN && kind <= ASS_RSHIFT ? lvalue(expr[0]) : this->expr(expr[0]);
+        return "(" + left + " " + op + " " + this->expr(expr[1]) + ")";
+    }
+    switch (kind) {
+    case CONSTANT:
+        if (type.is_double())
+            throw Unsupported("Double: " + expr.str());
+        return std::to_string(expr.get_value());
+    case IDENTIFIER:
+    case ARRAY:
+    case DOT: return lvalue(expr);
+    case NOT: return "(!" + this->expr(expr[0]) + ")";
+    case UNARY_MINUS: return "(-" + this->expr(expr[0]) + ")";
+    case XOR: return "(!" + this->expr(expr[0]) + " != !" + this->expr(expr[1]) + ")";
+    case MIN: return "std::min<int32_t>(" + this->expr(expr[0]) + ", " + this->expr(expr[1]) + ")";
+    case MAX: return "std::max<int32_t>(" + this->expr(expr[0]) + ", " + this->expr(expr[1]) + ")";
+    case ABS_F: return "std::abs(" + this->expr(expr[0]) + ")";
+    case PRE_INCREMENT: return "(++" + lvalue(expr[0]) + ")";
+    case PRE_DECREMENT: return "(--" + lvalue(expr[0]) + ")";
+    case POST_INCREMENT: return "(" + lvalue(expr[0]) + "++)";
+    case POST_DECREMENT: return "(" + lvalue(expr[0]) + "--)";
+    case INLINE_IF:
+        return "(" + this->expr(expr[0]) + " ? " + this->expr(expr[1]) + " : " + this->expr(expr[2]) + ")";
+    case COMMA: return "(" + this->expr(expr[0]) + ", " + this->expr(expr[1]) + ")";
+    case FUN_CALL: return call(expr);
+    case FORALL:
+    case EXISTS:
+    case SUM: return quantifier(expr);
+    default: throw Unsupported("Unsupported expression: " + expr.str());
+    }
+}
+
+void Emitter::statement(Statement* stat)
+{
+    if (stat != nullptr)
+        stat->accept(this);
+}
+
+/** Declares the variables of the block, the parameters excluded. */
+void Emitter::declare(BlockStatement& block)
+{
+    auto frame = block.get_frame();
+    for (uint32_t i = parameters; i < frame.get_size(); ++i) {
+        auto symbol = frame[i];
+        auto type = symbol.get_type();
+        const auto* var = static_cast<const variable_t*>(symbol.get_data());
+        if (var == nullptr || type.is_constant() || type.get_kind() == TYPEDEF || type.is_function())
+            continue;
+        auto name = generator.fresh("l");
+        auto dimensions = std::string{};
+        for (; type.is_array(); type = type.get_sub()) {
+            auto [first, last] = type.get_array_size().get_range();
+            dimensions += "[" + std::to_string(int64_t{evaluate(last)} - evaluate(first) + 1) + "]";
+        }
+        if (!(type.is(BOOL) || type.is_integral() || type.is_scalar()))
+            throw Unsupported("Local variable: " + symbol.get_name());
+        if (!dimensions.empty() && !var->init.empty())
+            throw Unsupported("Initialised local array: " + symbol.get_name());
+        auto init = var->init.empty() ? std::string{"{}"} : "{" + expr(var->init) + "}";
+        line() << "int32_t " << name << dimensions << init << ";\n";
+        locals[symbol] = name;
+    }
+    parameters = 0;
+}
+
+void Emitter::function(const function_t& function, const std::string& name, std::ostream& os)
+{
+    if (dynamic_cast<const ExternalBlockStatement*>(function.body.get()) != nullptr)
+        throw Unsupported("External function");
+    auto type = function.uid.get_type();
+    auto result = type[0];
+    if (!(result.is_void() || result.is(BOOL) || result.is_integral()))
+        throw Unsupported("Return type " + result.str());
+    auto frame = function.body->get_frame();
+    auto signature = std::ostringstream{};
+    signature << (result.is_void() ? "void " : "int32_t ") << name << "(int32_t* s, double* c";
+    for (uint32_t i = 1; i < type.size(); ++i) {
+        auto parameter = type[i];
+        if (parameter.is_array() || parameter.is_record() || !(parameter.is(BOOL) || parameter.is_integral()))
+            throw Unsupported("Parameter " + type.get_label(i));
+        auto local = generator.fresh("p");
+        locals[frame[i - 1]] = local;
+        signature << (parameter.is(REF) && !parameter.is_constant() ? ", int32_t& " : ", int32_t ") << local;
+    }
+    signature << ")";
+    auto body = std::ostringstream{};
+    out = &body;
+    indent = 0;
+    parameters = type.size() - 1;
+    statement(function.body.get());
+    os << "static " << signature.str() << "\n" << body.str();
+}
+
+int32_t Emitter::visitEmptyStatement(EmptyStatement*)
+{
+    line() << ";\n";
+    return 0;
+}
+
+int32_t Emitter::visitExprStatement(ExprStatement* stat)
+{
+    line() << expr(stat->expr) << ";\n";
+    return 0;
+}
+
+int32_t Emitter::visitAssertStatement(AssertStatement* stat)
+{
+    line() << "if (!" << expr(stat->expr) << ") std::abort();\n";
+    return 0;
+}
+
+int32_t Emitter::visitForStatement(ForStatement* stat)
+{
+    auto part = [this](const expression_t& e) { return e.empty() ? std::string{} : expr(e); };
+    line() << "for (" << part(stat->init) << "; " << part(stat->cond) << "; " << part(stat->step) << ")\n";
+    ++indent;
+    statement(stat->stat.get());
+    --indent;
+    return 0;
+}
+
+int32_t Emitter::visitIterationStatement(IterationStatement* stat)
+{
+    auto [first, last] = stat->symbol.get_type().get_range();
+    auto name = generator.fresh("v");
+    locals[stat->symbol] = name;
+    line() << "for (int32_t " << name << " = " << evaluate(first) << "; " << name << " <= " << evaluate(last) << "; ++"
+           << name << ")\n";
+    ++indent;
+    statement(stat->stat.get());
+    --indent;
+    return 0;
+}
+
+int32_t Emitter::visitWhileStatement(WhileStatement* stat)
+{
+    line() << "while (" << expr(stat->cond) << ")\n";
+    ++indent;
+    statement(stat->stat.get());
+    --indent;
+    return 0;
+}
+
+int32_t Emitter::visitDoWhileStatement(DoWhileStatement* stat)
+{
+    line() << "do\n";
+    ++indent;
+    statement(stat->stat.get());
+    --indent;
+    line() << "while (" << expr(stat->cond) << ");\n";
+    return 0;
+}
+
+int32_t Emitter::visitBlockStatement(BlockStatement* stat)
+{
+    line() << "{\n";
+    ++indent;
+    declare(*stat);
+    for (auto& sub : *stat)
+        statement(sub.get());
+    --indent;
+    line() << "}\n";
+    return 0;
+}
+
+int32_t Emitter::visitSwitchStatement(SwitchStatement* stat)
+{
+    line() << "switch (" << expr(stat->cond) << ") {\n";
+    for (auto& sub : *stat)
+        statement(sub.get());
+    line() << "}\n";
+    return 0;
+}
+
+int32_t Emitter::visitCaseStatement(CaseStatement* stat)
+{
+    line() << "case " << evaluate(stat->cond) << ": {\n";
+    ++indent;
+    declare(*stat);
+    for (auto& sub : *stat)
+        statement(sub.get());
+    --indent;
+    line() << "}\n";
+    return 0;
+}
+
+int32_t Emitter::visitDefaultStatement(DefaultStatement* stat)
+{
+    line() << "default: {\n";
+    ++indent;
+    declare(*stat);
+    for (auto& sub : *stat)
+        statement(sub.get());
+    --indent;
+    line() << "}\n";
+    return 0;
+}
+
+int32_t Emitter::visitIfStatement(IfStatement* stat)
+{
+    line() << "if (" << expr(stat->cond) << ")\n";
+    ++indent;
+    statement(stat->trueCase.get());
+    --indent;
+    if (stat->falseCase) {
+        line() << "else\n";
+        ++indent;
+        statement(stat->falseCase.get());
+        --indent;
+    }
+    return 0;
+}
+
+int32_t Emitter::visitBreakStatement(BreakStatement*)
+{
+    line() << "break;\n";
+    return 0;
+}
+
+int32_t Emitter::visitContinueStatement(ContinueStatement*)
+{
+    line() << "continue;\n";
+    return 0;
+}
+
+int32_t Emitter::visitReturnStatement(ReturnStatement* stat)
+{
+    if (stat->value.empty())
+        line() << "return;\n";
+    else
+        line() << "return " << expr(stat->value) << ";\n";
+    return 0;
+}
+
+Generator::Generator(Document& document, const StateLayout& layout, std::vector<std::string>& unsupported):
+    unsupported{unsupported}
+{
+    elements.emplace_back();
+    for (const auto& fun : document.get_globals().functions)
+        global_functions.insert(&fun);
+    for (const auto& process : document.get_processes()) {
+        if (process.templ == nullptr)
+            continue;
+        for (auto& arguments : StateLayout::enumerate_arguments(process)) {
+            auto& element = elements.emplace_back(element_t{&process, arguments, process, process.uid.get_name()});
+            for (size_t i = 0; i < arguments.size(); ++i) {
+                element.bound.mapping[process.parameters[i]] = expression_t::create_constant(arguments[i]);
+                element.name += (i == 0 ? "(" : ",") + std::to_string(arguments[i]);
+                element.name += i + 1 == arguments.size() ? ")" : "";
+            }
+        }
+    }
+    const auto& layout_fields = layout.get_fields();
+    for (size_t i = 0; i < layout_fields.size(); ++i)
+        fields.emplace(key_t{layout_fields[i].process, layout_fields[i].arguments, layout_fields[i].symbol}, i);
+    const auto& layout_clocks = layout.get_clocks();
+    for (size_t i = 0; i < layout_clocks.size(); ++i)
+        clocks.emplace(key_t{layout_clocks[i].process, layout_clocks[i].arguments, layout_clocks[i].symbol}, i);
+}
+
+std::optional<size_t> Generator::find(bool clock, const element_t& element, const symbol_t& symbol) const
+{
+    const auto& indices = clock ? clocks : fields;
+    if (element.process != nullptr) {
+        if (auto it = indices.find(key_t{element.process, element.arguments, symbol}); it != indices.end())
+            return it->second;
+    }
+    if (auto it = indices.find(key_t{nullptr, {}, symbol}); it != indices.end())
+        return it->second;
+    return std::nullopt;
+}
+
+const std::string& Generator::function(const element_t& element, const function_t& function)
+{
+    const auto& scope = global_functions.count(&function) > 0 ? global() : element;
+    auto [it, inserted] = functions.emplace(std::make_pair(&scope, &function), std::string{});
+    if (inserted) {
+        // named before the body is generated, for recursion
+        it->second = fresh("f");
+        auto definition = std::ostringstream{};
+        try {
+            Emitter{*this, scope}.function(function, it->second, definition);
+            definitions << definition.str() << "\n";
+        } catch (const Unsupported& e) {
+            unsupported.push_back(scope.name + (scope.name.empty() ? "" : ".") + function.uid.get_name() + ": " +
+                                  e.what());
+            it->second.clear();
+        }
+    }
+    if (it->second.empty())
+        throw Unsupported("Function " + function.uid.get_name());
+    return it->second;
+}
+
+std::string Generator::generate()
+{
+    auto items = std::ostringstream{};
+    auto guards = std::vector<std::string>{};
+    auto updates = std::vector<std::string>{};
+    auto invariants = std::vector<std::string>{};
+    auto edges = std::vector<size_t>{0};
+    auto locations = std::vector<size_t>{0};
+    auto emit = [&](const element_t& element, const std::string& what, const expression_t& expr, bool update,
+                    std::vector<std::string>& table) {
+        try {
+            auto code = expr.empty() ? std::string{update ? "" : "1"} : Emitter{*this, element}.expr(expr);
+            auto name = fresh(update ? "u" : "g");
+            if (update)
+                items << "static void " << name << "(int32_t* s, double* c) { " << code << "; }\n";
+            else
+                items << "static int32_t " << name << "(const int32_t* state, const double* clocks)\n{\n"
+                      << "    auto* s = const_cast<int32_t*>(state);\n"
+                      << "    auto* c = const_cast<double*>(clocks);\n"
+                      << "    return " << code << ";\n}\n";
+            table.push_back(name);
+        } catch (const Unsupported& e) {
+            unsupported.push_back(element.name + "." + what + ": " + e.what());
+            table.emplace_back("nullptr");
+        }
+    };
+    for (size_t p = 1; p < elements.size(); ++p) {
+        const auto& element = elements[p];
+        const auto& templ = *element.process->templ;
+        for (const auto& location : templ.locations)
+            emit(element, location.uid.get_name(), location.invariant, false, invariants);
+        auto nr = 0;
+        for (const auto& edge : templ.edges) {
+            auto what = "edge" + std::to_string(nr++);
+            emit(element, what + ".guard", edge.guard, false, guards);
+            emit(element, what + ".update", edge.assign, true, updates);
+        }
+        edges.push_back(guards.size());
+        locations.push_back(invariants.size());
+    }
+
+    auto os = std::ostringstream{};
+    os << "// Generated by libutap, see utap/codegen.h\n"
+       << "#include <algorithm>\n#include <cstdint>\n#include <cstdlib>\n\n"
+       << "using guard_t = int32_t (*)(const int32_t*, const double*);\n"
+       << "using update_t = void (*)(int32_t*, double*);\n\n"
+       << definitions.str() << items.str() << "\n";
+    auto table = [&os](const char* type, const char* name, const auto& values) {
+        os << "extern \"C\" const " << type << " " << name << "[] = {";
+        for (const auto& value : values)
+            os << value << ", ";
+        os << "0};\n";
+    };
+    os << "extern \"C\" const uint32_t utap_process_count = " << elements.size() - 1 << ";\n";
+    table("uint32_t", "utap_edges", edges);
+    table("uint32_t", "utap_locations", locations);
+    table("guard_t", "utap_guards", guards);
+    table("update_t", "utap_updates", updates);
+    table("guard_t", "utap_invariants", invariants);
+    return os.str();
+}
+
+CodeGenerator::CodeGenerator(Document& document, const StateLayout& layout)
+{
+    source = Generator{document, layout, unsupported}.generate();
+}
+
+/** Compiles the source into a library in the directory, returns its path. */
+static std::string compile(const std::string& source, const std::filesystem::path& directory, std::string compiler)
+{
+    if (compiler.empty()) {
+        const auto* cxx = std::getenv("CXX");
+        compiler = cxx != nullptr ? cxx : "c++";
+    }
+    const auto name = "utap_native_" + std::to_string(std::hash<std::string>{}(source));
+    const auto path = directory / (name + ".cpp");
+    const auto library = directory / (name + Library::file_extension());
+    std::filesystem::create_directories(directory);
+    {
+        auto file = std::ofstream{path};
+        file << source;
+        if (!file)
+            throw std::runtime_error("Failed to write " + path.string());
+    }
+    const auto command =
+        compiler + " -std=c++17 -O2 -shared -fPIC -o \"" + library.string() + "\" \"" + path.string() + "\"";
+    if (std::system(command.c_str()) != 0)
+        throw std::runtime_error("Failed to compile: " + command);
+    return library.string();
+}
+
+NativeModule::NativeModule(const std::string& source, const std::filesystem::path& directory, std::string compiler):
+    library{compile(source, directory, std::move(compiler))}
+{
+    process_count = *static_cast<const uint32_t*>(library.get_symbol("utap_process_count"));
+    edges = static_cast<const uint32_t*>(library.get_symbol("utap_edges"));
+    locations = static_cast<const uint32_t*>(library.get_symbol("utap_locations"));
+    guards = static_cast<const native_guard_t*>(library.get_symbol("utap_guards"));
+    updates = static_cast<const native_update_t*>(library.get_symbol("utap_updates"));
+    invariants = static_cast<const native_guard_t*>(library.get_symbol("utap_invariants"));
+}
@@ -0,0 +1,357 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/costmodel.h"
+
+#include "utap/evaluator.h"
+#include "utap/statement.h"
+
+#include <algorithm>
+#include <set>
+
+using namespace UTAP;
+using namespace Constants;
+
+static uint64_t add(uint64_t a, uint64_t b) { return a > CostModel::unbounded - b ? CostModel::unbounded : a + b; }
+
+static uint64_t mul(uint64_t a, uint64_t b)
+{
+    if (a == 0 || b == 0)
+        return 0;
+    return a > CostModel::unbounded / b ? CostModel::unbounded : a * b;
+}
+
+namespace {
+class Estimator : public StatementVisitor
+{
+    std::map<const function_t*, uint64_t>& functions;
+    std::vector<CostModel::loop_t>& loops;
+    ConstantEvaluator evaluator{};
+    std::set<const function_t*> active;
+    const function_t* current{nullptr};
+    uint64_t cost{0};
+
+    std::optional<int64_t> constant(const expression_t& expr) const
+    {
+        if (expr.empty() || expr.changes_any_variable())
+            return std::nullopt;
+        if (auto value = evaluator.evaluate(expr))
+            return *value;
+        return std::nullopt;
+    }
+
+    /** Returns the number of values of the type, nothing if it is not a computable range. */
+    std::optional<uint64_t> values(const type_t& type) const
+    {
+        if (type.is(BOOL) && !type.is(RANGE))
+            return 2;
+        if (!type.is(RANGE))
+            return std::nullopt;
+        auto [first, last] = type.get_range();
+        auto lower = constant(first);
+        auto upper = constant(last);
+        if (!lower || !upper)
+            return std::nullopt;
+        return *upper < *lower ? 0 : static_cast<uint64_t>(*upper - *lower + 1);
+    }
+
+    uint64_t statement(Statement* stat)
+    {
+        if (stat == nullptr)
+            return 0;
+        stat->accept(this);
+        return cost;
+    }
+
+    uint64_t call(const expression_t& expr)
+    {
+        auto res = uint64_t{1};
+        for (uint32_t i = 1; i < expr.get_size(); ++i)
+            res = add(res, this->expr(expr[i]));
+        const auto* data = expr[0].get_symbol().get_data();
+        if (expr.get_kind() != FUN_CALL || data == nullptr)
+            return res;  // external
+        return add(res, function(*static_cast<const function_t*>(data)));
+    }
+
+    std::optional<uint64_t> for_trips(const ForStatement& loop)
+    {
+        // the counter, its initial value and the step
+        const auto& init = loop.init;
+        if (init.empty() || init.get_kind() != ASSIGN || init[0].get_kind() != IDENTIFIER)
+            return std::nullopt;
+        auto counter = init[0].get_symbol();
+        auto is_counter = [&counter](const expression_t& expr) {
+            return expr.get_kind() == IDENTIFIER && expr.get_symbol() == counter;
+        };
+        const auto& step = loop.step;
+        auto k = std::optional<int64_t>{};
+        if (step.empty())
+            return std::nullopt;
+        switch (step.get_kind()) {
+        case PRE_INCREMENT:
+        case POST_INCREMENT: k = is_counter(step[0]) ? std::optional<int64_t>{1} : std::nullopt; break;
+        case PRE_DECREMENT:
+        case POST_DECREMENT: k = is_counter(step[0]) ? std::optional<int64_t>{-1} : std::nullopt; break;
+        case ASS_PLUS:
+        case ASS_MINUS:
+            if (is_counter(step[0]))
+                if ((k = constant(step[1])) && step.get_kind() == ASS_MINUS)
+                    k = -*k;
+            break;
+        case ASSIGN:
+            if (is_counter(step[0]) && (step[1].get_kind() == PLUS || step[1].get_kind() == MINUS) &&
+                is_counter(step[1][0]))
+                if ((k = constant(step[1][1])) && step[1].get_kind() == MINUS)
+                    k = -*k;
+            break;
+        default: break;
+        }
+        if (!k || *k == 0)
+            return std::nullopt;
+
+        // the body must not assign the counter
+        auto changes = std::set<symbol_t>{};
+        auto collector = CollectChangesVisitor{changes};
+        loop.stat->accept(&collector);
+        if (changes.count(counter) > 0)
+            return std::nullopt;
+
+        // the condition compares the counter with a bound, counter op bound
+        const auto& cond = loop.cond;
+        if (cond.empty() || cond.get_size() != 2)
+            return std::nullopt;
+        auto op = cond.get_kind();
+        auto bound = expression_t{};
+        if (is_counter(cond[0])) {
+            bound = cond[1];
+        } else if (is_counter(cond[1])) {
+            bound = cond[0];
+            op = op == LT ? GT : op == GT ? LT : op == LE ? GE : op == GE ? LE : op;
+        } else {
+            return std::nullopt;
+        }
+        if (!(op == LT || op == LE || op == GT || op == GE || op == NEQ))
+            return std::nullopt;
+        auto increasing = *k > 0;
+        if ((increasing && (op == GT || op == GE)) || (!increasing && (op == LT || op == LE)))
+            return std::nullopt;
+        auto stride = increasing ? *k : -*k;
+
+        auto a = constant(init[1]);
+        auto b = constant(bound);
+        if (a && b) {
+            auto distance = increasing ? *b - *a : *a - *b;
+            if (op == LE || op == GE)
+                return distance < 0 ? 0 : static_cast<uint64_t>(distance / stride + 1);
+            if (op == NEQ && (distance < 0 || distance % stride != 0))
+                return std::nullopt;  // steps over the bound
+            return distance <= 0 ? 0 : static_cast<uint64_t>((distance + stride - 1) / stride);
+        }
+        // the counter cannot leave its declared range
+        if (auto range = values(counter.get_type()); range && op != NEQ)
+            return (*range + stride - 1) / stride;
+        return std::nullopt;
+    }
+
+    /** Records the loop before its body, which may contain loops, returns its index. */
+    size_t enter(const Statement& stat)
+    {
+        loops.push_back({current, &stat, std::nullopt});
+        return loops.size() - 1;
+    }
+
+    uint64_t loop(size_t index, std::optional<uint64_t> trips, uint64_t per_trip, uint64_t once)
+    {
+        loops[index].trips = trips;
+        if (!trips)
+            return CostModel::unbounded;
+        return add(once, mul(*trips, per_trip));
+    }
+
+    int32_t block(BlockStatement* stat)
+    {
+        auto res = uint64_t{0};
+        auto frame = stat->get_frame();
+        for (uint32_t i = 0; i < frame.get_size(); ++i) {
+            // parameters have no data
+            auto symbol = frame[i];
+            if (symbol.get_data() != nullptr && symbol.get_type().get_kind() != TYPEDEF &&
+                !symbol.get_type().is_function())
+                res = add(res, expr(static_cast<const variable_t*>(symbol.get_data())->init));
+        }
+        for (auto& child : *stat)
+            res = add(res, statement(child.get()));
+        cost = res;
+        return 0;
+    }
+
+public:
+    Estimator(std::map<const function_t*, uint64_t>& functions, std::vector<CostModel::loop_t>& loops):
+        functions{functions}, loops{loops}
+    {}
+
+    uint64_t expr(const expression_t& expr)
+    {
+        if (expr.empty())
+            return 0;
+        switch (expr.get_kind()) {
+        case CONSTANT:
+        case IDENTIFIER: return 0;
+        case FUN_CALL:
+        case FUN_CALL_EXT: return call(expr);
+        case FORALL:
+        case EXISTS:
+        case SUM: {
+            auto trips = values(expr[0].get_symbol().get_type());
+            return trips ? mul(*trips, add(this->expr(expr[1]), 1)) : CostModel::unbounded;
+        }
+        case INLINE_IF: return add(add(1, this->expr(expr[0])), std::max(this->expr(expr[1]), this->expr(expr[2])));
+        default: break;
+        }
+        auto res = uint64_t{1};
+        for (uint32_t i = 0; i < expr.get_size(); ++i)
+            res = add(res, this->expr(expr[i]));
+        return res;
+    }
+
+    uint64_t function(const function_t& fun)
+    {
+        if (auto it = functions.find(&fun); it != functions.end())
+            return it->second;
+        if (fun.body == nullptr || dynamic_cast<const ExternalBlockStatement*>(fun.body.get()) != nullptr)
+            return functions[&fun] = 1;
+        if (!active.insert(&fun).second)
+            return CostModel::unbounded;  // recursion
+        auto* caller = std::exchange(current, &fun);
+        auto res = statement(fun.body.get());
+        current = caller;
+        active.erase(&fun);
+        return functions[&fun] = res;
+    }
+
+    int32_t visitEmptyStatement(EmptyStatement*) override
+    {
+        cost = 0;
+        return 0;
+    }
+    int32_t visitExprStatement(ExprStatement* stat) override
+    {
+        cost = expr(stat->expr);
+        return 0;
+    }
+    int32_t visitAssertStatement(AssertStatement* stat) override
+    {
+        cost = expr(stat->expr);
+        return 0;
+    }
+    int32_t visitForStatement(ForStatement* stat) override
+    {
+        auto index = enter(*stat);
+        auto cond = expr(stat->cond);
+        auto per_trip = add(add(statement(stat->stat.get()), expr(stat->step)), cond);
+        cost = loop(index, for_trips(*stat), per_trip, add(expr(stat->init), cond));
+        return 0;
+    }
+    int32_t visitIterationStatement(IterationStatement* stat) override
+    {
+        auto index = enter(*stat);
+        auto body = statement(stat->stat.get());
+        cost = loop(index, values(stat->symbol.get_type()), body, 0);
+        return 0;
+    }
+    int32_t visitWhileStatement(WhileStatement* stat) override
+    {
+        auto index = enter(*stat);
+        auto cond = expr(stat->cond);
+        auto value = constant(stat->cond);
+        auto trips = value && *value == 0 ? std::optional<uint64_t>{0} : std::nullopt;
+        cost = loop(index, trips, add(statement(stat->stat.get()), cond), cond);
+        return 0;
+    }
+    int32_t visitDoWhileStatement(DoWhileStatement* stat) override
+    {
+        auto index = enter(*stat);
+        auto value = constant(stat->cond);
+        auto trips = value && *value == 0 ? std::optional<uint64_t>{1} : std::nullopt;
+        cost = loop(index, trips, add(statement(stat->stat.get()), expr(stat->cond)), 0);
+        return 0;
+    }
+    int32_t visitBlockStatement(BlockStatement* stat) override { return block(stat); }
+    int32_t visitSwitchStatement(SwitchStatement* stat) override
+    {
+        // cases may fall through to the next one
+        auto cond = expr(stat->cond);
+        block(stat);
+        cost = add(cost, cond);
+        return 0;
+    }
+    int32_t visitCaseStatement(CaseStatement* stat) override { return block(stat); }
+    int32_t visitDefaultStatement(DefaultStatement* stat) override { return block(stat); }
+    int32_t visitIfStatement(IfStatement* stat) override
+    {
+        auto cond = expr(stat->cond);
+        auto then = statement(stat->trueCase.get());
+        auto otherwise = statement(stat->falseCase.get());
+        cost = add(cond, std::max(then, otherwise));
+        return 0;
+    }
+    int32_t visitBreakStatement(BreakStatement*) override
+    {
+        cost = 0;
+        return 0;
+    }
+    int32_t visitContinueStatement(ContinueStatement*) override
+    {
+        cost = 0;
+        return 0;
+    }
+    int32_t visitReturnStatement(ReturnStatement* stat) override
+    {
+        cost = expr(stat->value);
+        return 0;
+    }
+};
+}  // namespace
+
+CostModel::CostModel(Document& document)
+{
+    auto estimator = Estimator{functions, loops};
+    auto declarations = std::vector<declarations_t*>{&document.get_globals()};
+    for (auto& templ : document.get_templates())
+        declarations.push_back(&templ);
+    for (auto* templ : document.get_dynamic_templates())
+        declarations.push_back(templ);
+    for (auto* decls : declarations)
+        for (const auto& fun : decls->functions)
+            estimator.function(fun);
+    for (auto* decls : declarations) {
+        if (decls == &document.get_globals())
+            continue;
+        auto& templ = static_cast<template_t&>(*decls);
+        for (const auto& location : templ.locations)
+            invariants[&location] = estimator.expr(location.invariant);
+        for (const auto& edge : templ.edges) {
+            guards[&edge] = estimator.expr(edge.guard);
+            updates[&edge] = estimator.expr(edge.assign);
+        }
+    }
+}
@@ -21,8 +21,17 @@
 
 #include "utap/document.h"
 
+#include "utap/activeclocks.h"
 #include "utap/builder.h"
+#include "utap/clockbounds.h"
+#include "utap/costmodel.h"
+#include "utap/edgeindex.h"
+#include "utap/guardform.h"
+#include "utap/hashcons.h"
+#include "utap/priority.h"
 #include "utap/statement.h"
+#include "utap/symmetry.h"
+#include "utap/valueranges.h"
 
 #include <functional>  // std::mem_fn
 #include <iostream>
@@ -764,13 +773,15 @@ Document::Document()
 #endif
 }
 
-void Document::add(Library&& lib) { libraries.push_back(std::move(lib)); }
+void Document::add(Library&& lib) { libraries.push_back(std::make_shared<SharedLibrary>(std::move(lib))); }
 
-Library& Document::last_library()
+void Document::add(std::shared_ptr<SharedLibrary> lib) { libraries.push_back(std::move(lib)); }
+
+SharedLibrary& Document::last_library()
 {
     if (libraries.empty())
         throw std::runtime_error("$No_library_loaded");
-    return libraries.back();
+    return *libraries.back();
 }
 
 /** Creates and returns a new template. The template is created with
@@ -968,9 +979,9 @@ void Document::add_progress_measure(declarations_t* context, expression_t guard,
     context->progress.emplace_back(guard, measure);
 }
 
-static void visit(DocumentVisitor& visitor, frame_t frame)
+static void visit(DocumentVisitor& visitor, frame_t frame, size_t first = 0)
 {
-    for (size_t i = 0; i < frame.get_size(); ++i) {
+    for (size_t i = first; i < frame.get_size() && !visitor.isDone(); ++i) {
         type_t type = frame[i].get_type();
 
         if (type.get_kind() == TYPEDEF) {
@@ -1005,8 +1016,11 @@ void visitTemplate(template_t& t, DocumentVisitor& visitor)
 {
     if (visitor.visitTemplateBefore(t)) {
         visit(visitor, t.frame);
-        for (auto& edge : t.edges)
+        for (auto& edge : t.edges) {
+            if (visitor.isDone())
+                break;
             visitor.visitEdge(edge);
+        }
         for (auto& message : t.messages)
             visitor.visitMessage(message);
         for (auto& update : t.updates)
@@ -1018,15 +1032,33 @@ void visitTemplate(template_t& t, DocumentVisitor& visitor)
 }
 
 void Document::accept(DocumentVisitor& visitor)
+{
+    visitor.visitDocBefore(*this);
+    accept(visitor, 0);
+}
+
+size_t Document::accept_globals(DocumentVisitor& visitor)
 {
     visitor.visitDocBefore(*this);
     visit(visitor, global.frame);
-    for (auto& templ : templates)
+    return global.frame.get_size();
+}
+
+void Document::accept(DocumentVisitor& visitor, size_t globals)
+{
+    visit(visitor, global.frame, globals);
+    for (auto& templ : templates) {
+        if (visitor.isDone())
+            break;
         visitTemplate(templ, visitor);
-    for (auto& templ : dyn_templates)
+    }
+    for (auto& templ : dyn_templates) {
+        if (visitor.isDone())
+            break;
         visitTemplate(templ, visitor);
+    }
 
-    for (size_t i = 0; i < global.frame.get_size(); ++i) {
+    for (size_t i = 0; i < global.frame.get_size() && !visitor.isDone(); ++i) {
         type_t type = global.frame[i].get_type();
         void* data = global.frame[i].get_data();
         type = type.strip_array();
@@ -1052,6 +1084,250 @@ void Document::accept(DocumentVisitor& visitor)
     visitor.visitDocAfter(*this);
 }
 
+DocumentVisitorPipeline& DocumentVisitorPipeline::add(DocumentVisitor& visitor,
+                                                      std::initializer_list<const DocumentVisitor*> after)
+{
+    size_t stage = 0;
+    for (auto* dependency : after) {
+        auto it = std::find_if(passes.begin(), passes.end(), [dependency](auto& p) { return p.visitor == dependency; });
+        assert(it != passes.end());  // dependencies must be added first
+        stage = std::max(stage, it->stage + 1);
+    }
+    passes.push_back({&visitor, stage});
+    return *this;
+}
+
+size_t DocumentVisitorPipeline::get_stage_count() const
+{
+    size_t count = 0;
+    for (auto& pass : passes)
+        count = std::max(count, pass.stage + 1);
+    return count;
+}
+
+void DocumentVisitorPipeline::run(Document& document)
+{
+    const auto count = get_stage_count();
+    for (size_t s = 0; s < count; ++s) {
+        select(s);
+        document.accept(*this);
+    }
+    stage.clear();
+}
+
+size_t DocumentVisitorPipeline::run_globals(Document& document)
+{
+    select(0);
+    return document.accept_globals(*this);
+}
+
+void DocumentVisitorPipeline::run(Document& document, size_t globals)
+{
+    const auto count = get_stage_count();
+    for (size_t s = 0; s < count; ++s) {
+        select(s);
+        if (s == 0)
+            document.accept(*this, globals);
+        else
+            document.accept(*this);
+    }
+    stage.clear();
+}
+
+void DocumentVisitorPipeline::select(size_t s)
+{
+    stage.clear();
+    for (auto& pass : passes)
+        if (pass.stage == s)
+            stage.push_back(pass.visitor);
+}
+
+template <typename Fn>
+void DocumentVisitorPipeline::dispatch(Fn&& fn)
+{
+    for (auto* visitor : in_template ? accepted : stage)
+        if (!visitor->isDone())
+            fn(*visitor);
+}
+
+bool DocumentVisitorPipeline::isDone() const
+{
+    const auto& active = in_template ? accepted : stage;
+    return std::all_of(active.begin(), active.end(), [](auto* v) { return v->isDone(); });
+}
+
+void DocumentVisitorPipeline::visitDocBefore(Document& doc)
+{
+    dispatch([&doc](auto& v) { v.visitDocBefore(doc); });
+}
+
+void DocumentVisitorPipeline::visitDocAfter(Document& doc)
+{
+    dispatch([&doc](auto& v) { v.visitDocAfter(doc); });
+}
+
+void DocumentVisitorPipeline::visitVariable(variable_t& var)
+{
+    dispatch([&var](auto& v) { v.visitVariable(var); });
+}
+
+bool DocumentVisitorPipeline::visitTemplateBefore(template_t& t)
+{
+    accepted.clear();
+    for (auto* visitor : stage)
+        if (!visitor->isDone() && visitor->visitTemplateBefore(t))
+            accepted.push_back(visitor);
+    in_template = !accepted.empty();
+    return in_template;
+}
+
+void DocumentVisitorPipeline::visitTemplateAfter(template_t& t)
+{
+    dispatch([&t](auto& v) { v.visitTemplateAfter(t); });
+    in_template = false;
+    accepted.clear();
+}
+
+void DocumentVisitorPipeline::visitLocation(location_t& loc)
+{
+    dispatch([&loc](auto& v) { v.visitLocation(loc); });
+}
+
+void DocumentVisitorPipeline::visitEdge(edge_t& edge)
+{
+    dispatch([&edge](auto& v) { v.visitEdge(edge); });
+}
+
+void DocumentVisitorPipeline::visitInstance(instance_t& inst)
+{
+    dispatch([&inst](auto& v) { v.visitInstance(inst); });
+}
+
+void DocumentVisitorPipeline::visitProcess(instance_t& proc)
+{
+    dispatch([&proc](auto& v) { v.visitProcess(proc); });
+}
+
+void DocumentVisitorPipeline::visitFunction(function_t& fun)
+{
+    dispatch([&fun](auto& v) { v.visitFunction(fun); });
+}
+
+void DocumentVisitorPipeline::visitTypeDef(symbol_t sym)
+{
+    dispatch([&sym](auto& v) { v.visitTypeDef(sym); });
+}
+
+void DocumentVisitorPipeline::visitIODecl(iodecl_t& decl)
+{
+    dispatch([&decl](auto& v) { v.visitIODecl(decl); });
+}
+
+void DocumentVisitorPipeline::visitProgressMeasure(progress_t& progress)
+{
+    dispatch([&progress](auto& v) { v.visitProgressMeasure(progress); });
+}
+
+void DocumentVisitorPipeline::visitGanttChart(gantt_t& gantt)
+{
+    dispatch([&gantt](auto& v) { v.visitGanttChart(gantt); });
+}
+
+void DocumentVisitorPipeline::visitInstanceLine(instance_line_t& line)
+{
+    dispatch([&line](auto& v) { v.visitInstanceLine(line); });
+}
+
+void DocumentVisitorPipeline::visitMessage(message_t& message)
+{
+    dispatch([&message](auto& v) { v.visitMessage(message); });
+}
+
+void DocumentVisitorPipeline::visitCondition(condition_t& cond)
+{
+    dispatch([&cond](auto& v) { v.visitCondition(cond); });
+}
+
+void DocumentVisitorPipeline::visitUpdate(update_t& update)
+{
+    dispatch([&update](auto& v) { v.visitUpdate(update); });
+}
+
+const ClockBounds& Document::get_clock_bounds()
+{
+    if (!clock_bounds)
+        clock_bounds = std::make_shared<const ClockBounds>(*this);
+    return *clock_bounds;
+}
+
+const ActiveClocks& Document::get_active_clocks()
+{
+    if (!active_clocks)
+        active_clocks = std::make_shared<const ActiveClocks>(*this);
+    return *active_clocks;
+}
+
+const ValueRanges& Document::get_value_ranges()
+{
+    if (!value_ranges)
+        value_ranges = std::make_shared<const ValueRanges>(*this);
+    return *value_ranges;
+}
+
+const EdgeIndex& Document::get_edge_index()
+{
+    if (!edge_index)
+        edge_index = std::make_shared<const EdgeIndex>(*this);
+    return *edge_index;
+}
+
+const GuardForms& Document::get_guard_forms()
+{
+    if (!guard_forms)
+        guard_forms = std::make_shared<const GuardForms>(*this);
+    return *guard_forms;
+}
+
+const Symmetry& Document::get_symmetry()
+{
+    if (!symmetry)
+        symmetry = std::make_shared<const Symmetry>(*this);
+    return *symmetry;
+}
+
+const PriorityTable& Document::get_priority_table()
+{
+    if (!priorities)
+        priorities = std::make_shared<const PriorityTable>(*this);
+    return *priorities;
+}
+
+const CostModel& Document::get_cost_model()
+{
+    if (!cost_model)
+        cost_model = std::make_shared<const CostModel>(*this);
+    return *cost_model;
+}
+
+ExpressionTable& Document::get_expression_table()
+{
+    if (!expression_table)
+        expression_table = std::make_shared<ExpressionTable>();
+    return *expression_table;
+}
+
+void Document::reset_analyses()
+{
+    clock_bounds.reset();
+    active_clocks.reset();
+    value_ranges.reset();
+    edge_index.reset();
+    guard_forms.reset();
+    symmetry.reset();
+    cost_model.reset();
+    priorities.reset();
+}
+
 void Document::set_before_update(expression_t e) { before_update = e; }
 
 expression_t Document::get_before_update() { return before_update; }
@@ -1088,24 +1364,43 @@ int Document::get_proc_priority(const char* name) const
     return it->second;
 }
 
-void Document::add_position(uint32_t position, uint32_t offset, uint32_t line, std::shared_ptr<std::string> path)
+uint32_t Document::add_path(std::string_view path) { return positions->add_path(path); }
+
+void Document::add_position(uint32_t position, uint32_t offset, uint32_t line, uint32_t path)
+{
+    positions->add(position, offset, line, path);
+}
+
+position_index_t::line_t Document::find_position(uint32_t position) const { return positions->find(position); }
+
+void Document::set_source(uint32_t path, uint32_t offset, uint32_t length)
 {
-    positions.add(position, offset, line, std::move(path));
+    positions->set_source(path, {offset, length});
 }
 
-const position_index_t::line_t& Document::find_position(uint32_t position) const { return positions.find(position); }
+std::optional<position_index_t::source_t> Document::find_source(std::string_view path) const
+{
+    return positions->find_source(path);
+}
 
 void Document::add_channel(bool is_broadcast) { hasNonBroadcastChan |= !is_broadcast; }
 
 void Document::add_error(position_t position, std::string msg, std::string context)
 {
-    errors.emplace_back(positions.find(position.start), positions.find(position.end), position, std::move(msg),
-                        std::move(context));
+    if (error_budget.errors != 0 && errors.size() >= error_budget.errors) {
+        errors_dropped = true;
+        return;
+    }
+    errors.emplace_back(positions, position, std::move(msg), std::move(context));
 }
 
 void Document::add_warning(position_t position, const std::string& msg, const std::string& context)
 {
-    warnings.emplace_back(positions.find(position.start), positions.find(position.end), position, msg, context);
+    if (error_budget.warnings != 0 && warnings.size() >= error_budget.warnings) {
+        warnings_dropped = true;
+        return;
+    }
+    warnings.emplace_back(positions, position, msg, context);
 }
 
 iodecl_t* Document::add_io_decl()
@@ -0,0 +1,156 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/edgeindex.h"
+
+#include "utap/evaluator.h"
+
+#include <algorithm>
+#include <optional>
+#include <set>
+
+using namespace UTAP;
+using namespace Constants;
+
+/** Returns the sizes of the dimensions of an array type, nothing if some size is not computable. */
+static std::optional<std::vector<int32_t>> dimensions(type_t type, const ConstantEvaluator& evaluator)
+{
+    auto sizes = std::vector<int32_t>{};
+    while (type.is_array()) {
+        auto size = type.get_array_size();
+        if (!size.is_range())
+            return std::nullopt;
+        auto [first, last] = size.get_range();
+        auto lower = evaluator.evaluate(first);
+        auto upper = evaluator.evaluate(last);
+        if (!lower || !upper || *upper < *lower)
+            return std::nullopt;
+        sizes.push_back(*upper - *lower + 1);
+        type = type.get_sub();
+    }
+    return sizes;
+}
+
+/**
+ * Returns the row-major indices of the channel elements the expression
+ * may denote, or any_element if they cannot be enumerated.
+ */
+static std::vector<int32_t> elements(const expression_t& expr, symbol_t& channel)
+{
+    auto evaluator = ConstantEvaluator{};
+    auto indices = std::vector<std::optional<int32_t>>{};
+    auto base = expr;
+    for (; base.get_kind() == ARRAY; base = base[0])
+        indices.insert(indices.begin(), evaluator.evaluate(base[1]));
+    if (base.get_kind() != IDENTIFIER)
+        return {TemplateEdges::any_element};
+    channel = base.get_symbol();
+    auto sizes = dimensions(channel.get_type(), evaluator);
+    if (!sizes || sizes->size() != indices.size())
+        return {TemplateEdges::any_element};
+
+    // Enumerate the elements matching the computable indices
+    auto result = std::vector<int32_t>{0};
+    for (size_t d = 0; d < sizes->size(); ++d) {
+        auto size = (*sizes)[d];
+        auto next = std::vector<int32_t>{};
+        for (auto prefix : result) {
+            if (indices[d]) {
+                if (*indices[d] >= 0 && *indices[d] < size)
+                    next.push_back(prefix * size + *indices[d]);
+            } else {
+                for (int32_t i = 0; i < size; ++i)
+                    next.push_back(prefix * size + i);
+            }
+        }
+        result = std::move(next);
+    }
+    return result;
+}
+
+TemplateEdges::TemplateEdges(const template_t& templ): locations{templ.locations.size()}
+{
+    auto rows = std::vector<std::vector<const edge_t*>>(locations + templ.branchpoints.size());
+    auto sending = std::map<channel_t, std::vector<const edge_t*>>{};
+    auto receiving = std::map<channel_t, std::vector<const edge_t*>>{};
+    for (const auto& edge : templ.edges) {
+        if (edge.src != nullptr)
+            rows[edge.src->nr].push_back(&edge);
+        else if (edge.srcb != nullptr)
+            rows[locations + edge.srcb->bpNr].push_back(&edge);
+
+        if (edge.sync.empty()) {
+            unsynchronised.push_back(&edge);
+            continue;
+        }
+        auto channel = symbol_t{};
+        auto sync = edge.sync.get_sync();
+        for (auto element : elements(edge.sync[0], channel)) {
+            // CSP synchronisation takes both roles
+            if (sync != SYNC_QUE)
+                sending[{channel, element}].push_back(&edge);
+            if (sync != SYNC_BANG)
+                receiving[{channel, element}].push_back(&edge);
+        }
+    }
+
+    for (const auto& row : rows) {
+        outgoing.edges.insert(outgoing.edges.end(), row.begin(), row.end());
+        outgoing.offsets.push_back(outgoing.edges.size());
+    }
+    auto keys = std::set<channel_t>{};
+    for (const auto& [channel, edges] : sending)
+        keys.insert(channel);
+    for (const auto& [channel, edges] : receiving)
+        keys.insert(channel);
+    channels.assign(keys.begin(), keys.end());
+    for (const auto& channel : channels) {
+        for (auto [csr, map] : {std::pair{&senders, &sending}, std::pair{&receivers, &receiving}}) {
+            if (auto it = map->find(channel); it != map->end())
+                csr->edges.insert(csr->edges.end(), it->second.begin(), it->second.end());
+            csr->offsets.push_back(csr->edges.size());
+        }
+    }
+}
+
+size_t TemplateEdges::find(const symbol_t& channel, int32_t element) const
+{
+    auto key = channel_t{channel, element};
+    auto it = std::lower_bound(channels.begin(), channels.end(), key);
+    if (it == channels.end() || key < *it)
+        return channels.size();  // no such row
+    return it - channels.begin();
+}
+
+EdgeIndex::EdgeIndex(Document& document)
+{
+    for (const auto& templ : document.get_templates())
+        templates.emplace(&templ, TemplateEdges{templ});
+    for (const auto* templ : document.get_dynamic_templates())
+        templates.emplace(templ, TemplateEdges{*templ});
+}
+
+const TemplateEdges& EdgeIndex::get(const template_t& templ) const
+{
+    static const auto empty = TemplateEdges{};
+    auto it = templates.find(&templ);
+    return it != templates.end() ? it->second : empty;
+}
@@ -0,0 +1,213 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/evaluator.h"
+
+#include "utap/document.h"
+
+#include <algorithm>  // min, max
+#include <limits>
+
+using namespace UTAP;
+using namespace Constants;
+
+ConstantEvaluator::ConstantEvaluator(const instance_t& instance): mapping{&instance.mapping} {}
+
+/** Returns the constant variable of the symbol if it has a usable initialiser. */
+static const variable_t* constant_variable(const symbol_t& symbol)
+{
+    auto type = symbol.get_type();
+    if (!type.is_constant() || !(type.is(INT) || type.is(BOOL) || type.is_array() || type.is_record()))
+        return nullptr;
+    auto* var = static_cast<const variable_t*>(symbol.get_data());
+    return (var != nullptr && !var->init.empty()) ? var : nullptr;
+}
+
+/**
+ * Follows identifiers, array subscripts and record fields to the
+ * expression they denote: an argument, an initialiser or an element
+ * of a list initialiser. Other expressions denote themselves.
+ */
+std::optional<expression_t> ConstantEvaluator::resolve(const expression_t& expr) const
+{
+    switch (expr.get_kind()) {
+    case IDENTIFIER: {
+        auto symbol = expr.get_symbol();
+        if (mapping != nullptr) {
+            if (auto it = mapping->find(symbol); it != mapping->end()) {
+                // by-value parameters which are not constant are variables of the process
+                auto type = symbol.get_type();
+                if (type.is(REF) || !type.is_constant())
+                    return std::nullopt;
+                return resolve(it->second);
+            }
+        }
+        if (const auto* var = constant_variable(symbol))
+            return resolve(var->init);
+        return std::nullopt;
+    }
+    case ARRAY: {
+        auto array = resolve(expr[0]);
+        auto index = evaluate(expr[1]);
+        if (!array || !index || array->get_kind() != LIST || *index < 0 ||
+            static_cast<uint32_t>(*index) >= array->get_size())
+            return std::nullopt;
+        return resolve(array->get(*index));
+    }
+    case DOT: {
+        if (!expr[0].get_type().is_record())
+            return std::nullopt;
+        auto record = resolve(expr[0]);
+        auto field = expr.get_record_label_index();
+        if (!record || record->get_kind() != LIST || field < 0 || static_cast<uint32_t>(field) >= record->get_size())
+            return std::nullopt;
+        return resolve(record->get(field));
+    }
+    default: return expr;
+    }
+}
+
+std::optional<int32_t> ConstantEvaluator::evaluate(const expression_t& expr) const
+{
+    if (expr.empty() || expr.get_type().is_double())
+        return std::nullopt;
+
+    auto kind = expr.get_kind();
+    switch (kind) {
+    case CONSTANT:
+        if (!expr.get_type().is_integral())
+            return std::nullopt;
+        return expr.get_value();
+    case IDENTIFIER:
+    case ARRAY:
+    case DOT: {
+        auto denoted = resolve(expr);
+        if (!denoted || denoted->get_kind() == IDENTIFIER || denoted->get_kind() == ARRAY ||
+            denoted->get_kind() == DOT)
+            return std::nullopt;
+        return evaluate(*denoted);
+    }
+    case INLINE_IF: {
+        auto cond = evaluate(expr[0]);
+        if (!cond)
+            return std::nullopt;
+        return evaluate(*cond ? expr[1] : expr[2]);
+    }
+    case AND:
+    case OR: {
+        // short-circuit as the value of the second operand may be unknown
+        auto left = evaluate(expr[0]);
+        if (!left)
+            return std::nullopt;
+        if ((kind == AND) != (*left != 0))
+            return kind == OR;
+        auto right = evaluate(expr[1]);
+        if (!right)
+            return std::nullopt;
+        return *right != 0;
+    }
+    case UNARY_MINUS:
+    case NOT:
+    case ABS_F: {
+        auto value = evaluate(expr[0]);
+        if (!value)
+            return std::nullopt;
+        auto v = static_cast<int64_t>(*value);
+        auto result = kind == UNARY_MINUS ? -v : kind == NOT ? int64_t{v == 0} : (v < 0 ? -v : v);
+        if (result > std::numeric_limits<int32_t>::max())
+            return std::nullopt;
+        return static_cast<int32_t>(result);
+    }
+    default: break;
+    }
+
+    if (expr.get_size() != 2)
+        return std::nullopt;
+    auto left = evaluate(expr[0]);
+    if (!left)
+        return std::nullopt;
+    auto right = evaluate(expr[1]);
+    if (!right)
+        return std::nullopt;
+    auto l = static_cast<int64_t>(*left);
+    auto r = static_cast<int64_t>(*right);
+    int64_t result;
+    switch (kind) {
+    case PLUS: result = l + r; break;
+    case MINUS: result = l - r; break;
+    case MULT: result = l * r; break;
+    case DIV:
+        if (r == 0)
+            return std::nullopt;
+        result = l / r;
+        break;
+    case MOD:
+        if (r == 0)
+            return std::nullopt;
+        result = l % r;
+        break;
+    case MIN: result = std::min(l, r); break;
+    case MAX: result = std::max(l, r); break;
+    case BIT_AND: result = l & r; break;
+    case BIT_OR: result = l | r; break;
+    case BIT_XOR: result = l ^ r; break;
+    case BIT_LSHIFT:
+        if (r < 0 || r > 31)
+            return std::nullopt;
+        result = static_cast<int64_t>(static_cast<uint32_t>(l) << r);
+        result = static_cast<int32_t>(result);
+        break;
+    case BIT_RSHIFT:
+        if (r < 0 || r > 31)
+            return std::nullopt;
+        result = l >> r;
+        break;
+    case XOR: result = (l != 0) != (r != 0); break;
+    case LT: result = l < r; break;
+    case LE: result = l <= r; break;
+    case EQ: result = l == r; break;
+    case NEQ: result = l != r; break;
+    case GE: result = l >= r; break;
+    case GT: result = l > r; break;
+    default: return std::nullopt;
+    }
+    if (result < std::numeric_limits<int32_t>::min() || result > std::numeric_limits<int32_t>::max())
+        return std::nullopt;
+    return static_cast<int32_t>(result);
+}
+
+std::optional<int32_t> ConstantEvaluator::evaluate_upper(const expression_t& expr) const
+{
+    if (auto value = evaluate(expr))
+        return value;
+    if (expr.empty() || expr.get_kind() != IDENTIFIER)
+        return std::nullopt;
+    auto symbol = expr.get_symbol();
+    auto type = symbol.get_type();
+    if (mapping != nullptr && (type.is(REF) || type.is_constant())) {
+        // a reference is bounded by the variable it is bound to, a mutable parameter by its own type
+        if (auto it = mapping->find(symbol); it != mapping->end())
+            return evaluate_upper(it->second);
+    }
+    if (!type.is_range() || !type.is_integer())
+        return std::nullopt;
+    return evaluate(type.get_range().second);
+}
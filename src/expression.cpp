@@ -54,6 +54,7 @@ struct expression_t::expression_data : public std::enable_shared_from_this<expre
     symbol_t symbol;                 /**< The symbol of the node */
     type_t type;                     /**< The type of the expression */
     std::vector<expression_t> sub{}; /**< Subexpressions */
+    mutable size_t hash{0};          /**< Memoised by expression_t::hash, 0 if not computed */
     expression_data(const position_t& p, kind_t kind, int32_t value): position{p}, kind{kind}, value{value} {}
 };
 
@@ -73,6 +74,33 @@ expression_t expression_t::clone() const
     return expr;
 }
 
+expression_t expression_t::rewrite_children(const std::function<expression_t(const expression_t&)>& rewrite) const
+{
+    auto result = *this;
+    for (uint32_t i = 0; i < get_size(); ++i) {
+        const auto& sub = get(i);
+        if (sub.empty())
+            continue;
+        auto rewritten = rewrite(sub);
+        if (rewritten == sub)
+            continue;
+        if (result == *this)
+            result = clone();  // copy on write, the node may be shared
+        result[i] = rewritten;
+    }
+    return result;
+}
+
+size_t expression_t::count_nodes() const
+{
+    if (empty())
+        return 0;
+    auto count = size_t{1};
+    for (uint32_t i = 0; i < get_size(); ++i)
+        count += get(i).count_nodes();
+    return count;
+}
+
 expression_t expression_t::clone_deeper() const
 {
     auto expr = expression_t{data->kind, data->position};
@@ -102,6 +130,25 @@ expression_t expression_t::clone_deeper(symbol_t from, symbol_t to) const
     return expr;
 }
 
+expression_t expression_t::clone_deeper(const std::map<symbol_t, expression_t>& bindings,
+                                        const position_t& position) const
+{
+    if (data->kind == IDENTIFIER)
+        if (auto it = bindings.find(data->symbol); it != bindings.end())
+            return it->second;
+    auto expr = expression_t{data->kind, position};
+    expr.data->value = data->value;
+    expr.data->type = data->type;
+    expr.data->symbol = data->symbol;
+
+    if (!data->sub.empty()) {
+        expr.data->sub.reserve(data->sub.size());
+        for (const auto& s : data->sub)
+            expr.data->sub.push_back(s.clone_deeper(bindings, position));
+    }
+    return expr;
+}
+
 expression_t expression_t::clone_deeper(frame_t frame, frame_t select) const
 {
     auto expr = expression_t{data->kind, data->position};
@@ -562,6 +609,7 @@ size_t expression_t::get_string_index() const
 expression_t& expression_t::operator[](uint32_t i)
 {
     assert(i < get_size());
+    data->hash = 0;
     return data->sub[i];
 }
 
@@ -574,6 +622,7 @@ const expression_t expression_t::operator[](uint32_t i) const
 expression_t& expression_t::get(uint32_t i)
 {
     assert(i < get_size());
+    data->hash = 0;
     return data->sub[i];
 }
 
@@ -628,6 +677,53 @@ bool expression_t::equal(const expression_t& e) const
     return true;
 }
 
+/** Mixes the bytes of the value into the hash, FNV-1a. */
+static uint64_t mix(uint64_t hash, uint64_t value)
+{
+    for (auto i = 0; i < 8; ++i, value >>= 8) {
+        hash ^= value & 0xff;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint64_t mix(uint64_t hash, std::string_view str)
+{
+    for (auto c : str) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+size_t expression_t::hash() const
+{
+    assert(data);
+    if (data->hash != 0)
+        return data->hash;
+    auto res = mix(14695981039346656037ull, data->kind);
+    res = std::visit(
+        [res](const auto& value) {
+            using T = std::decay_t<decltype(value)>;
+            if constexpr (std::is_same_v<T, double>) {
+                auto bits = uint64_t{};
+                std::memcpy(&bits, &value, sizeof(bits));
+                return mix(mix(res, 2), bits);
+            } else if constexpr (std::is_same_v<T, StringIndex>) {
+                return mix(mix(res, 3), value.str());
+            } else {
+                return mix(res, static_cast<uint64_t>(value));
+            }
+        },
+        data->value);
+    if (data->symbol != symbol_t{})
+        res = mix(res, data->symbol.get_name());
+    for (const auto& sub : data->sub)
+        res = mix(res, sub.empty() ? 0 : sub.hash());
+    data->hash = res != 0 ? static_cast<size_t>(res) : 1;
+    return data->hash;
+}
+
 /**
    Returns the symbol of a variable reference. The expression must be
    a left-hand side value. The symbol returned is the symbol of the
@@ -678,28 +774,26 @@ const symbol_t expression_t::get_symbol() const
     }
 }
 
-void expression_t::get_symbols(std::set<symbol_t>& symbols) const
+/** Calls pred on the symbols the expression may evaluate to (see get_symbols) until it returns true. */
+template <typename Pred>
+static bool find_symbol(const expression_t& expr, Pred& pred)
 {
-    if (empty()) {
-        return;
-    }
+    if (expr.empty())
+        return false;
 
-    switch (get_kind()) {
-    case IDENTIFIER: symbols.insert(data->symbol); break;
+    switch (expr.get_kind()) {
+    case IDENTIFIER: return pred(expr.get_symbol());
 
-    case DOT: get(0).get_symbols(symbols); break;
+    case DOT: return find_symbol(expr.get(0), pred);
 
-    case ARRAY: get(0).get_symbols(symbols); break;
+    case ARRAY: return find_symbol(expr.get(0), pred);
 
     case PRE_INCREMENT:
-    case PRE_DECREMENT: get(0).get_symbols(symbols); break;
+    case PRE_DECREMENT: return find_symbol(expr.get(0), pred);
 
-    case INLINE_IF:
-        get(1).get_symbols(symbols);
-        get(2).get_symbols(symbols);
-        break;
+    case INLINE_IF: return find_symbol(expr.get(1), pred) || find_symbol(expr.get(2), pred);
 
-    case COMMA: get(1).get_symbols(symbols); break;
+    case COMMA: return find_symbol(expr.get(1), pred);
 
     case ASSIGN:
     case ASS_PLUS:
@@ -711,16 +805,25 @@ void expression_t::get_symbols(std::set<symbol_t>& symbols) const
     case ASS_OR:
     case ASS_XOR:
     case ASS_LSHIFT:
-    case ASS_RSHIFT: get(0).get_symbols(symbols); break;
+    case ASS_RSHIFT: return find_symbol(expr.get(0), pred);
 
-    case SYNC: get(0).get_symbols(symbols); break;
+    case SYNC: return find_symbol(expr.get(0), pred);
 
     default:
         // Do nothing
-        break;
+        return false;
     }
 }
 
+void expression_t::get_symbols(std::set<symbol_t>& symbols) const
+{
+    auto collect = [&symbols](symbol_t symbol) {
+        symbols.insert(symbol);
+        return false;
+    };
+    find_symbol(*this, collect);
+}
+
 /** Returns true if expr might be a reference to a symbol in the
     set. */
 bool expression_t::is_reference_to(const std::set<symbol_t>& symbols) const
@@ -741,27 +844,123 @@ bool expression_t::contains_deadlock() const
     return false;
 }
 
+/** Calls pred on the variables the expression may write (see collect_possible_writes) until it returns true. */
+template <typename Pred>
+static bool find_write(const expression_t& expr, Pred& pred)
+{
+    if (expr.empty())
+        return false;
+
+    for (uint32_t i = 0; i < expr.get_size(); i++)
+        if (find_write(expr.get(i), pred))
+            return true;
+
+    switch (expr.get_kind()) {
+    case ASSIGN:
+    case ASS_PLUS:
+    case ASS_MINUS:
+    case ASS_DIV:
+    case ASS_MOD:
+    case ASS_MULT:
+    case ASS_AND:
+    case ASS_OR:
+    case ASS_XOR:
+    case ASS_LSHIFT:
+    case ASS_RSHIFT:
+    case POST_INCREMENT:
+    case POST_DECREMENT:
+    case PRE_INCREMENT:
+    case PRE_DECREMENT: return find_symbol(expr.get(0), pred);
+
+    case FUN_CALL:
+    case FUN_CALL_EXT: {
+        // Symbols which are changed by the function
+        auto symbol = expr.get(0).get_symbol();
+        if ((symbol.get_type().is_function() || symbol.get_type().is_function_external()) && symbol.get_data()) {
+            auto* fun = static_cast<const function_t*>(symbol.get_data());
+            if (!fun->has_side_effects)
+                return false;
+            for (const auto& changed : fun->changes)
+                if (pred(changed))
+                    return true;
+
+            // Arguments to non-constant reference parameters
+            auto type = fun->uid.get_type();
+            for (uint32_t i = 1; i < min(expr.get_size(), type.size()); i++)
+                if (type[i].is(REF) && !type[i].is_constant() && find_symbol(expr.get(i), pred))
+                    return true;
+        }
+        return false;
+    }
+
+    default: return false;
+    }
+}
+
+/** Calls pred on the symbols the expression may read (see collect_possible_reads) until it returns true. */
+template <typename Pred>
+static bool find_read(const expression_t& expr, Pred& pred, bool collectRandom = false)
+{
+    if (expr.empty())
+        return false;
+
+    for (uint32_t i = 0; i < expr.get_size(); i++)
+        if (find_read(expr.get(i), pred))
+            return true;
+
+    switch (expr.get_kind()) {
+    case IDENTIFIER: return pred(expr.get_symbol());
+
+    case FUN_CALL: {
+        // Symbols which are used by the function
+        auto symbol = expr.get(0).get_symbol();
+        if (auto type = symbol.get_type(); type.is_function() || type.is_function_external()) {
+            if (auto* data = symbol.get_data(); data) {
+                for (const auto& used : static_cast<const function_t*>(data)->depends)
+                    if (pred(used))
+                        return true;
+            }
+        }
+        return false;
+    }
+    // TODO: revisit, should register the arguments instead of a single unknown symbol
+    case RANDOM_F:
+    case RANDOM_POISSON_F:
+    case RANDOM_ARCSINE_F:
+    case RANDOM_BETA_F:
+    case RANDOM_GAMMA_F:
+    case RANDOM_NORMAL_F:
+    case RANDOM_WEIBULL_F:
+    case RANDOM_TRI_F: return collectRandom && pred(symbol_t());
+    default: return false;
+    }
+}
+
 bool expression_t::changes_variable(const std::set<symbol_t>& symbols) const
 {
-    auto changes = std::set<symbol_t>{};
-    collect_possible_writes(changes);
-    return find_first_of(symbols.begin(), symbols.end(), changes.begin(), changes.end()) != symbols.end();
+    auto in_symbols = [&symbols](symbol_t symbol) { return symbols.count(symbol) > 0; };
+    return !symbols.empty() && find_write(*this, in_symbols);
+}
+
+bool expression_t::changes_variable_if(const std::function<bool(symbol_t)>& pred) const
+{
+    return find_write(*this, pred);
 }
 
 bool expression_t::changes_any_variable() const
 {
-    auto changes = std::set<symbol_t>{};
-    collect_possible_writes(changes);
-    return !changes.empty();
+    auto any = [](symbol_t) { return true; };
+    return find_write(*this, any);
 }
 
 bool expression_t::depends_on(const std::set<symbol_t>& symbols) const
 {
-    std::set<symbol_t> dependencies;
-    collect_possible_reads(dependencies);
-    return find_first_of(symbols.begin(), symbols.end(), dependencies.begin(), dependencies.end()) != symbols.end();
+    auto in_symbols = [&symbols](symbol_t symbol) { return symbols.count(symbol) > 0; };
+    return !symbols.empty() && find_read(*this, in_symbols);
 }
 
+bool expression_t::depends_on_if(const std::function<bool(symbol_t)>& pred) const { return find_read(*this, pred); }
+
 int expression_t::get_precedence() const { return get_precedence(data->kind); }
 
 int expression_t::get_precedence(kind_t kind)
@@ -1732,105 +1931,20 @@ std::string expression_t::str(bool old) const
 
 void expression_t::collect_possible_writes(set<symbol_t>& symbols) const
 {
-    function_t* fun;
-    symbol_t symbol;
-    type_t type;
-
-    if (empty())
-        return;
-
-    for (uint32_t i = 0; i < get_size(); i++) {
-        get(i).collect_possible_writes(symbols);
-    }
-
-    switch (get_kind()) {
-    case ASSIGN:
-    case ASS_PLUS:
-    case ASS_MINUS:
-    case ASS_DIV:
-    case ASS_MOD:
-    case ASS_MULT:
-    case ASS_AND:
-    case ASS_OR:
-    case ASS_XOR:
-    case ASS_LSHIFT:
-    case ASS_RSHIFT:
-    case POST_INCREMENT:
-    case POST_DECREMENT:
-    case PRE_INCREMENT:
-    case PRE_DECREMENT: get(0).get_symbols(symbols); break;
-
-    case FUN_CALL:
-    case FUN_CALL_EXT:
-        // Add all symbols which are changed by the function
-        symbol = get(0).get_symbol();
-        if ((symbol.get_type().is_function() || symbol.get_type().is_function_external()) && symbol.get_data()) {
-            fun = (function_t*)symbol.get_data();
-
-            symbols.insert(fun->changes.begin(), fun->changes.end());
-
-            // Add arguments to non-constant reference parameters
-            type = fun->uid.get_type();
-            for (uint32_t i = 1; i < min(get_size(), type.size()); i++) {
-                if (type[i].is(REF) && !type[i].is_constant()) {
-                    get(i).get_symbols(symbols);
-                }
-            }
-        }
-        break;
-
-    default: break;
-    }
+    auto collect = [&symbols](symbol_t symbol) {
+        symbols.insert(symbol);
+        return false;
+    };
+    find_write(*this, collect);
 }
 
 void expression_t::collect_possible_reads(set<symbol_t>& symbols, bool collectRandom) const
 {
-    if (empty())
-        return;
-
-    for (uint32_t i = 0; i < get_size(); i++)
-        get(i).collect_possible_reads(symbols);
-
-    switch (get_kind()) {
-    case IDENTIFIER: symbols.insert(get_symbol()); break;
-
-    case FUN_CALL: {
-        // Add all symbols which are used by the function
-        auto symbol = get(0).get_symbol();
-        if (auto type = symbol.get_type(); type.is_function() || type.is_function_external()) {
-            if (auto* data = symbol.get_data(); data) {
-                auto fun = static_cast<function_t*>(data);
-                symbols.insert(fun->depends.begin(), fun->depends.end());
-            }
-        }
-        break;
-    }
-    case RANDOM_F:
-    case RANDOM_POISSON_F:
-        if (collectRandom) {
-            symbols.insert(symbol_t());  // TODO: revisit, should register the argument?
-        }
-        break;
-    case RANDOM_ARCSINE_F:
-    case RANDOM_BETA_F:
-    case RANDOM_GAMMA_F:
-    case RANDOM_NORMAL_F:
-    case RANDOM_WEIBULL_F:
-        if (collectRandom) {
-            symbols.insert(symbol_t());  // TODO: revisit, should register the arguments?
-            symbols.insert(symbol_t());
-        }
-        break;
-
-    case RANDOM_TRI_F:
-        if (collectRandom) {
-            symbols.insert(symbol_t());  // TODO: revisit, should register the argument?
-            symbols.insert(symbol_t());
-            symbols.insert(symbol_t());
-        }
-        break;
-    default: break;
-    }
+    auto collect = [&symbols](symbol_t symbol) {
+        symbols.insert(symbol);
+        return false;
+    };
+    find_read(*this, collect, collectRandom);
 }
 
 expression_t expression_t::create_constant(int32_t value, position_t pos)
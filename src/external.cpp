@@ -0,0 +1,146 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/external.h"
+
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+using namespace UTAP;
+using namespace Constants;
+
+namespace {
+template <typename T>
+T get(const external_value_t& value);
+template <>
+int32_t get<int32_t>(const external_value_t& value)
+{
+    return value.i;
+}
+template <>
+bool get<bool>(const external_value_t& value)
+{
+    return value.b;
+}
+template <>
+double get<double>(const external_value_t& value)
+{
+    return value.d;
+}
+template <>
+void* get<void*>(const external_value_t& value)
+{
+    return value.p;
+}
+
+template <typename R, typename... A, size_t... I>
+external_value_t call(R (*fun)(A...), const external_value_t* arguments, std::index_sequence<I...>)
+{
+    if constexpr (std::is_void_v<R>) {
+        fun(get<A>(arguments[I])...);
+        return {};
+    } else {
+        return external_value_t{fun(get<A>(arguments[I])...)};
+    }
+}
+
+template <typename R, typename... A>
+external_value_t invoke(void* symbol, const external_value_t* arguments)
+{
+    return call(reinterpret_cast<R (*)(A...)>(symbol), arguments, std::index_sequence_for<A...>{});
+}
+
+template <typename R, typename... A>
+void invoke_batch(void* symbol, const external_value_t* arguments, size_t count, external_value_t* results)
+{
+    auto fun = reinterpret_cast<R (*)(A...)>(symbol);
+    for (size_t i = 0; i < count; ++i, arguments += sizeof...(A)) {
+        if constexpr (std::is_void_v<R>)
+            call(fun, arguments, std::index_sequence_for<A...>{});
+        else
+            results[i] = call(fun, arguments, std::index_sequence_for<A...>{});
+    }
+}
+
+using trampolines_t = std::pair<ExternalFunction::trampoline_t, ExternalFunction::batch_trampoline_t>;
+
+/** Instantiates the trampolines of the signature, one parameter at a time. */
+template <typename R, typename... A>
+trampolines_t select(const std::vector<external_kind_t>& parameters)
+{
+    constexpr auto arity = sizeof...(A);
+    if (arity == parameters.size())
+        return {&invoke<R, A...>, &invoke_batch<R, A...>};
+    if constexpr (arity < ExternalFunction::max_arity) {
+        switch (parameters[arity]) {
+        case external_kind_t::Int: return select<R, A..., int32_t>(parameters);
+        case external_kind_t::Bool: return select<R, A..., bool>(parameters);
+        case external_kind_t::Double: return select<R, A..., double>(parameters);
+        case external_kind_t::Pointer: return select<R, A..., void*>(parameters);
+        case external_kind_t::Void: break;
+        }
+    }
+    return {nullptr, nullptr};
+}
+}  // namespace
+
+std::optional<external_kind_t> ExternalFunction::classify(const type_t& type)
+{
+    if (type.is_array() || type.is_string() || type.is(REF))
+        return external_kind_t::Pointer;
+    if (type.is_void())
+        return external_kind_t::Void;
+    if (type.is(BOOL))
+        return external_kind_t::Bool;
+    if (type.is_integral())
+        return external_kind_t::Int;
+    if (type.is_double())
+        return external_kind_t::Double;
+    return std::nullopt;
+}
+
+ExternalFunction::ExternalFunction(void* symbol, const type_t& type): symbol{symbol}
+{
+    if (type.get_kind() != FUNCTION_EXTERNAL)
+        throw std::logic_error("Not an external function: " + type.str());
+    auto kind = classify(type[0]);
+    if (!kind)
+        throw std::logic_error("Unsupported result type: " + type[0].str());
+    result = *kind;
+    for (uint32_t i = 1; i < type.size(); ++i) {
+        kind = classify(type[i]);
+        if (!kind || *kind == external_kind_t::Void)
+            throw std::logic_error("Unsupported parameter type: " + type[i].str());
+        parameters.push_back(*kind);
+    }
+    if (parameters.size() > max_arity)
+        throw std::logic_error("More than " + std::to_string(max_arity) + " parameters: " + type.str());
+    auto trampolines = trampolines_t{};
+    switch (result) {
+    case external_kind_t::Void: trampolines = select<void>(parameters); break;
+    case external_kind_t::Int: trampolines = select<int32_t>(parameters); break;
+    case external_kind_t::Bool: trampolines = select<bool>(parameters); break;
+    case external_kind_t::Double: trampolines = select<double>(parameters); break;
+    case external_kind_t::Pointer: throw std::logic_error("Unsupported result type: " + type[0].str());
+    }
+    std::tie(invoke, invoke_batch) = trampolines;
+}
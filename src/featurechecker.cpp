@@ -29,13 +29,19 @@
 
 using namespace UTAP;
 
-FeatureChecker::FeatureChecker(Document& document)
+FeatureChecker::FeatureChecker(Document& document): document{document} { document.accept(*this); }
+
+FeatureChecker::FeatureChecker(Document& document, DocumentVisitorPipeline& pipeline): document{document}
+{
+    pipeline.add(*this);
+}
+
+void FeatureChecker::visitDocAfter(Document& doc)
 {
-    document.accept(*this);
-    visitFrame(document.get_globals().frame);
-    if (document.has_dynamic_templates())
+    visitFrame(doc.get_globals().frame);
+    if (doc.has_dynamic_templates())
         supported_methods.symbolic = false;
-    if (document.has_priority_declaration()){
+    if (doc.has_priority_declaration()){
         supported_methods.stochastic = false;
         supported_methods.concrete = false;
     }
@@ -0,0 +1,194 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/guardform.h"
+
+#include "utap/evaluator.h"
+
+#include <limits>
+#include <optional>
+
+using namespace UTAP;
+using namespace Constants;
+
+/** Returns true if the expression denotes a clock or an element of a clock array. */
+static bool is_clock_term(const expression_t& expr)
+{
+    return (expr.get_kind() == IDENTIFIER || expr.get_kind() == ARRAY) && expr.get_type().is_clock();
+}
+
+/** Resolves a clock term to the clock and the row-major index of its element. */
+static clock_term_t resolve(const expression_t& expr, const ConstantEvaluator& evaluator)
+{
+    auto indices = std::vector<std::optional<int32_t>>{};
+    auto base = expr;
+    for (; base.get_kind() == ARRAY; base = base[0])
+        indices.insert(indices.begin(), evaluator.evaluate(base[1]));
+    auto term = clock_term_t{base.get_symbol(), 0, expr};
+    auto type = term.clock.get_type();
+    for (const auto& index : indices) {
+        auto size = type.is_array() ? type.get_array_size() : type_t{};
+        auto lower = size.is_range() ? evaluator.evaluate(size.get_range().first) : std::nullopt;
+        auto upper = size.is_range() ? evaluator.evaluate(size.get_range().second) : std::nullopt;
+        if (!index || !lower || !upper || *index < 0 || *index > *upper - *lower) {
+            term.element = clock_term_t::any_element;
+            break;
+        }
+        term.element = term.element * (*upper - *lower + 1) + *index;
+        type = type.get_sub();
+    }
+    return term;
+}
+
+static bool is_comparison(kind_t op) { return op == LT || op == LE || op == EQ || op == GE || op == GT; }
+
+static kind_t mirror(kind_t op)
+{
+    switch (op) {
+    case LT: return GT;
+    case LE: return GE;
+    case GT: return LT;
+    case GE: return LE;
+    default: return op;
+    }
+}
+
+namespace {
+class Normaliser
+{
+    const ConstantEvaluator& evaluator;
+    guard_form_t& form;
+
+    static void conjoin(expression_t& conjunction, const expression_t& expr)
+    {
+        conjunction = conjunction.empty() ? expr
+                                          : expression_t::create_binary(AND, conjunction, expr, expr.get_position(),
+                                                                        type_t::create_primitive(BOOL));
+    }
+
+    expression_t fold(const expression_t& expr) const
+    {
+        if (auto value = evaluator.evaluate(expr); value)
+            return expression_t::create_constant(*value, expr.get_position());
+        return expr;
+    }
+
+    expression_t negate(const expression_t& bound) const
+    {
+        if (auto value = evaluator.evaluate(bound); value && *value != std::numeric_limits<int32_t>::min())
+            return expression_t::create_constant(-*value, bound.get_position());
+        return expression_t::create_unary(UNARY_MINUS, bound, bound.get_position(), bound.get_type());
+    }
+
+    /** Adds first - second ~ bound, returns false if op is not a canonical comparison. */
+    bool add(kind_t op, clock_term_t first, clock_term_t second, const expression_t& bound)
+    {
+        switch (op) {
+        case LT:
+        case LE: form.clocks.push_back({std::move(first), std::move(second), fold(bound), op == LT}); return true;
+        case GT:
+        case GE: form.clocks.push_back({std::move(second), std::move(first), negate(bound), op == GT}); return true;
+        case EQ:
+            form.clocks.push_back({first, second, fold(bound), false});
+            form.clocks.push_back({std::move(second), std::move(first), negate(bound), false});
+            return true;
+        default: return false;
+        }
+    }
+
+    /** Adds a comparison of a clock or a difference of clocks with a clock free bound. */
+    bool comparison(kind_t op, const expression_t& left, const expression_t& right)
+    {
+        if (right.uses_clock()) {
+            if (left.uses_clock())
+                return false;
+            return comparison(mirror(op), right, left);
+        }
+        if (is_clock_term(left))
+            return add(op, resolve(left, evaluator), {}, right);
+        if (left.get_kind() == MINUS && is_clock_term(left[0]) && is_clock_term(left[1]))
+            return add(op, resolve(left[0], evaluator), resolve(left[1], evaluator), right);
+        return false;
+    }
+
+public:
+    Normaliser(const ConstantEvaluator& evaluator, guard_form_t& form): evaluator{evaluator}, form{form} {}
+
+    void conjunct(const expression_t& expr)
+    {
+        if (expr.empty())
+            return;
+        auto kind = expr.get_kind();
+        if (kind == AND) {
+            conjunct(expr[0]);
+            conjunct(expr[1]);
+        } else if (kind == EQ && (expr[0].get_kind() == RATE || expr[1].get_kind() == RATE)) {
+            form.rates.push_back(expr);
+        } else if (!expr.uses_clock()) {
+            auto value = evaluator.evaluate(expr);
+            if (!value)
+                conjoin(form.data, expr);
+            else if (*value == 0)
+                form.unsatisfiable = true;
+        } else if (!is_comparison(kind) || !comparison(kind, expr[0], expr[1])) {
+            conjoin(form.residual, expr);
+        }
+    }
+};
+}  // namespace
+
+guard_form_t UTAP::normalise_guard(const expression_t& expr, const ConstantEvaluator& evaluator)
+{
+    auto form = guard_form_t{};
+    Normaliser{evaluator, form}.conjunct(expr);
+    return form;
+}
+
+GuardForms::GuardForms(Document& document)
+{
+    for (const auto& templ : document.get_templates())
+        add(templ);
+    for (const auto* templ : document.get_dynamic_templates())
+        add(*templ);
+}
+
+void GuardForms::add(const template_t& templ)
+{
+    auto evaluator = ConstantEvaluator{};
+    for (const auto& location : templ.locations)
+        invariants.emplace(&location, normalise_guard(location.invariant, evaluator));
+    for (const auto& edge : templ.edges)
+        guards.emplace(&edge, normalise_guard(edge.guard, evaluator));
+}
+
+const guard_form_t& GuardForms::get_guard(const edge_t& edge) const
+{
+    static const auto empty = guard_form_t{};
+    auto it = guards.find(&edge);
+    return it != guards.end() ? it->second : empty;
+}
+
+const guard_form_t& GuardForms::get_invariant(const location_t& location) const
+{
+    static const auto empty = guard_form_t{};
+    auto it = invariants.find(&location);
+    return it != invariants.end() ? it->second : empty;
+}
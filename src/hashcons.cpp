@@ -0,0 +1,111 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/hashcons.h"
+
+#include "utap/document.h"
+
+#include <map>
+#include <set>
+
+using namespace UTAP;
+
+/** Types are compared by structure, as the type checker creates them per expression. */
+static bool same_type(const type_t& a, const type_t& b) { return a == b || a.str() == b.str(); }
+
+expression_t ExpressionTable::intern(const expression_t& expr)
+{
+    if (expr.empty())
+        return expr;
+    return intern(expr, !expr.changes_any_variable());
+}
+
+expression_t ExpressionTable::intern(const expression_t& expr, bool pure)
+{
+    auto result = expr.rewrite_children([this, pure](const expression_t& sub) {
+        return intern(sub, pure || !sub.changes_any_variable());
+    });
+    if (!pure || result.get_type().unknown())
+        return result;
+    auto hash = result.hash();
+    auto [first, last] = table.equal_range(hash);
+    for (auto it = first; it != last; ++it)
+        if (it->second.equal(result) && same_type(it->second.get_type(), result.get_type()))
+            return it->second;
+    table.emplace(hash, result);
+    return result;
+}
+
+namespace {
+/** Counts the occurrences of the compound subexpressions which evaluate alike in a state. */
+class Occurrences
+{
+    std::map<expression_t, size_t> counts;
+    std::vector<expression_t> order;
+
+public:
+    /** Counts the expression, the subexpressions reading the written variables excluded. */
+    void count(const expression_t& expr, const std::set<symbol_t>& written)
+    {
+        if (expr.empty() || expr.get_size() == 0)
+            return;
+        if (written.empty() || !expr.depends_on(written)) {
+            auto [it, inserted] = counts.emplace(expr, 0);
+            if (++it->second > 1)
+                return;  // the subexpressions are counted already
+            if (inserted)
+                order.push_back(expr);
+        }
+        for (uint32_t i = 0; i < expr.get_size(); ++i)
+            count(expr[i], written);
+    }
+
+    std::vector<expression_t> get_common() const
+    {
+        auto res = std::vector<expression_t>{};
+        for (const auto& expr : order)
+            if (counts.at(expr) > 1)
+                res.push_back(expr);
+        return res;
+    }
+};
+}  // namespace
+
+std::vector<expression_t> UTAP::eliminate_common_subexpressions(template_t& templ, ExpressionTable& table)
+{
+    auto occurrences = Occurrences{};
+    const auto none = std::set<symbol_t>{};
+    for (auto& location : templ.locations) {
+        location.invariant = table.intern(location.invariant);
+        occurrences.count(location.invariant, none);
+    }
+    for (auto& edge : templ.edges) {
+        edge.guard = table.intern(edge.guard);
+        edge.sync = table.intern(edge.sync);
+        edge.assign = table.intern(edge.assign);
+        occurrences.count(edge.guard, none);
+        occurrences.count(edge.sync, none);
+        auto written = std::set<symbol_t>{};
+        edge.assign.collect_possible_writes(written);
+        occurrences.count(edge.assign, written);
+    }
+    return occurrences.get_common();
+}
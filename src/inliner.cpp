@@ -0,0 +1,210 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/inliner.h"
+
+#include "utap/statement.h"
+
+#include <map>
+#include <set>
+#include <typeinfo>
+
+using namespace UTAP;
+using namespace Constants;
+
+/** Returns true if a value of the actual type keeps its meaning where the expected one is. */
+static bool compatible(const type_t& expected, const type_t& actual)
+{
+    if (expected.is(BOOL))
+        return actual.is(BOOL);
+    if (expected.is(INT))
+        return actual.is_integral();
+    if (expected.is_double())
+        return actual.is_double();
+    return true;
+}
+
+static bool calls_external(const expression_t& expr)
+{
+    if (expr.get_kind() == FUN_CALL_EXT)
+        return true;
+    for (uint32_t i = 0; i < expr.get_size(); ++i)
+        if (calls_external(expr[i]))
+            return true;
+    return false;
+}
+
+/** Returns the statements of a plain block without declarations, otherwise the statement itself. */
+static std::vector<Statement*> statements(Statement& stat)
+{
+    auto result = std::vector<Statement*>{};
+    auto* block = dynamic_cast<BlockStatement*>(&stat);
+    if (block == nullptr || typeid(stat) != typeid(BlockStatement) || block->get_frame().get_size() > 0) {
+        result.push_back(&stat);
+        return result;
+    }
+    for (const auto& nested : *block)
+        result.push_back(nested.get());
+    return result;
+}
+
+/** Returns the value the statements return from index i on, the empty expression unless every path returns. */
+static expression_t returned(const std::vector<Statement*>& stats, size_t i, const type_t& type)
+{
+    if (i == stats.size())
+        return {};
+    auto* stat = stats[i];
+    if (auto* ret = dynamic_cast<ReturnStatement*>(stat))
+        return ret->value;
+    if (dynamic_cast<EmptyStatement*>(stat) != nullptr)
+        return returned(stats, i + 1, type);
+    if (auto* branch = dynamic_cast<IfStatement*>(stat)) {
+        auto then = returned(statements(*branch->trueCase), 0, type);
+        auto otherwise = branch->falseCase ? returned(statements(*branch->falseCase), 0, type)
+                                           : returned(stats, i + 1, type);
+        if (then.empty() || otherwise.empty())
+            return {};
+        return expression_t::create_ternary(INLINE_IF, branch->cond, then, otherwise, branch->cond.get_position(),
+                                            type);
+    }
+    if (auto nested = statements(*stat); nested.size() != 1 || nested[0] != stat) {
+        if (i + 1 == stats.size())
+            return returned(nested, 0, type);
+    }
+    return {};
+}
+
+expression_t UTAP::inline_body(const function_t& function, const inline_limits_t& limits)
+{
+    if (function.body == nullptr || dynamic_cast<const ExternalBlockStatement*>(function.body.get()) != nullptr)
+        return {};
+    if (function.has_side_effects || !function.changes.empty() || !function.variables.empty())
+        return {};
+    auto type = function.uid.get_type()[0];
+    if (type.is_void())
+        return {};
+    auto stats = std::vector<Statement*>{};
+    for (const auto& stat : *function.body)
+        stats.push_back(stat.get());
+    auto body = returned(stats, 0, type);
+    if (body.empty() || body.changes_any_variable() || !compatible(type, body.get_type()))
+        return {};
+    if (body.count_nodes() > limits.size)
+        return {};
+    return body;
+}
+
+namespace {
+class Inliner
+{
+    const inline_limits_t& limits;
+    std::vector<inlining_t>* calls;
+    std::map<const function_t*, expression_t> bodies;
+    std::set<const function_t*> active;     // the functions being inlined
+    std::set<const function_t*> recursive;  // called while being inlined, never inlined
+
+    expression_t call(const expression_t& expr)
+    {
+        auto symbol = expr[0].get_symbol();
+        const auto* function = static_cast<const function_t*>(symbol.get_data());
+        if (!symbol.get_type().is_function() || function == nullptr || recursive.count(function) > 0)
+            return {};
+        if (active.count(function) > 0) {
+            recursive.insert(function);
+            return {};
+        }
+        auto [it, inserted] = bodies.try_emplace(function);
+        if (inserted)
+            it->second = inline_body(*function, limits);
+        const auto body = it->second;
+        if (body.empty())
+            return {};
+        auto type = function->uid.get_type();
+        auto frame = function->body->get_frame();
+        auto bindings = std::map<symbol_t, expression_t>{};
+        for (uint32_t i = 1; i < type.size() && i < expr.get_size(); ++i) {
+            // the argument may be evaluated several times, or not at all
+            auto argument = expr[i];
+            if (argument.changes_any_variable() || calls_external(argument) ||
+                !compatible(type[i], argument.get_type()))
+                return {};
+            bindings.emplace(frame[i - 1], argument);
+        }
+        const auto recorded = calls != nullptr ? calls->size() : 0;
+        active.insert(function);
+        auto result = inline_calls(body.clone_deeper(bindings, expr.get_position()));
+        active.erase(function);
+        if (recursive.count(function) > 0) {
+            if (calls != nullptr)
+                calls->erase(calls->begin() + recorded, calls->end());  // inlined in the dropped body
+            return {};
+        }
+        if (calls != nullptr)
+            calls->push_back({templ, expr.get_position(), symbol.get_name(), expr.str(), result.str()});
+        return result;
+    }
+
+public:
+    const template_t* templ{nullptr};
+
+    Inliner(const inline_limits_t& limits, std::vector<inlining_t>* calls): limits{limits}, calls{calls} {}
+
+    expression_t inline_calls(const expression_t& expr)
+    {
+        if (expr.empty())
+            return expr;
+        auto result = expr.rewrite_children([this](const expression_t& sub) { return inline_calls(sub); });
+        if (result.get_kind() == FUN_CALL)
+            if (auto inlined = call(result); !inlined.empty())
+                return inlined;
+        return result;
+    }
+
+    void inline_template(template_t& templ)
+    {
+        this->templ = &templ;
+        for (auto& location : templ.locations)
+            location.invariant = inline_calls(location.invariant);
+        for (auto& edge : templ.edges) {
+            edge.guard = inline_calls(edge.guard);
+            edge.sync = inline_calls(edge.sync);
+            edge.assign = inline_calls(edge.assign);
+        }
+    }
+};
+}  // namespace
+
+expression_t UTAP::inline_calls(const expression_t& expr, const inline_limits_t& limits)
+{
+    return Inliner{limits, nullptr}.inline_calls(expr);
+}
+
+std::vector<inlining_t> UTAP::inline_functions(Document& document, const inline_limits_t& limits)
+{
+    auto calls = std::vector<inlining_t>{};
+    auto inliner = Inliner{limits, &calls};
+    for (auto& templ : document.get_templates())
+        inliner.inline_template(templ);
+    for (auto* templ : document.get_dynamic_templates())
+        inliner.inline_template(*templ);
+    document.reset_analyses();
+    return calls;
+}
@@ -67,7 +67,7 @@ struct PositionTracker
     uint32_t line{};
     uint32_t offset{};
     uint32_t position{};
-    std::shared_ptr<std::string> path;
+    uint32_t path{}; /**< Path id issued by the parser builder */
 
     /**
      * Sets the current path to \a s, offset to 0 and line to 1.
@@ -77,7 +77,13 @@ struct PositionTracker
      * content). Adds position to \a builder and increments it by
      * 1.
      */
-    void setPath(UTAP::ParserBuilder* parser, const std::string& s)
+    void setPath(UTAP::ParserBuilder* parser, std::string_view s) { setPath(parser, parser->add_path(s)); }
+
+    /**
+     * This overload provides a way reuse paths over multiple setPath calls
+     * by passing the path id returned by ParserBuilder::add_path
+     */
+    void setPath(UTAP::ParserBuilder* parser, uint32_t id)
     {
         // Incrementing the position by one avoids the problem where the
         // end-position happens to bleed into a path. E.g. the range 5-10
@@ -86,19 +92,7 @@ struct PositionTracker
         // subtract 1 before calling Positions::find().
         line = 1;
         offset = 0;
-        path = std::make_shared<std::string>(s);
-        ++position;
-        parser->add_position(position, offset, line, path);
-    }
-
-    /**
-     * This overload provides a way reuse paths over multiple setPath calls
-     */
-    void setPath(UTAP::ParserBuilder* parser, std::shared_ptr<std::string> s)
-    {
-        line = 1;
-        offset = 0;
-        path = std::move(s);
+        path = id;
         ++position;
         parser->add_position(position, offset, line, path);
     }
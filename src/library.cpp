@@ -146,4 +146,90 @@ void* Library::get_symbol(const std::string& name)
 Library::Library(const std::string& name): pImpl{new Impl{name}} {}
 Library::~Library() noexcept { delete pImpl; }
 
+namespace {
+/// The libraries and failures shared by the process, keyed by resolved path.
+struct library_cache_t
+{
+    std::mutex mutex;
+    std::unordered_map<std::string, std::weak_ptr<SharedLibrary>> libraries;
+    std::unordered_map<std::string, std::string> failures;  ///< Error messages of libraries not loaded
+
+    static library_cache_t& instance()
+    {
+        static auto cache = library_cache_t{};
+        return cache;
+    }
+};
+
+/// Returns the canonical path of the library, the name itself if it is searched by the OS.
+std::string resolve(const std::string& name)
+{
+    namespace fs = std::filesystem;
+    auto path = fs::path{name};
+    if (!path.has_parent_path())
+        return name;
+    auto ec = std::error_code{};
+    for (const auto& file : {path, fs::path{name + Library::file_extension()}}) {
+        if (fs::is_regular_file(file, ec)) {
+            auto canonical = fs::canonical(file, ec);
+            if (!ec)
+                return canonical.string();
+        }
+    }
+    auto absolute = fs::absolute(path, ec);
+    return ec ? name : absolute.string();
+}
+}  // namespace
+
+std::shared_ptr<SharedLibrary> SharedLibrary::load(const std::string& name)
+{
+    auto key = resolve(name);
+    auto& cache = library_cache_t::instance();
+    {
+        auto lock = std::lock_guard{cache.mutex};
+        if (auto it = cache.failures.find(key); it != cache.failures.end())
+            throw std::runtime_error(it->second);
+        if (auto it = cache.libraries.find(key); it != cache.libraries.end())
+            if (auto library = it->second.lock())
+                return library;
+    }
+    // loading without the lock, as the constructors of the library may load other libraries
+    auto library = std::shared_ptr<SharedLibrary>{};
+    try {
+        library = std::make_shared<SharedLibrary>(Library{name});
+    } catch (const std::runtime_error& ex) {
+        auto lock = std::lock_guard{cache.mutex};
+        cache.failures.emplace(key, ex.what());
+        throw;
+    }
+    auto lock = std::lock_guard{cache.mutex};
+    auto& entry = cache.libraries[key];
+    if (auto loaded = entry.lock())
+        return loaded;  // another thread was first, the OS counts the handle twice and ours is closed
+    entry = library;
+    return library;
+}
+
+void SharedLibrary::clear_failures()
+{
+    auto& cache = library_cache_t::instance();
+    auto lock = std::lock_guard{cache.mutex};
+    cache.failures.clear();
+}
+
+void* SharedLibrary::get_symbol(const std::string& name)
+{
+    auto lock = std::lock_guard{mutex};
+    if (auto it = symbols.find(name); it != symbols.end())
+        return it->second;
+    if (auto it = missing.find(name); it != missing.end())
+        throw std::runtime_error(it->second);
+    try {
+        return symbols[name] = library.get_symbol(name);
+    } catch (const std::runtime_error& ex) {
+        missing.emplace(name, ex.what());
+        throw;
+    }
+}
+
 }  // namespace UTAP
@@ -84,6 +84,8 @@ static int utap_lex()
 	 syntax_token = 0;
 	 return old;
    }
+   if (ch->is_truncated())
+	 return 0; // pretend end of input: the error budget is exceeded
    return lexer_flex();
 }
 
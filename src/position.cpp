@@ -22,6 +22,7 @@
 
 #include "utap/position.h"
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
@@ -30,65 +31,235 @@ using std::vector;
 
 using namespace UTAP;
 
-void position_index_t::add(uint32_t position, uint32_t offset, uint32_t line, std::shared_ptr<string> path)
+namespace {
+/** Flags in the header byte of an encoded line. */
+enum : uint8_t {
+    OFFSET_FOLLOWS = 0,  // offset advanced together with the position
+    OFFSET_ZERO = 1,     // offset was reset to zero
+    OFFSET_EXPLICIT = 2, // offset is stored explicitly
+    OFFSET_MASK = 3,
+    PATH_CHANGED = 4,  // a new path id is stored
+    LINE_FIRST = 8     // line was reset to 1, otherwise a line delta is stored
+};
+
+void put_varint(vector<uint8_t>& out, uint32_t value)
 {
-    if (!lines.empty() && position < lines.back().position) {
-        throw std::logic_error("Positions must be monotonically increasing");
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t get_varint(const uint8_t*& in)
+{
+    uint32_t value = 0;
+    for (auto shift = 0u;; shift += 7) {
+        const uint8_t byte = *in++;
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return value;
     }
-    lines.emplace_back(position, offset, line, std::move(path));
 }
 
-const position_index_t::line_t& position_index_t::find(uint32_t position, uint32_t first, uint32_t last) const
+uint32_t zigzag(int32_t value) { return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31); }
+
+int32_t unzigzag(uint32_t value) { return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1); }
+}  // namespace
+
+position_index_t::position_index_t() { add_path(""); }
+
+uint32_t position_index_t::add_path(std::string_view path)
+{
+    if (auto it = path_ids.find(path); it != path_ids.end())
+        return it->second;
+    const auto id = static_cast<uint32_t>(paths.size());
+    const auto& stored = paths.emplace_back(path);
+    path_ids.emplace(stored, id);
+    return id;
+}
+
+std::optional<uint32_t> position_index_t::find_path(std::string_view path) const
+{
+    if (auto it = path_ids.find(path); it != path_ids.end())
+        return it->second;
+    return std::nullopt;
+}
+
+void position_index_t::set_source(uint32_t path, source_t source)
+{
+    if (sources.size() <= path)
+        sources.resize(path + 1, source_t{0, no_source});
+    sources[path] = source;
+}
+
+std::optional<position_index_t::source_t> position_index_t::find_source(uint32_t path) const
+{
+    if (path < sources.size() && sources[path].length != no_source)
+        return sources[path];
+    return std::nullopt;
+}
+
+std::optional<position_index_t::source_t> position_index_t::find_source(std::string_view path) const
 {
-    while (first + 1 < last) {
-        uint32_t i = (first + last) / 2;
-        if (position < lines[i].position) {
-            last = i;
-        } else {
-            first = i;
+    if (auto id = find_path(path))
+        return find_source(*id);
+    return std::nullopt;
+}
+
+void position_index_t::encode(const line_t& line)
+{
+    const auto delta = line.position - last.position;
+    auto header = uint8_t{0};
+    if (line.offset == last.offset + delta)
+        header |= OFFSET_FOLLOWS;
+    else if (line.offset == 0)
+        header |= OFFSET_ZERO;
+    else
+        header |= OFFSET_EXPLICIT;
+    if (line.path != last.path)
+        header |= PATH_CHANGED;
+    if (line.line == 1)
+        header |= LINE_FIRST;
+    deltas.push_back(header);
+    put_varint(deltas, delta);
+    if ((header & OFFSET_MASK) == OFFSET_EXPLICIT)
+        put_varint(deltas, line.offset);
+    if (header & PATH_CHANGED)
+        put_varint(deltas, line.path);
+    if (!(header & LINE_FIRST))
+        put_varint(deltas, zigzag(static_cast<int32_t>(line.line - last.line)));
+}
+
+/** Calls fn on each line of the given block, in order, until fn returns false. */
+template <typename Fn>
+void position_index_t::decode(size_t block, Fn&& fn) const
+{
+    auto line = checkpoints[block];
+    if (!fn(line))
+        return;
+    const uint8_t* in = deltas.data() + block_starts[block];
+    const uint8_t* end = (block + 1 < block_starts.size()) ? deltas.data() + block_starts[block + 1]
+                                                            : deltas.data() + deltas.size();
+    while (in != end) {
+        const uint8_t header = *in++;
+        const auto delta = get_varint(in);
+        line.position += delta;
+        switch (header & OFFSET_MASK) {
+        case OFFSET_FOLLOWS: line.offset += delta; break;
+        case OFFSET_ZERO: line.offset = 0; break;
+        default: line.offset = get_varint(in);
         }
+        if (header & PATH_CHANGED)
+            line.path = get_varint(in);
+        if (header & LINE_FIRST)
+            line.line = 1;
+        else
+            line.line += unzigzag(get_varint(in));
+        if (!fn(line))
+            return;
+    }
+}
+
+void position_index_t::add(uint32_t position, uint32_t offset, uint32_t line, uint32_t path)
+{
+    if (count > 0 && position < last.position) {
+        throw std::logic_error("Positions must be monotonically increasing");
     }
-    return lines[first];
+    if (path >= paths.size())
+        throw std::out_of_range("Unknown path id");
+    auto entry = line_t{position, offset, line, path};
+    if (count % block_size == 0) {
+        checkpoints.push_back(entry);
+        block_starts.push_back(static_cast<uint32_t>(deltas.size()));
+    } else {
+        encode(entry);
+    }
+    last = entry;
+    ++count;
 }
 
-const position_index_t::line_t& position_index_t::find(uint32_t position) const
+position_index_t::line_t position_index_t::find(uint32_t position) const
 {
-    if (lines.empty())
+    if (count == 0)
         throw std::logic_error("No positions have been added");
-    return find(position, 0, lines.size());
+    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), position,
+                               [](uint32_t pos, const line_t& line) { return pos < line.position; });
+    const auto block = (it == checkpoints.begin()) ? 0 : static_cast<size_t>(it - checkpoints.begin()) - 1;
+    auto result = checkpoints[block];
+    decode(block, [&result, position](const line_t& line) {
+        if (position < line.position)
+            return false;
+        result = line;
+        return true;
+    });
+    return result;
+}
+
+size_t position_index_t::memory_usage() const
+{
+    return checkpoints.capacity() * sizeof(line_t) + block_starts.capacity() * sizeof(uint32_t) +
+           deltas.capacity() * sizeof(uint8_t);
 }
 
 /** Dump table to stdout. */
 std::ostream& position_index_t::print(std::ostream& os) const
 {
-    for (const auto& line : lines)
-        os << line.position << " " << line.offset << " " << line.line << " " << line.path << std::endl;
+    for (size_t block = 0; block < checkpoints.size(); ++block) {
+        decode(block, [this, &os](const line_t& line) {
+            os << line.position << " " << line.offset << " " << line.line << " " << get_path(line.path) << std::endl;
+            return true;
+        });
+    }
     return os;
 }
 
+UTAP::error_t::line_t UTAP::error_t::get_start() const { return index && !index->empty() ? index->find(position.start) : line_t{}; }
+
+UTAP::error_t::line_t UTAP::error_t::get_end() const { return index && !index->empty() ? index->find(position.end) : line_t{}; }
+
+const std::string& UTAP::error_t::get_path() const
+{
+    static const auto empty = std::string{};
+    return index ? index->get_path(get_start().path) : empty;
+}
+
+std::optional<UTAP::position_index_t::source_t> UTAP::error_t::get_source() const
+{
+    if (!index || index->empty())
+        return std::nullopt;
+    return index->find_source(get_start().path);
+}
+
 std::ostream& operator<<(std::ostream& os, const UTAP::error_t& e)
 {
-    if (!e.start.path || e.start.path->empty()) {
-        os << e.msg << " at line " << e.start.line << " column " << (e.position.start - e.start.position) << " to line "
-           << e.end.line << " column " << (e.position.end - e.end.position);
+    const auto start = e.get_start();
+    const auto end = e.get_end();
+    const auto& path = e.get_path();
+    if (path.empty()) {
+        os << e.msg << " at line " << start.line << " column " << (e.position.start - start.position) << " to line "
+           << end.line << " column " << (e.position.end - end.position);
     } else {
-        os << e.msg << " in " << e.start.path << " at line " << e.start.line << " column "
-           << (e.position.start - e.start.position) << " to line " << e.end.line << " column "
-           << (e.position.end - e.end.position);
+        os << e.msg << " in " << path << " at line " << start.line << " column "
+           << (e.position.start - start.position) << " to line " << end.line << " column "
+           << (e.position.end - end.position);
     }
     return os;
 };
 
 std::string UTAP::error_t::str() const
 {
-    if (position.start < start.position || position.end < end.position)
+    const auto start = get_start();
+    const auto end = get_end();
+    if (!index || index->empty() || position.start < start.position || position.end < end.position)
         return msg + " (Unknown position in document)";
-    if (!start.path || start.path->empty()) {
+    const auto& path = get_path();
+    if (path.empty()) {
         return msg + " at line " + std::to_string(start.line) + " column " +
                std::to_string(position.start - start.position) + " to line " + std::to_string(end.line) + " column " +
                std::to_string(position.end - end.position);
     } else {
-        return msg + " in " + *start.path + " at line " + std::to_string(start.line) + " column " +
+        return msg + " in " + path + " at line " + std::to_string(start.line) + " column " +
                std::to_string(position.start - start.position) + " to line " + std::to_string(end.line) + " column " +
                std::to_string(position.end - end.position);
     }
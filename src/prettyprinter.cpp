@@ -66,8 +66,9 @@ PrettyPrinter::PrettyPrinter(ostream& stream)
     select = guard = sync = update = probability = -1;
 }
 
-void PrettyPrinter::add_position(uint32_t position, uint32_t offset, uint32_t line, std::shared_ptr<std::string> path)
-{}
+uint32_t PrettyPrinter::add_path(std::string_view path) { return 0; }
+
+void PrettyPrinter::add_position(uint32_t position, uint32_t offset, uint32_t line, uint32_t path) {}
 
 void PrettyPrinter::handle_error(const TypeException& msg) { throw msg; }
 
@@ -0,0 +1,134 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/priority.h"
+
+#include "utap/evaluator.h"
+
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <stdexcept>
+
+using namespace UTAP;
+using namespace Constants;
+
+static int32_t evaluate(const ConstantEvaluator& evaluator, const expression_t& expr)
+{
+    auto value = evaluator.evaluate(expr);
+    if (!value)
+        throw std::logic_error("Not computable at compile time: " + expr.str());
+    return *value;
+}
+
+/** Returns the number of elements of the (array) type. */
+static uint32_t elements(const ConstantEvaluator& evaluator, const type_t& type)
+{
+    if (!type.is_array())
+        return 1;
+    auto [first, last] = type.get_array_size().get_range();
+    auto size = evaluate(evaluator, last) - evaluate(evaluator, first) + 1;
+    return static_cast<uint32_t>(std::max(size, 0)) * elements(evaluator, type.get_sub());
+}
+
+/** Replaces the levels by their rank among the levels used. */
+static std::vector<uint32_t> dense(const std::vector<int32_t>& levels)
+{
+    auto used = std::set<int32_t>{levels.begin(), levels.end()};
+    auto res = std::vector<uint32_t>{};
+    res.reserve(levels.size());
+    for (auto level : levels)
+        res.push_back(static_cast<uint32_t>(std::distance(used.begin(), used.find(level))));
+    return res;
+}
+
+PriorityTable::PriorityTable(Document& document): priorities{document.has_priority_declaration()}
+{
+    const auto evaluator = ConstantEvaluator{};
+    auto count = uint32_t{0};
+    for (const auto& var : document.get_globals().variables) {
+        auto type = var.uid.get_type();
+        if (!type.strip_array().is_channel())
+            continue;
+        auto size = elements(evaluator, type);
+        channels.emplace(var.uid, std::make_pair(count, size));
+        count += size;
+    }
+
+    // the elements denoted by a channel expression of a declaration: first and count
+    auto resolve = [&](const expression_t& expr, auto& self) -> std::pair<uint32_t, uint32_t> {
+        if (expr.get_kind() == IDENTIFIER) {
+            auto it = channels.find(expr.get_symbol());
+            if (it == channels.end())
+                throw std::logic_error("Not a global channel: " + expr.str());
+            return it->second;
+        }
+        if (expr.get_kind() != ARRAY)
+            throw std::logic_error("Not a channel: " + expr.str());
+        auto [first, size] = self(expr[0], self);
+        auto [lower, upper] = expr[0].get_type().get_array_size().get_range();
+        auto length = evaluate(evaluator, upper) - evaluate(evaluator, lower) + 1;
+        auto index = evaluate(evaluator, expr[1]) - evaluate(evaluator, lower);
+        if (index < 0 || index >= length)
+            throw std::logic_error("Channel index out of range: " + expr.str());
+        auto stride = size / static_cast<uint32_t>(length);
+        return {first + static_cast<uint32_t>(index) * stride, stride};
+    };
+
+    auto default_level = std::optional<int32_t>{};
+    auto levels = std::vector<std::optional<int32_t>>(count);
+    auto assign = [&](const expression_t& expr, int32_t level) {
+        if (expr.empty()) {
+            default_level = level;
+            return;
+        }
+        auto [first, size] = resolve(expr, resolve);
+        for (auto i = first; i < first + size; ++i)
+            levels[i] = level;
+    };
+    for (const auto& declaration : document.get_chan_priorities()) {
+        auto level = 0;
+        assign(declaration.head, level);
+        for (const auto& [separator, expr] : declaration.tail)
+            assign(expr, separator == '<' ? ++level : level);
+    }
+    auto raw = std::vector<int32_t>{};
+    for (const auto& level : levels)
+        raw.push_back(level.value_or(default_level.value_or(0)));
+    raw.push_back(default_level.value_or(0));  // tau
+    channel_levels = dense(raw);
+
+    raw.clear();
+    const auto& process_priorities = document.get_proc_priorities();
+    for (const auto& process : document.get_processes()) {
+        auto it = process_priorities.find(process.uid.get_name());
+        raw.push_back(it != process_priorities.end() ? it->second : 0);
+    }
+    process_levels = dense(raw);
+}
+
+std::optional<uint32_t> PriorityTable::get_channel(const symbol_t& channel, int32_t element) const
+{
+    auto it = channels.find(channel);
+    if (it == channels.end() || element < 0 || static_cast<uint32_t>(element) >= it->second.second)
+        return std::nullopt;
+    return it->second.first + static_cast<uint32_t>(element);
+}
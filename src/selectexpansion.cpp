@@ -0,0 +1,108 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/selectexpansion.h"
+
+#include "utap/evaluator.h"
+#include "utap/simplifier.h"
+
+#include <optional>
+#include <stdexcept>
+
+using namespace UTAP;
+using namespace Constants;
+
+/** Multiplies the counts, saturating at unbounded. */
+static size_t mul(size_t a, size_t b)
+{
+    if (a == 0 || b == 0)
+        return 0;
+    return a > select_bindings_t::unbounded / b ? select_bindings_t::unbounded : a * b;
+}
+
+select_bindings_t::select_bindings_t(std::vector<std::pair<int32_t, int32_t>> ranges):
+    ranges{std::move(ranges)}, strides(this->ranges.size())
+{
+    for (auto i = this->ranges.size(); i-- > 0;) {
+        strides[i] = count;
+        const auto& [lower, upper] = this->ranges[i];
+        count = mul(count, lower <= upper ? static_cast<size_t>(int64_t{upper} - lower + 1) : 0);
+    }
+}
+
+void select_bindings_t::get(size_t index, int32_t* values) const
+{
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        values[i] = ranges[i].first + static_cast<int32_t>(index / strides[i]);
+        index %= strides[i];
+    }
+}
+
+/** Returns the value of the guard if it is constant. */
+static std::optional<bool> constant_guard(const expression_t& guard)
+{
+    if (guard.empty())
+        return true;
+    if (guard.get_kind() == CONSTANT)
+        return guard.get_value() != 0;
+    return std::nullopt;
+}
+
+SelectExpansion::SelectExpansion(const template_t& templ, const ConstantEvaluator& evaluator, size_t threshold)
+{
+    for (const auto& edge : templ.edges) {
+        auto ranges = std::vector<std::pair<int32_t, int32_t>>{};
+        for (const auto& symbol : edge.select) {
+            auto [first, last] = symbol.get_type().get_range();
+            auto lower = evaluator.evaluate(first);
+            auto upper = evaluator.evaluate(last);
+            if (!lower || !upper)
+                throw std::logic_error("Not computable at compile time: " + symbol.get_type().str());
+            ranges.emplace_back(*lower, *upper);
+        }
+        const auto& table = bindings.emplace(&edge, select_bindings_t{std::move(ranges)}).first->second;
+        if (edge.select.get_size() == 0) {
+            instances[&edge].push_back({&edge, {}, edge.guard, edge.sync, edge.assign});
+            continue;
+        }
+        if (table.size() == select_bindings_t::unbounded || table.size() > threshold)
+            continue;
+        auto& expanded = instances[&edge];
+        auto values = std::vector<int32_t>(edge.select.get_size());
+        for (size_t index = 0; index < table.size(); ++index) {
+            table.get(index, values.data());
+            auto bind = [&](expression_t expr) {
+                if (expr.empty())
+                    return expr;
+                for (size_t i = 0; i < values.size(); ++i)
+                    expr = expr.subst(edge.select[i], expression_t::create_constant(values[i], expr.get_position()));
+                return fold_constants(expr, evaluator);
+            };
+            auto guard = bind(edge.guard);
+            auto holds = constant_guard(guard);
+            if (holds == false)
+                continue;
+            if (holds == true)
+                guard = expression_t{};
+            expanded.push_back({&edge, values, guard, bind(edge.sync), bind(edge.assign)});
+        }
+    }
+}
@@ -0,0 +1,221 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/simplifier.h"
+
+#include "utap/evaluator.h"
+
+#include <deque>
+#include <optional>
+
+using namespace UTAP;
+using namespace Constants;
+
+static bool is_constant(const expression_t& expr) { return !expr.empty() && expr.get_kind() == CONSTANT; }
+
+/** Creates a constant replacing the expression, a boolean unless the expression is an integer. */
+static expression_t constant(int32_t value, const expression_t& expr)
+{
+    auto result = expression_t::create_constant(value, expr.get_position());
+    if (!expr.get_type().is(INT))
+        result.set_type(type_t::create_primitive(BOOL));
+    return result;
+}
+
+/** Returns the truth value of the operand of a logical operator, comparing integers with zero. */
+static expression_t truth(const expression_t& operand)
+{
+    if (!operand.get_type().is(INT))
+        return operand;
+    const auto boolean = type_t::create_primitive(BOOL);
+    if (is_constant(operand)) {
+        auto result = expression_t::create_constant(operand.get_value() != 0, operand.get_position());
+        result.set_type(boolean);
+        return result;
+    }
+    auto zero = expression_t::create_constant(0, operand.get_position());
+    return expression_t::create_binary(NEQ, operand, zero, operand.get_position(), boolean);
+}
+
+expression_t UTAP::fold_constants(const expression_t& expr, const ConstantEvaluator& evaluator)
+{
+    if (expr.empty())
+        return expr;
+    const auto kind = expr.get_kind();
+    if (kind == CONSTANT)
+        return expr;
+    if (auto type = expr.get_type(); (type.is(INT) || type.is(BOOL)) && !expr.changes_any_variable()) {
+        if (auto value = evaluator.evaluate(expr))
+            return constant(*value, expr);
+    }
+    switch (kind) {
+    case AND:
+    case OR: {
+        // the operands of guards and invariants have no side effects
+        auto left = fold_constants(expr[0], evaluator);
+        auto right = fold_constants(expr[1], evaluator);
+        const auto absorbing = kind == AND ? 0 : 1;
+        for (const auto* operand : {&left, &right}) {
+            if (is_constant(*operand) && (operand->get_value() != 0) == absorbing)
+                return constant(absorbing, expr);
+        }
+        if (is_constant(left))
+            return truth(right);
+        if (is_constant(right))
+            return truth(left);
+        if (left.equal(expr[0]) && right.equal(expr[1]))
+            return expr;
+        return expression_t::create_binary(kind, left, right, expr.get_position(), expr.get_type());
+    }
+    case INLINE_IF: {
+        auto condition = fold_constants(expr[0], evaluator);
+        if (is_constant(condition))
+            return fold_constants(condition.get_value() != 0 ? expr[1] : expr[2], evaluator);
+        break;
+    }
+    default: break;
+    }
+    return expr.rewrite_children([&evaluator](const expression_t& sub) { return fold_constants(sub, evaluator); });
+}
+
+namespace {
+class Simplifier
+{
+    std::vector<simplification_t>& changes;
+    const template_t* templ{nullptr};
+    ConstantEvaluator evaluator{};
+
+    void fold(expression_t& expr)
+    {
+        auto result = fold_constants(expr, evaluator);
+        if (result.equal(expr))
+            return;
+        changes.push_back({simplification_kind_t::Folded, templ, expr.get_position(), expr.str(),
+                           result.empty() ? std::string{} : result.str()});
+        expr = result;
+    }
+
+    /** Folds the updates of an assignment list and drops those without effect. */
+    expression_t updates(const expression_t& expr)
+    {
+        if (expr.empty() || expr.get_kind() != COMMA) {
+            auto result = expr;
+            fold(result);
+            return result;
+        }
+        auto left = updates(expr[0]);
+        auto right = updates(expr[1]);
+        if (is_constant(left))
+            return right;
+        if (is_constant(right))
+            return left;
+        if (left.equal(expr[0]) && right.equal(expr[1]))
+            return expr;
+        return expression_t::create_binary(COMMA, left, right, expr.get_position(), expr.get_type());
+    }
+
+    void reachability(template_t& templ)
+    {
+        auto reached = std::vector<bool>(templ.locations.size() + templ.branchpoints.size());
+        auto node = [&templ](const location_t* location, const branchpoint_t* branchpoint) -> std::optional<size_t> {
+            if (location != nullptr)
+                return location->nr;
+            if (branchpoint != nullptr)
+                return templ.locations.size() + branchpoint->bpNr;
+            return std::nullopt;
+        };
+        const auto* init = static_cast<const location_t*>(templ.init.get_data());
+        if (init == nullptr)
+            return;
+        auto successors = std::vector<std::vector<size_t>>(reached.size());
+        for (const auto& edge : templ.edges)
+            if (auto source = node(edge.src, edge.srcb), target = node(edge.dst, edge.dstb); source && target)
+                successors[*source].push_back(*target);
+        auto waiting = std::deque<size_t>{static_cast<size_t>(init->nr)};
+        reached[init->nr] = true;
+        while (!waiting.empty()) {
+            auto current = waiting.front();
+            waiting.pop_front();
+            for (auto target : successors[current]) {
+                if (!reached[target]) {
+                    reached[target] = true;
+                    waiting.push_back(target);
+                }
+            }
+        }
+        for (const auto& location : templ.locations) {
+            if (reached[location.nr])
+                continue;
+            changes.push_back({simplification_kind_t::UnreachableLocation, &templ, location.uid.get_position(),
+                               location.uid.get_name(), {}});
+        }
+        auto kept = std::deque<edge_t>{};
+        for (auto& edge : templ.edges)
+            if (auto source = node(edge.src, edge.srcb); !source || reached[*source])
+                kept.push_back(std::move(edge));
+        templ.edges = std::move(kept);
+    }
+
+public:
+    explicit Simplifier(std::vector<simplification_t>& changes): changes{changes} {}
+
+    void simplify(template_t& templ)
+    {
+        this->templ = &templ;
+        for (auto& location : templ.locations) {
+            fold(location.invariant);
+            if (is_constant(location.invariant) && location.invariant.get_value() != 0)
+                location.invariant = expression_t{};
+        }
+        auto kept = std::deque<edge_t>{};
+        for (auto& edge : templ.edges) {
+            auto guard = edge.guard;
+            fold(edge.guard);
+            if (is_constant(edge.guard) && edge.guard.get_value() == 0) {
+                changes.push_back({simplification_kind_t::RemovedEdge, &templ, guard.get_position(), guard.str(), {}});
+                continue;
+            }
+            if (is_constant(edge.guard))
+                edge.guard = expression_t{};
+            fold(edge.sync);
+            edge.assign = updates(edge.assign);
+            kept.push_back(std::move(edge));
+        }
+        templ.edges = std::move(kept);
+        reachability(templ);
+        auto nr = 0;
+        for (auto& edge : templ.edges)
+            edge.nr = nr++;
+    }
+};
+}  // namespace
+
+std::vector<simplification_t> UTAP::simplify(Document& document)
+{
+    auto changes = std::vector<simplification_t>{};
+    auto simplifier = Simplifier{changes};
+    for (auto& templ : document.get_templates())
+        simplifier.simplify(templ);
+    for (auto* templ : document.get_dynamic_templates())
+        simplifier.simplify(*templ);
+    document.reset_analyses();
+    return changes;
+}
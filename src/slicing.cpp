@@ -0,0 +1,188 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/slicing.h"
+
+#include <vector>
+
+using namespace UTAP;
+using namespace Constants;
+
+/** Splits an assignment list into its updates. */
+static void split(const expression_t& expr, std::vector<expression_t>& updates)
+{
+    if (expr.empty())
+        return;
+    if (expr.get_kind() == COMMA) {
+        split(expr[0], updates);
+        split(expr[1], updates);
+    } else {
+        updates.push_back(expr);
+    }
+}
+
+static bool is_broadcast_send(const edge_t& edge)
+{
+    return edge.sync.get_sync() == SYNC_BANG && edge.sync[0].get_type().is(BROADCAST);
+}
+
+/** Returns true if the property only depends on the reachable states. */
+static bool is_safety(const expression_t& property)
+{
+    return !property.empty() && (property.get_kind() == EF || property.get_kind() == AG);
+}
+
+Slice::variable_t Slice::resolve(const instance_t* process, const symbol_t& symbol) const
+{
+    if (process == nullptr)
+        return {nullptr, symbol};
+    // reference parameters stand for the global argument
+    if (auto it = process->mapping.find(symbol); it != process->mapping.end())
+        return {nullptr, it->second.get_symbol()};
+    if (process->templ->frame.contains(symbol))
+        return {process, symbol};
+    return {nullptr, symbol};
+}
+
+void Slice::use(const instance_t* process, const symbol_t& symbol)
+{
+    auto type = symbol.get_type();
+    if (type.is_process() || type.is(PROCESS_SET)) {
+        if (const auto* data = symbol.get_data(); data != nullptr)
+            add(*static_cast<const instance_t*>(data));
+        return;
+    }
+    if (process != nullptr) {
+        // parameters stand for the arguments, which are global
+        if (auto it = process->mapping.find(symbol); it != process->mapping.end()) {
+            read(it->second, nullptr);
+            return;
+        }
+    }
+    if (variables.insert(resolve(process, symbol)).second && type.strip_array().is_clock())
+        has_clocks = true;
+}
+
+void Slice::read(const expression_t& expr, const instance_t* process)
+{
+    if (expr.empty())
+        return;
+    auto symbols = std::set<symbol_t>{};
+    expr.collect_possible_reads(symbols);
+    for (const auto& symbol : symbols)
+        use(process, symbol);
+    members(expr);
+}
+
+void Slice::members(const expression_t& expr)
+{
+    // members of other processes, e.g. P.x in properties
+    if (expr.get_kind() == DOT && expr[0].get_type().is_process()) {
+        if (const auto* data = expr[0].get_symbol().get_data(); data != nullptr) {
+            const auto& other = *static_cast<const instance_t*>(data);
+            auto member = other.templ->frame[expr.get_index()];
+            if (!member.get_type().is_location())
+                use(&other, member);
+        }
+    }
+    for (uint32_t i = 0; i < expr.get_size(); ++i)
+        members(expr[i]);
+}
+
+bool Slice::writes(const expression_t& expr, const instance_t& process) const
+{
+    auto symbols = std::set<symbol_t>{};
+    expr.collect_possible_writes(symbols);
+    for (const auto& symbol : symbols)
+        if (variables.count(resolve(&process, symbol)) > 0)
+            return true;
+    return false;
+}
+
+void Slice::add(const instance_t& process) { processes.insert(&process); }
+
+bool Slice::is_relevant_update(const instance_t& process, const expression_t& update) const
+{
+    return is_relevant(process) && (complete || writes(update, process));
+}
+
+Slice::Slice(Document& document, const expression_t& property)
+{
+    complete = !is_safety(property) || document.has_priority_declaration();
+    if (complete) {
+        for (const auto& process : document.get_processes())
+            add(process);
+        return;
+    }
+    for (const auto& process : document.get_processes()) {
+        if (process.templ == nullptr)
+            continue;
+        if (property.contains_deadlock())
+            add(process);
+        for (const auto& location : process.templ->locations)
+            if (location.uid.get_type().is(COMMITTED))
+                add(process);
+    }
+    read(property, nullptr);
+
+    auto size = [this] { return processes.size() + variables.size(); };
+    auto before = size_t{0};
+    do {
+        before = size();
+        for (const auto& process : document.get_processes()) {
+            if (process.templ == nullptr)
+                continue;
+            const auto& templ = *process.templ;
+            if (!is_relevant(process)) {
+                for (const auto& edge : templ.edges) {
+                    if (writes(edge.assign, process))
+                        add(process);
+                    if (!edge.sync.empty()) {
+                        // broadcast receivers do not influence the sender
+                        auto relevant = variables.count(resolve(&process, edge.sync[0].get_symbol())) > 0;
+                        if (relevant && (is_broadcast_send(edge) || !edge.sync[0].get_type().is(BROADCAST)))
+                            add(process);
+                    }
+                }
+                for (const auto& location : templ.locations)
+                    if (has_clocks && (!location.invariant.empty() || location.uid.get_type().is(URGENT)))
+                        add(process);
+                for (const auto& edge : templ.edges)
+                    if (has_clocks && !edge.sync.empty() && edge.sync[0].get_type().is(URGENT))
+                        add(process);  // prevents delays while enabled
+                if (!is_relevant(process))
+                    continue;
+            }
+            for (const auto& location : templ.locations)
+                read(location.invariant, &process);
+            for (const auto& edge : templ.edges) {
+                read(edge.guard, &process);
+                if (!edge.sync.empty() && !is_broadcast_send(edge))
+                    read(edge.sync, &process);
+                auto updates = std::vector<expression_t>{};
+                split(edge.assign, updates);
+                for (const auto& update : updates)
+                    if (writes(update, process))
+                        read(update, &process);
+            }
+        }
+    } while (size() != before);
+}
@@ -0,0 +1,130 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/specialiser.h"
+
+#include "utap/evaluator.h"
+#include "utap/simplifier.h"
+
+#include <sstream>
+
+using namespace UTAP;
+using namespace Constants;
+
+using arguments_t = std::map<symbol_t, expression_t>;
+
+/** Replaces the parameters by their arguments, sharing the subexpressions without parameters. */
+static expression_t substitute(const expression_t& expr, const arguments_t& arguments)
+{
+    if (expr.empty() || arguments.empty())
+        return expr;
+    if (expr.get_kind() == IDENTIFIER) {
+        auto it = arguments.find(expr.get_symbol());
+        return it != arguments.end() ? it->second : expr;
+    }
+    return expr.rewrite_children([&arguments](const expression_t& sub) { return substitute(sub, arguments); });
+}
+
+/** Returns the residual template, the generic one if the process is nullptr. */
+static residual_template_t specialise(const template_t& templ, const instance_t* process)
+{
+    // value parameters are variables of the process, thus not substituted
+    auto arguments = arguments_t{};
+    if (process != nullptr) {
+        for (const auto& [parameter, argument] : process->mapping)
+            if (auto type = parameter.get_type(); type.is(REF) || type.is_constant())
+                arguments.emplace(parameter, argument);
+    }
+    const auto evaluator = ConstantEvaluator{};
+    auto residual = residual_template_t{&templ, {}, {}, 0, process == nullptr};
+    auto fold = [&](const expression_t& expr) {
+        auto result = fold_constants(substitute(expr, arguments), evaluator);
+        if (!result.empty() && result.get_kind() == CONSTANT && result.get_value() != 0 && !result.get_type().is(INT))
+            result = expression_t{};  // true
+        residual.size += result.count_nodes();
+        return result;
+    };
+    residual.invariants.resize(templ.locations.size());
+    for (const auto& location : templ.locations)
+        residual.invariants[location.nr] = fold(location.invariant);
+    for (const auto& edge : templ.edges) {
+        auto guard = fold(edge.guard);
+        if (!guard.empty() && guard.get_kind() == CONSTANT && guard.get_value() == 0)
+            continue;
+        residual.edges.push_back({&edge, guard, fold(edge.sync), fold(edge.assign)});
+    }
+    return residual;
+}
+
+/** Returns the text of the residual code, equal for residual templates which may be shared. */
+static std::string signature(const residual_template_t& residual)
+{
+    auto os = std::ostringstream{};
+    auto print = [&os](const expression_t& expr) {
+        if (!expr.empty())
+            expr.print(os);
+        os << ';';
+    };
+    for (const auto& invariant : residual.invariants)
+        print(invariant);
+    for (const auto& edge : residual.edges) {
+        os << edge.edge->nr << ':';
+        print(edge.guard);
+        print(edge.sync);
+        print(edge.assign);
+    }
+    return os.str();
+}
+
+Specialiser::Specialiser(Document& document, limits_t limits): limits{limits}
+{
+    for (const auto& process : document.get_processes()) {
+        if (process.templ == nullptr)
+            continue;
+        auto residual = specialise(*process.templ, &process);
+        auto key = std::make_pair(residual.templ, signature(residual));
+        if (auto it = shared.find(key); it != shared.end()) {
+            residuals.emplace(&process, it->second);
+            continue;
+        }
+        auto& count = variants[residual.templ];
+        if (count >= limits.variants || size + residual.size > limits.size) {
+            residuals.emplace(&process, &get_generic(*process.templ));
+            continue;
+        }
+        ++count;
+        size += residual.size;
+        residuals.emplace(&process, shared.emplace(std::move(key), add(std::move(residual))).first->second);
+    }
+}
+
+const residual_template_t& Specialiser::get_generic(const template_t& templ)
+{
+    auto& residual = generic[&templ];
+    if (residual == nullptr)
+        residual = add(specialise(templ, nullptr));
+    return *residual;
+}
+
+const residual_template_t* Specialiser::add(residual_template_t&& residual)
+{
+    return &templates.emplace_back(std::move(residual));
+}
@@ -0,0 +1,309 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/statelayout.h"
+
+#include "utap/evaluator.h"
+#include "utap/valueranges.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+using namespace UTAP;
+using namespace Constants;
+
+static uint32_t bits_for(uint32_t span)
+{
+    uint32_t width = 0;
+    while (width < 32 && (span >> width) != 0)
+        ++width;
+    return width;
+}
+
+namespace {
+/** Flattens the variables of one process (or the globals) into fields. */
+class Flattener
+{
+    std::vector<layout_field_t>& fields;
+    std::vector<layout_field_t>& clocks;
+    const ConstantEvaluator& evaluator;
+    const ValueRanges* ranges;
+    const instance_t* process;
+    std::vector<int32_t> arguments;
+    std::vector<int32_t> path;
+
+    int32_t evaluate(const expression_t& expr) const
+    {
+        auto value = evaluator.evaluate(expr);
+        if (!value)
+            throw std::logic_error("Not computable at compile time: " + expr.str());
+        return *value;
+    }
+
+    layout_field_t& add(std::vector<layout_field_t>& to, const std::string& name, const symbol_t& symbol)
+    {
+        auto& field = to.emplace_back();
+        field.name = name;
+        field.process = process;
+        field.arguments = arguments;
+        field.symbol = symbol;
+        field.path = path;
+        return field;
+    }
+
+    void add(const std::string& name, const symbol_t& symbol, int32_t lower, int32_t upper)
+    {
+        auto& field = add(fields, name, symbol);
+        field.lower = lower;
+        field.upper = upper;
+        field.width = bits_for(static_cast<uint32_t>(int64_t{upper} - lower));
+    }
+
+public:
+    Flattener(std::vector<layout_field_t>& fields, std::vector<layout_field_t>& clocks,
+              const ConstantEvaluator& evaluator, const ValueRanges* ranges, const instance_t* process,
+              std::vector<int32_t> arguments = {}):
+        fields{fields}, clocks{clocks}, evaluator{evaluator}, ranges{ranges}, process{process},
+        arguments{std::move(arguments)}
+    {}
+
+    void flatten(const symbol_t& symbol, const type_t& type, const std::string& name)
+    {
+        if (type.is_constant())
+            return;
+        if (type.is_array()) {
+            auto size = type.get_array_size();
+            if (!size.is_range())
+                throw std::logic_error("Array size is not a range: " + name);
+            auto [first, last] = size.get_range();
+            auto count = int64_t{evaluate(last)} - evaluate(first) + 1;
+            for (int64_t i = 0; i < count; ++i) {
+                path.push_back(static_cast<int32_t>(i));
+                flatten(symbol, type.get_sub(), name + "[" + std::to_string(i) + "]");
+                path.pop_back();
+            }
+        } else if (type.is_record()) {
+            for (uint32_t i = 0; i < type.get_record_size(); ++i) {
+                path.push_back(static_cast<int32_t>(i));
+                flatten(symbol, type.get_sub(i), name + "." + type.get_record_label(i));
+                path.pop_back();
+            }
+        } else if (type.is_clock()) {
+            add(clocks, name, symbol);
+        } else if (type.is(BOOL)) {
+            add(name, symbol, 0, 1);
+        } else if ((type.is_integral() || type.is_scalar()) && type.is_range()) {
+            auto [first, last] = type.get_range();
+            auto lower = evaluate(first);
+            auto upper = evaluate(last);
+            if (ranges != nullptr && !symbol.get_type().is_record()) {
+                if (auto values = ranges->get_range(symbol); values && !values->empty()) {
+                    lower = std::max(lower, values->first());
+                    upper = std::min(upper, values->last());
+                }
+            }
+            add(name, symbol, lower, upper);
+        } else if (type.is_double() || type.is_integral() || type.is_scalar()) {
+            // the state would be incomplete without them
+            throw std::logic_error("Variable not representable in the state vector: " + name);
+        }
+    }
+
+    void location(const std::string& name, size_t count)
+    {
+        add(name, process->uid, 0, static_cast<int32_t>(count == 0 ? 0 : count - 1));
+    }
+};
+}  // namespace
+
+StateLayout::StateLayout(Document& document, const ValueRanges* ranges)
+{
+    auto global_evaluator = ConstantEvaluator{};
+    auto globals = Flattener{fields, clocks, global_evaluator, ranges, nullptr};
+    for (const auto& var : document.get_globals().variables)
+        globals.flatten(var.uid, var.uid.get_type(), var.uid.get_name());
+    for (const auto& process : document.get_processes()) {
+        if (process.templ == nullptr)
+            continue;
+        for (auto& arguments : enumerate_arguments(process)) {
+            // bind the unbound parameters of a process set to the arguments of the element
+            auto element = process;
+            auto prefix = process.uid.get_name();
+            for (size_t i = 0; i < arguments.size(); ++i) {
+                element.mapping[process.parameters[i]] = expression_t::create_constant(arguments[i]);
+                prefix += (i == 0 ? "(" : ",") + std::to_string(arguments[i]) + (i + 1 == arguments.size() ? ")" : "");
+            }
+            auto evaluator = ConstantEvaluator{element};
+            auto local = Flattener{fields, clocks, evaluator, ranges, &process, std::move(arguments)};
+            local.location(prefix + ".location", process.templ->locations.size());
+            // by-value parameters which are not constant are variables of the process
+            for (const auto& parameter : process.templ->parameters)
+                if (auto type = parameter.get_type(); !type.is(REF))
+                    local.flatten(parameter, type, prefix + "." + parameter.get_name());
+            for (const auto& var : process.templ->variables)
+                local.flatten(var.uid, var.uid.get_type(), prefix + "." + var.uid.get_name());
+        }
+    }
+    plan();
+}
+
+std::vector<std::vector<int32_t>> StateLayout::enumerate_arguments(const instance_t& process)
+{
+    auto evaluator = ConstantEvaluator{process};
+    auto result = std::vector<std::vector<int32_t>>{{}};
+    for (size_t i = 0; i < process.unbound; ++i) {
+        auto type = process.parameters[i].get_type();
+        if (!type.is_range())
+            throw std::logic_error("Unbounded parameter of " + process.uid.get_name());
+        auto [first, last] = type.get_range();
+        auto lower = evaluator.evaluate(first);
+        auto upper = evaluator.evaluate(last);
+        if (!lower || !upper)
+            throw std::logic_error("Not computable at compile time: " + type.str());
+        auto next = std::vector<std::vector<int32_t>>{};
+        for (const auto& prefix : result) {
+            for (auto value = *lower; value <= *upper; ++value) {
+                next.push_back(prefix);
+                next.back().push_back(value);
+            }
+        }
+        result = std::move(next);
+    }
+    return result;
+}
+
+void StateLayout::plan()
+{
+    // Packed: first fit decreasing by width, a field never straddles two words
+    auto order = std::vector<size_t>(fields.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [this](size_t a, size_t b) { return fields[a].width > fields[b].width; });
+    auto free_bits = std::vector<uint32_t>{};
+    for (auto i : order) {
+        auto& field = fields[i];
+        if (field.width == 0)
+            continue;  // a single value needs no storage
+        auto fits = [&field](uint32_t free) { return free >= field.width; };
+        auto word = std::find_if(free_bits.begin(), free_bits.end(), fits);
+        if (word == free_bits.end())
+            word = free_bits.insert(free_bits.end(), 64);
+        field.bit_offset = static_cast<uint32_t>(word - free_bits.begin()) * 64 + (64 - *word);
+        *word -= field.width;
+    }
+    packed_words = free_bits.size();
+
+    // Byte aligned: the same order is also by decreasing alignment class
+    uint32_t offset = 0;
+    uint32_t alignment = 1;
+    for (auto i : order) {
+        auto& field = fields[i];
+        field.bytes = field.width == 0 ? 0 : field.width <= 8 ? 1 : field.width <= 16 ? 2 : 4;
+        field.byte_offset = offset;
+        offset += field.bytes;
+        alignment = std::max(alignment, field.bytes);
+    }
+    aligned_bytes = (offset + alignment - 1) / alignment * alignment;
+}
+
+int32_t StateLayout::get(const uint64_t* packed, size_t index) const
+{
+    const auto& field = fields[index];
+    if (field.width == 0)
+        return field.lower;
+    auto word = packed[field.bit_offset / 64] >> (field.bit_offset % 64);
+    auto mask = (uint64_t{1} << field.width) - 1;
+    return static_cast<int32_t>(int64_t{field.lower} + static_cast<int64_t>(word & mask));
+}
+
+void StateLayout::set(uint64_t* packed, size_t index, int32_t value) const
+{
+    const auto& field = fields[index];
+    assert(field.lower <= value && value <= field.upper);
+    if (field.width == 0)
+        return;
+    auto shift = field.bit_offset % 64;
+    auto mask = ((uint64_t{1} << field.width) - 1) << shift;
+    auto bits = static_cast<uint64_t>(int64_t{value} - field.lower) << shift;
+    auto& word = packed[field.bit_offset / 64];
+    word = (word & ~mask) | bits;
+}
+
+void StateLayout::pack(const int32_t* values, uint64_t* packed) const
+{
+    std::fill(packed, packed + packed_words, 0);
+    for (size_t i = 0; i < fields.size(); ++i) {
+        const auto& field = fields[i];
+        assert(field.lower <= values[i] && values[i] <= field.upper);
+        if (field.width != 0)
+            packed[field.bit_offset / 64] |= static_cast<uint64_t>(int64_t{values[i]} - field.lower)
+                                             << (field.bit_offset % 64);
+    }
+}
+
+void StateLayout::unpack(const uint64_t* packed, int32_t* values) const
+{
+    for (size_t i = 0; i < fields.size(); ++i)
+        values[i] = get(packed, i);
+}
+
+void StateLayout::pack_aligned(const int32_t* values, uint8_t* aligned) const
+{
+    std::fill(aligned, aligned + aligned_bytes, 0);
+    for (size_t i = 0; i < fields.size(); ++i) {
+        const auto& field = fields[i];
+        assert(field.lower <= values[i] && values[i] <= field.upper);
+        auto bits = static_cast<uint32_t>(int64_t{values[i]} - field.lower);
+        switch (field.bytes) {
+        case 0: break;
+        case 1: aligned[field.byte_offset] = static_cast<uint8_t>(bits); break;
+        case 2: {
+            auto value = static_cast<uint16_t>(bits);
+            std::memcpy(aligned + field.byte_offset, &value, sizeof value);
+            break;
+        }
+        default: std::memcpy(aligned + field.byte_offset, &bits, sizeof bits);
+        }
+    }
+}
+
+void StateLayout::unpack_aligned(const uint8_t* aligned, int32_t* values) const
+{
+    for (size_t i = 0; i < fields.size(); ++i) {
+        const auto& field = fields[i];
+        uint32_t bits = 0;
+        switch (field.bytes) {
+        case 0: break;
+        case 1: bits = aligned[field.byte_offset]; break;
+        case 2: {
+            uint16_t value;
+            std::memcpy(&value, aligned + field.byte_offset, sizeof value);
+            bits = value;
+            break;
+        }
+        default: std::memcpy(&bits, aligned + field.byte_offset, sizeof bits);
+        }
+        values[i] = static_cast<int32_t>(int64_t{field.lower} + bits);
+    }
+}
@@ -350,3 +350,9 @@ void CollectDynamicExpressions::visitExpression(expression_t expr)
     if (expr.is_dynamic() || expr.has_dynamic_sub())
         expressions.push_back(expr);
 }
+
+void ExpressionVisitorPipeline::visitExpression(expression_t expr)
+{
+    for (auto* visitor : visitors)
+        visitor->visitExpression(expr);
+}
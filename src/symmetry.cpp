@@ -0,0 +1,253 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/symmetry.h"
+
+#include "utap/evaluator.h"
+
+#include <algorithm>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+
+using namespace UTAP;
+using namespace Constants;
+
+/**
+ * Returns the internal label the parser gives to the scalarset of the
+ * type, see ExpressionBuilder::type_scalar, nothing if the type is not a
+ * scalarset or a scalarset local to a template.
+ */
+static std::optional<std::string> scalarset_label(type_t type)
+{
+    while (!type.unknown()) {
+        auto kind = type.get_kind();
+        if (kind == LABEL) {
+            const auto& label = type.get_label(0);
+            if (label.size() > 1 && label.compare(label.size() - 2, 2, "::") == 0)
+                return std::nullopt;  // declared in a template
+            if (label.rfind("#scalarset", 0) == 0)
+                return label;
+        } else if (kind == SCALAR || !(type.is_prefix() || kind == REF || kind == RANGE)) {
+            return std::nullopt;
+        }
+        type = type[0];
+    }
+    return std::nullopt;
+}
+
+template <typename T>
+static void add_unique(std::vector<T>& elements, const T& element)
+{
+    if (std::find(elements.begin(), elements.end(), element) == elements.end())
+        elements.push_back(element);
+}
+
+Symmetry::Symmetry(Document& document)
+{
+    // name the scalarsets after their typedefs, in the order of declaration
+    for (const auto& symbol : document.get_globals().frame) {
+        if (symbol.get_type().get_kind() != TYPEDEF)
+            continue;
+        if (auto set = add(symbol.get_type()[0]); set && scalarsets[*set].name.empty())
+            scalarsets[*set].name = symbol.get_name();
+    }
+    for (const auto& var : document.get_globals().variables)
+        collect(var.uid, var.uid.get_type());
+    auto templates = std::set<const template_t*>{};
+    for (const auto& process : document.get_processes()) {
+        if (process.templ == nullptr)
+            continue;
+        for (size_t i = 0; i < process.unbound; ++i)
+            if (auto set = add(process.parameters[i].get_type()))
+                add_unique(scalarsets[*set].processes, &process);
+        if (templates.insert(process.templ).second)
+            for (const auto& var : process.templ->variables)
+                collect(var.uid, var.uid.get_type());
+    }
+}
+
+std::optional<size_t> Symmetry::find(const type_t& type) const
+{
+    auto label = scalarset_label(type);
+    if (!label)
+        return std::nullopt;
+    auto it = index.find(*label);
+    if (it == index.end())
+        return std::nullopt;
+    return it->second;
+}
+
+std::optional<size_t> Symmetry::add(const type_t& type)
+{
+    auto label = scalarset_label(type);
+    if (!label)
+        return std::nullopt;
+    auto [it, inserted] = index.emplace(*label, scalarsets.size());
+    if (inserted) {
+        auto [first, last] = type.get_range();
+        auto evaluator = ConstantEvaluator{};
+        auto lower = evaluator.evaluate(first);
+        auto upper = evaluator.evaluate(last);
+        if (!lower || !upper)
+            throw std::logic_error("Not computable at compile time: " + type.str());
+        scalarsets.emplace_back().size = *upper - *lower + 1;
+    }
+    return it->second;
+}
+
+void Symmetry::collect(const symbol_t& variable, const type_t& type)
+{
+    if (type.is_array()) {
+        if (auto set = add(type.get_array_size()))
+            add_unique(scalarsets[*set].arrays, variable);
+        collect(variable, type.get_sub());
+    } else if (type.is_record()) {
+        for (uint32_t i = 0; i < type.get_record_size(); ++i)
+            collect(variable, type.get_sub(i));
+    } else if (auto set = add(type)) {
+        add_unique(scalarsets[*set].values, variable);
+    }
+}
+
+/** Finds the coordinates of the field in the scalarset, returns true if the field holds an element of it. */
+static bool coordinates(const Symmetry& symmetry, size_t set, const layout_field_t& field,
+                        std::vector<size_t>& arguments, std::vector<size_t>& path)
+{
+    for (size_t i = 0; i < field.arguments.size(); ++i)
+        if (symmetry.find(field.process->parameters[i].get_type()) == set)
+            arguments.push_back(i);
+    auto type = field.symbol.get_type();
+    for (size_t i = 0; i < field.path.size(); ++i) {
+        if (type.is_array()) {
+            if (symmetry.find(type.get_array_size()) == set)
+                path.push_back(i);
+            type = type.get_sub();
+        } else {
+            type = type.get_sub(field.path[i]);
+        }
+    }
+    return !type.is_array() && !type.is_record() && symmetry.find(type) == set;
+}
+
+Canonicaliser::Canonicaliser(const Symmetry& symmetry, const StateLayout& layout): layout{layout}
+{
+    const auto& fields = layout.get_fields();
+    const auto& clocks = layout.get_clocks();
+    for (size_t i = 0; i < fields.size(); ++i)
+        field_keys.emplace(key_t{fields[i].process, fields[i].arguments, fields[i].symbol, fields[i].path}, i);
+    for (size_t i = 0; i < clocks.size(); ++i)
+        clock_keys.emplace(key_t{clocks[i].process, clocks[i].arguments, clocks[i].symbol, clocks[i].path}, i);
+
+    const auto& scalarsets = symmetry.get_scalarsets();
+    for (size_t set = 0; set < scalarsets.size(); ++set) {
+        auto& permutation = permutations.emplace_back();
+        permutation.blocks.resize(scalarsets[set].size);
+        permutation.clock_blocks.resize(scalarsets[set].size);
+        auto classify = [&](const layout_field_t& field, size_t i, std::vector<std::vector<size_t>>& blocks,
+                            std::vector<shared_t>& shared) {
+            auto at = coordinates_t{};
+            auto holds_element = coordinates(symmetry, set, field, at.arguments, at.path);
+            if (at.count() == 1) {
+                auto element = at.arguments.empty() ? field.path[at.path[0]] : field.arguments[at.arguments[0]];
+                blocks.at(element).push_back(i);
+            } else if (at.count() > 1) {
+                shared.push_back({i, std::move(at)});
+            }
+            return holds_element;
+        };
+        for (size_t i = 0; i < fields.size(); ++i)
+            if (classify(fields[i], i, permutation.blocks, permutation.shared))
+                permutation.renamed.push_back(i);
+        for (size_t i = 0; i < clocks.size(); ++i)
+            classify(clocks[i], i, permutation.clock_blocks, permutation.shared_clocks);
+
+        // the elements are interchangeable, thus the blocks have the same shape
+        for (const auto* blocks : {&permutation.blocks, &permutation.clock_blocks})
+            for (const auto& block : *blocks)
+                if (block.size() != blocks->front().size())
+                    throw std::logic_error("Asymmetric layout of scalarset " + scalarsets[set].name);
+    }
+}
+
+size_t Canonicaliser::move(const std::map<key_t, size_t>& keys, const layout_field_t& field,
+                           const coordinates_t& coordinates, const std::vector<int32_t>& rename)
+{
+    auto arguments = field.arguments;
+    auto path = field.path;
+    for (auto i : coordinates.arguments)
+        arguments[i] = rename[arguments[i]];
+    for (auto i : coordinates.path)
+        path[i] = rename[path[i]];
+    return keys.at(key_t{field.process, std::move(arguments), field.symbol, std::move(path)});
+}
+
+void Canonicaliser::canonicalise(uint64_t* packed, std::vector<uint32_t>* clocks) const
+{
+    const auto& fields = layout.get_fields();
+    auto values = std::vector<int32_t>(fields.size());
+    layout.unpack(packed, values.data());
+    if (clocks != nullptr) {
+        clocks->resize(layout.get_clocks().size() + 1);
+        std::iota(clocks->begin(), clocks->end(), 0);
+    }
+
+    for (const auto& permutation : permutations) {
+        const auto& blocks = permutation.blocks;
+        auto order = std::vector<size_t>(blocks.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            for (size_t i = 0; i < blocks[a].size(); ++i)
+                if (values[blocks[a][i]] != values[blocks[b][i]])
+                    return values[blocks[a][i]] < values[blocks[b][i]];
+            return false;
+        });
+        auto rename = std::vector<int32_t>(order.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            rename[order[i]] = static_cast<int32_t>(i);
+        if (std::is_sorted(order.begin(), order.end()))
+            continue;
+
+        auto next = values;
+        for (size_t element = 0; element < blocks.size(); ++element)
+            for (size_t i = 0; i < blocks[element].size(); ++i)
+                next[blocks[rename[element]][i]] = values[blocks[element][i]];
+        for (const auto& [i, at] : permutation.shared)
+            next[move(field_keys, fields[i], at, rename)] = values[i];
+        for (auto i : permutation.renamed)
+            if (0 <= next[i] && next[i] < static_cast<int32_t>(rename.size()))
+                next[i] = rename[next[i]];
+        values = std::move(next);
+
+        if (clocks != nullptr) {
+            // index 0 is the reference clock
+            const auto& clock_blocks = permutation.clock_blocks;
+            auto next_clocks = *clocks;
+            for (size_t element = 0; element < clock_blocks.size(); ++element)
+                for (size_t i = 0; i < clock_blocks[element].size(); ++i)
+                    next_clocks[clock_blocks[rename[element]][i] + 1] = (*clocks)[clock_blocks[element][i] + 1];
+            for (const auto& [i, at] : permutation.shared_clocks)
+                next_clocks[move(clock_keys, layout.get_clocks()[i], at, rename) + 1] = (*clocks)[i + 1];
+            *clocks = std::move(next_clocks);
+        }
+    }
+    layout.pack(values.data(), packed);
+}
@@ -200,6 +200,13 @@ void CompileTimeComputableValues::visitInstance(instance_t& temp)
     }
 }
 
+bool CompileTimeComputableValues::visitTemplateBefore(template_t& templ)
+{
+    // Collect the parameters up front such that the template body can be checked in the same traversal
+    visitInstance(templ);
+    return true;
+}
+
 void CompileTimeComputableValues::add_symbol(symbol_t symbol) { variables.insert(symbol); }
 
 bool CompileTimeComputableValues::contains(symbol_t symbol) const
@@ -288,6 +295,19 @@ TypeChecker::TypeChecker(Document& document, bool refinement): document{document
     temp = nullptr;
 }
 
+TypeChecker::TypeChecker(Document& document, DocumentVisitorPipeline& pipeline, bool refinement):
+    document{document}, syncUsed(0)
+{
+    // Template parameters are collected in visitTemplateBefore, hence the compile time computable values are known
+    // element by element and only the system wide updates need to wait for the end of the traversal.
+    pipeline.add(compileTimeComputableValues).add(*this);
+    deferUpdates = true;
+
+    function = nullptr;
+    refinementWarnings = refinement;
+    temp = nullptr;
+}
+
 template <class T>
 void TypeChecker::handleWarning(T expr, const std::string& msg)
 {
@@ -467,6 +487,10 @@ void TypeChecker::checkType(type_t type, bool initialisable, bool inStruct)
 
 void TypeChecker::visitDocAfter(Document& doc)
 {
+    if (deferUpdates) {
+        checkExpression(doc.get_before_update());
+        checkExpression(doc.get_after_update());
+    }
     for (const chan_priority_t& i : doc.get_chan_priorities()) {
         bool i_default = (i.head == expression_t());
         if (!i_default && checkExpression(i.head)) {
@@ -1223,29 +1247,35 @@ void TypeChecker::visitFunction(function_t& fun)
     fun.body->accept(this);
     function = nullptr;
 
-    /* Check if there are dynamic expressions in the function body*/
-    checkDynamicExpressions(fun.body.get());
-
-    /* Collect identifiers of things external to the function accessed
-     * or changed by the function. Notice that neither local variables
-     * nor parameters are considered to be changed or accessed by a
-     * function.
+    /* Collect dynamic expressions in the function body together with
+     * identifiers of things external to the function accessed or
+     * changed by the function, all in a single walk of the body.
+     * Notice that neither local variables nor parameters are considered
+     * to be changed or accessed by a function.
      */
-    CollectChangesVisitor visitor(fun.changes);
-    fun.body->accept(&visitor);
+    std::list<expression_t> dynamic;
+    CollectDynamicExpressions collect_dynamic{dynamic};
+    CollectChangesVisitor collect_changes{fun.changes};
+    CollectDependenciesVisitor collect_depends{fun.depends};
+    ExpressionVisitorPipeline collectors{&collect_dynamic, &collect_changes, &collect_depends};
+    fun.body->accept(&collectors);
 
-    CollectDependenciesVisitor visitor2(fun.depends);
-    fun.body->accept(&visitor2);
+    /* Check if there are dynamic expressions in the function body*/
+    checkDynamicExpressions(dynamic);
 
     for (const auto& var : fun.variables) {
         fun.changes.erase(var.uid);
         fun.depends.erase(var.uid);
     }
     size_t parameters = fun.uid.get_type().size() - 1;
+    bool writable_refs = false;
     for (uint32_t i = 0; i < parameters; i++) {
         fun.changes.erase(fun.body->get_frame()[i]);
         fun.depends.erase(fun.body->get_frame()[i]);
+        auto param = fun.uid.get_type()[i + 1];
+        writable_refs |= param.is(REF) && !param.is_constant();
     }
+    fun.has_side_effects = !fun.changes.empty() || writable_refs;
 }
 
 int32_t TypeChecker::visitEmptyStatement(EmptyStatement* stat) { return 0; }
@@ -1339,8 +1369,11 @@ int32_t TypeChecker::visitBlockStatement(BlockStatement* stat)
 
     /* Check statements.
      */
-    for (const auto& s : *stat)
+    for (const auto& s : *stat) {
+        if (isDone())
+            break;
         s->accept(this);
+    }
     return 0;
 }
 
@@ -2597,26 +2630,72 @@ bool TypeChecker::isUniqueReference(expression_t expr) const
     }
 }
 
-static void static_analysis(Document& doc)
+namespace {
+/**
+ * Type checks a parsed document. The global declarations may be
+ * checked ahead of the rest, while the document is still being built.
+ */
+class StaticAnalysis
 {
-    if (!doc.has_errors()) {
-        auto checker = TypeChecker{doc};
-        doc.accept(checker);
-        auto fchecker = FeatureChecker{doc};
+    Document& doc;
+    DocumentVisitorPipeline pipeline;
+    TypeChecker checker{doc, pipeline};
+    FeatureChecker fchecker{doc, pipeline};
+    std::optional<size_t> globals; /**< The number of global declarations checked ahead */
+    size_t errors{0};              /**< The number of errors after checking the global declarations */
+
+public:
+    explicit StaticAnalysis(Document& doc): doc{doc} {}
+
+    /** Checks the global declarations parsed so far unless parsing has failed. */
+    void check_globals()
+    {
+        if (!globals && !doc.has_errors() && !doc.is_truncated()) {
+            globals = pipeline.run_globals(doc);
+            errors = doc.get_errors().size();
+        }
+    }
+
+    /** Checks the rest of the document unless parsing has failed. */
+    void run()
+    {
+        if ((globals ? doc.get_errors().size() != errors : doc.has_errors()) || doc.is_truncated())
+            return;
+        if (globals)
+            pipeline.run(doc, *globals);
+        else
+            pipeline.run(doc);
+        if (doc.is_truncated())
+            return;
         doc.set_supported_methods(fchecker.get_supported_methods());
     }
+};
+}  // namespace
+
+static void static_analysis(Document& doc) { StaticAnalysis{doc}.run(); }
+
+/** Returns PARSE_TRUNCATED if the error budget was exceeded, otherwise the given error code. */
+static int32_t parse_status(const Document& doc, int32_t err)
+{
+    if (err != 0)
+        return err;
+    return doc.is_truncated() ? PARSE_TRUNCATED : 0;
 }
 
-bool parse_XTA(FILE* file, Document* doc, bool newxta)
+bool parse_XTA(FILE* file, Document* doc, bool newxta, std::optional<error_budget_t> budget)
 {
+    if (budget)
+        doc->set_error_budget(*budget);
     DocumentBuilder builder(*doc);
     parse_XTA(file, &builder, newxta);
     static_analysis(*doc);
     return !doc->has_errors();
 }
 
-bool parse_XTA(const char* buffer, Document* doc, bool newxta)
+bool parse_XTA(const char* buffer, Document* doc, bool newxta, std::optional<error_budget_t> budget)
 {
+    if (budget)
+        doc->set_error_budget(*budget);
     DocumentBuilder builder(*doc);
     parse_XTA(buffer, &builder, newxta);
     static_analysis(*doc);
@@ -2624,45 +2703,75 @@ bool parse_XTA(const char* buffer, Document* doc, bool newxta)
 }
 
 int32_t parse_XML_buffer(const char* buffer, Document* doc, bool newxta,
-                         const std::vector<std::filesystem::path>& paths)
+                         const std::vector<std::filesystem::path>& paths, std::optional<error_budget_t> budget)
 {
+    if (budget)
+        doc->set_error_budget(*budget);
     auto builder = DocumentBuilder{*doc, paths};
     int err = parse_XML_buffer(buffer, &builder, newxta);
 
     if (err)
-        return err;
+        return parse_status(*doc, err);
 
     static_analysis(*doc);
 
-    return 0;
+    return parse_status(*doc, 0);
 }
 
-int32_t parse_XML_file(const char* file, Document* doc, bool newxta, const std::vector<std::filesystem::path>& paths)
+int32_t parse_XML_file(const char* file, Document* doc, bool newxta, const std::vector<std::filesystem::path>& paths,
+                       std::optional<error_budget_t> budget)
 {
+    if (budget)
+        doc->set_error_budget(*budget);
     auto builder = DocumentBuilder{*doc, paths};
     int err = parse_XML_file(file, &builder, newxta);
     if (err) {
-        return err;
+        return parse_status(*doc, err);
     }
 
     static_analysis(*doc);
 
-    return 0;
+    return parse_status(*doc, 0);
 }
 
-int32_t parse_XML_fd(int fd, Document* doc, bool newxta, const std::vector<std::filesystem::path>& paths)
+int32_t parse_XML_fd(int fd, Document* doc, bool newxta, const std::vector<std::filesystem::path>& paths,
+                     std::optional<error_budget_t> budget)
 {
+    if (budget)
+        doc->set_error_budget(*budget);
     auto builder = DocumentBuilder{*doc, paths};
     int err = parse_XML_fd(fd, &builder, newxta);
     if (err) {
-        return err;
+        return parse_status(*doc, err);
     }
 
     static_analysis(*doc);
 
-    return 0;
+    return parse_status(*doc, 0);
 }
 
+/** Applies the error budget before the builder is handed to the stream. */
+static std::unique_ptr<ParserBuilder> make_builder(Document& doc, const std::vector<std::filesystem::path>& paths,
+                                                   std::optional<error_budget_t> budget)
+{
+    if (budget)
+        doc.set_error_budget(*budget);
+    return std::make_unique<DocumentBuilder>(doc, paths);
+}
+
+XMLModelStream::XMLModelStream(Document& doc, bool newxta, const std::vector<std::filesystem::path>& paths,
+                               std::optional<error_budget_t> budget):
+    XMLModelStream{make_builder(doc, paths, budget), newxta, [&doc] {
+                       auto analysis = std::make_shared<StaticAnalysis>(doc);
+                       return hooks_t{[analysis] { analysis->check_globals(); }, [&doc, analysis](int32_t err) {
+                                          if (err)
+                                              return parse_status(doc, err);
+                                          analysis->run();
+                                          return parse_status(doc, 0);
+                                      }};
+                   }()}
+{}
+
 expression_t parseExpression(const char* str, Document* doc, bool newxtr)
 {
     ExpressionBuilder builder{*doc};
@@ -2693,13 +2802,10 @@ bool TypeChecker::checkSpawnParameterCompatible(type_t param, expression_t arg)
     return checkParameterCompatible(param, arg);
 }
 
-bool TypeChecker::checkDynamicExpressions(Statement* stat)
+bool TypeChecker::checkDynamicExpressions(const std::list<expression_t>& dynamic)
 {
-    std::list<expression_t> expr_list;
-    CollectDynamicExpressions e(expr_list);
-    stat->accept(&e);
     bool ok = true;
-    for (const auto& expr : expr_list) {
+    for (const auto& expr : dynamic) {
         ok = false;
         handleError(expr, "Dynamic constructs are only allowed on edges!");
     }
@@ -0,0 +1,937 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/valueranges.h"
+
+#include "utap/evaluator.h"
+#include "utap/statement.h"
+
+#include <algorithm>
+#include <limits>
+#include <set>
+
+using namespace UTAP;
+using namespace Constants;
+
+using range_type = ValueRanges::range_type;
+using env_t = std::map<symbol_t, range_type>;
+
+static constexpr int64_t int_min = std::numeric_limits<int32_t>::min();
+static constexpr int64_t int_max = std::numeric_limits<int32_t>::max();
+static constexpr range_type unknown{std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()};
+static constexpr range_type boolean{0, 1};
+
+/** The number of iterations before the ranges still growing are widened to their declared ranges. */
+static constexpr int widening_delay = 3;
+/** The number of narrowing iterations after a fixpoint is reached. */
+static constexpr int narrowing_steps = 2;
+
+/** Creates a range from 64 bit bounds, values beyond int32_t overflow and are cut off. */
+static range_type make_range(int64_t first, int64_t last)
+{
+    if (first > last)
+        return range_type::make_empty();
+    return {static_cast<int32_t>(std::clamp(first, int_min, int_max)),
+            static_cast<int32_t>(std::clamp(last, int_min, int_max))};
+}
+
+/** The convex union of ranges, where empty ranges denote no values. */
+static range_type join(const range_type& a, const range_type& b)
+{
+    if (a.empty())
+        return b;
+    if (b.empty())
+        return a;
+    return a | b;
+}
+
+static void join(env_t& into, const env_t& from)
+{
+    for (const auto& [symbol, range] : from) {
+        auto [it, inserted] = into.emplace(symbol, range);
+        if (!inserted)
+            it->second = join(it->second, range);
+    }
+}
+
+/** Widens the ranges which grew since the previous iteration to the given bounds. */
+static range_type widen(const range_type& previous, const range_type& next, const range_type& bounds)
+{
+    if (previous.empty() || next.empty())
+        return next;
+    auto first = next.first() < previous.first() ? std::min(bounds.first(), next.first()) : next.first();
+    auto last = next.last() > previous.last() ? std::max(bounds.last(), next.last()) : next.last();
+    return {first, last};
+}
+
+/** Returns true if the variables of the type are analysed. */
+static bool is_tracked(const type_t& type)
+{
+    if (type.is_constant() || type.is_record())
+        return false;
+    auto base = type.strip_array();
+    return base.is_integer() || base.is(BOOL);
+}
+
+/** Returns the variable an lvalue refers to, an empty symbol if the lvalue is not a variable. */
+static symbol_t root_of(const expression_t& expr)
+{
+    switch (expr.get_kind()) {
+    case IDENTIFIER: return expr.get_symbol();
+    case ARRAY:
+    case DOT: return root_of(expr[0]);
+    default: return symbol_t{};
+    }
+}
+
+/** Swaps the operands of a comparison. */
+static kind_t mirror(kind_t op)
+{
+    switch (op) {
+    case LT: return GT;
+    case LE: return GE;
+    case GT: return LT;
+    case GE: return LE;
+    default: return op;
+    }
+}
+
+/** Negates a comparison. */
+static kind_t negate(kind_t op)
+{
+    switch (op) {
+    case LT: return GE;
+    case LE: return GT;
+    case GT: return LE;
+    case GE: return LT;
+    case EQ: return NEQ;
+    case NEQ: return EQ;
+    default: return op;
+    }
+}
+
+static range_type compare(kind_t op, const range_type& l, const range_type& r)
+{
+    if (l.empty() || r.empty())
+        return boolean;
+    switch (op) {
+    case LT:
+        if (l.last() < r.first())
+            return range_type{1};
+        if (l.first() >= r.last())
+            return range_type{0};
+        return boolean;
+    case LE:
+        if (l.last() <= r.first())
+            return range_type{1};
+        if (l.first() > r.last())
+            return range_type{0};
+        return boolean;
+    case GT: return compare(LT, r, l);
+    case GE: return compare(LE, r, l);
+    case EQ:
+        if (l.size() == 1 && l == r)
+            return range_type{1};
+        return l.intersects(r) ? boolean : range_type{0};
+    case NEQ: {
+        auto eq = compare(EQ, l, r);
+        return eq.size() == 1 ? range_type{1 - eq.first()} : boolean;
+    }
+    default: return boolean;
+    }
+}
+
+/** The smallest 2^n-1 at least the value, the largest result of bitwise operations on non-negative operands. */
+static int64_t bit_mask(int64_t value)
+{
+    int64_t mask = 0;
+    while (mask < value)
+        mask = mask * 2 + 1;
+    return mask;
+}
+
+static range_type arithmetic(kind_t op, const range_type& l, const range_type& r)
+{
+    if (l.empty() || r.empty())
+        return range_type::make_empty();
+    int64_t lf = l.first(), ll = l.last(), rf = r.first(), rl = r.last();
+    switch (op) {
+    case PLUS: return make_range(lf + rf, ll + rl);
+    case MINUS: return make_range(lf - rl, ll - rf);
+    case MULT: {
+        auto corners = {lf * rf, lf * rl, ll * rf, ll * rl};
+        return make_range(std::min(corners), std::max(corners));
+    }
+    case DIV: {
+        if (rf > 0 || rl < 0) {
+            auto corners = {lf / rf, lf / rl, ll / rf, ll / rl};
+            return make_range(std::min(corners), std::max(corners));
+        }
+        // the magnitude of the quotient does not exceed that of the dividend
+        auto magnitude = std::max(-lf, ll);
+        return make_range(-magnitude, magnitude);
+    }
+    case MOD: {
+        auto m = std::max(-rf, rl) - 1;
+        if (m < 0)
+            return range_type::make_empty();  // division by zero
+        if (lf >= 0)
+            return make_range(0, std::min(ll, m));
+        if (ll <= 0)
+            return make_range(std::max(lf, -m), 0);
+        return make_range(std::max(lf, -m), std::min(ll, m));
+    }
+    case MIN: return make_range(std::min(lf, rf), std::min(ll, rl));
+    case MAX: return make_range(std::max(lf, rf), std::max(ll, rl));
+    case BIT_AND:
+        if (lf >= 0 && rf >= 0)
+            return make_range(0, std::min(ll, rl));
+        return unknown;
+    case BIT_OR:
+    case BIT_XOR:
+        if (lf >= 0 && rf >= 0)
+            return make_range(0, bit_mask(std::max(ll, rl)));
+        return unknown;
+    case BIT_RSHIFT:
+        if (lf >= 0 && rf >= 0)
+            return make_range(0, ll >> std::min<int64_t>(rf, 31));
+        return unknown;
+    default: return unknown;
+    }
+}
+
+static kind_t arithmetic_of(kind_t assignment)
+{
+    switch (assignment) {
+    case ASS_PLUS: return PLUS;
+    case ASS_MINUS: return MINUS;
+    case ASS_DIV: return DIV;
+    case ASS_MOD: return MOD;
+    case ASS_MULT: return MULT;
+    case ASS_AND: return BIT_AND;
+    case ASS_OR: return BIT_OR;
+    case ASS_XOR: return BIT_XOR;
+    case ASS_LSHIFT: return BIT_LSHIFT;
+    case ASS_RSHIFT: return BIT_RSHIFT;
+    default: return assignment;
+    }
+}
+
+namespace {
+/** The abstract state at a program point: the variable ranges, if the point is reachable. */
+struct flow_t
+{
+    env_t env;
+    bool reachable{true};
+
+    void join(const flow_t& other)
+    {
+        if (!other.reachable)
+            return;
+        if (!reachable)
+            *this = other;
+        else
+            ::join(env, other.env);
+    }
+    bool operator==(const flow_t& other) const { return reachable == other.reachable && env == other.env; }
+};
+
+/**
+ * Abstract interpreter of expressions and statements over ranges. The
+ * flow holds the ranges of the variables assigned so far, other
+ * variables take any value of their declared range.
+ */
+class Interpreter : public StatementVisitor
+{
+    struct alias_t
+    {
+        symbol_t target;
+        bool weak; /**< The reference denotes an element of the target */
+    };
+
+    const ConstantEvaluator& evaluator;
+    std::vector<ValueRanges::violation_t>* violations;
+    std::map<symbol_t, alias_t> aliases;
+    std::set<const function_t*> active;
+    std::set<symbol_t> written;
+    flow_t flow;
+    flow_t returned{{}, false};
+    range_type result{range_type::make_empty()};
+    std::vector<flow_t> breaks;
+    std::vector<flow_t> continues;
+
+    symbol_t resolve(symbol_t symbol, bool& weak) const
+    {
+        for (auto it = aliases.find(symbol); it != aliases.end(); it = aliases.find(symbol)) {
+            symbol = it->second.target;
+            weak |= it->second.weak;
+        }
+        return symbol;
+    }
+
+    /** The current range of the variable: its tracked range or its declared range. */
+    range_type current(const symbol_t& symbol) const
+    {
+        if (auto it = flow.env.find(symbol); it != flow.env.end())
+            return it->second;
+        return declared(symbol.get_type());
+    }
+
+    range_type read(const expression_t& expr)
+    {
+        if (auto value = evaluator.evaluate(expr))
+            return range_type{*value};
+        if (!expr.get_type().is_integral())
+            return unknown;
+        bool weak = false;
+        auto symbol = resolve(root_of(expr), weak);
+        if (expr.get_kind() == ARRAY)
+            value(expr[1]);
+        if (symbol == symbol_t{} || !is_tracked(symbol.get_type()))
+            return declared(expr.get_type());
+        return current(symbol);
+    }
+
+    void write(const expression_t& lvalue, range_type range, const expression_t& assignment)
+    {
+        if (!lvalue.get_type().is_integral())
+            return;
+        auto bounds = declared(lvalue.get_type());
+        if (violations != nullptr && flow.reachable && !range.empty() && !bounds.intersects(range) &&
+            std::none_of(violations->begin(), violations->end(), [&](auto& v) { return v.expr == assignment; }))
+            violations->push_back({assignment, range, bounds});
+        // values outside of the declared range stop the execution
+        range &= bounds;
+        if (range.empty()) {
+            flow.reachable = false;
+            return;
+        }
+        bool weak = lvalue.get_kind() != IDENTIFIER;
+        auto symbol = resolve(root_of(lvalue), weak);
+        if (symbol == symbol_t{} || !is_tracked(symbol.get_type()))
+            return;
+        weak |= symbol.get_type().is_array();
+        flow.env[symbol] = weak ? join(current(symbol), range) : range;
+        written.insert(symbol);
+    }
+
+    /** Restricts a variable to the values satisfying `variable op range`. */
+    void constrain(const expression_t& variable, kind_t op, const range_type& range)
+    {
+        if (variable.get_kind() != IDENTIFIER || range.empty())
+            return;
+        bool weak = false;
+        auto symbol = resolve(variable.get_symbol(), weak);
+        if (weak || !is_tracked(symbol.get_type()) || symbol.get_type().is_array())
+            return;
+        auto values = current(symbol);
+        int64_t first = values.first(), last = values.last();
+        switch (op) {
+        case LT: last = std::min<int64_t>(last, int64_t{range.last()} - 1); break;
+        case LE: last = std::min<int64_t>(last, range.last()); break;
+        case GT: first = std::max<int64_t>(first, int64_t{range.first()} + 1); break;
+        case GE: first = std::max<int64_t>(first, range.first()); break;
+        case EQ:
+            first = std::max<int64_t>(first, range.first());
+            last = std::min<int64_t>(last, range.last());
+            break;
+        case NEQ:
+            if (range.size() == 1 && first == range.first())
+                ++first;
+            else if (range.size() == 1 && last == range.first())
+                --last;
+            break;
+        default: return;
+        }
+        auto refined = make_range(first, last);
+        flow.env[symbol] = refined;
+        if (refined.empty())
+            flow.reachable = false;
+    }
+
+    /** Runs two alternatives from the current flow and joins their outcome. */
+    template <typename First, typename Second>
+    void branch(First&& first, Second&& second)
+    {
+        auto entry = flow;
+        first();
+        auto outcome = flow;
+        flow = std::move(entry);
+        second();
+        flow.join(outcome);
+    }
+
+    range_type call(const expression_t& expr)
+    {
+        auto symbol = expr[0].get_symbol();
+        auto arguments = std::vector<range_type>{};
+        for (uint32_t i = 1; i < expr.get_size(); ++i)
+            arguments.push_back(value(expr[i]));
+        const function_t* fun = nullptr;
+        if (symbol.get_type().is_function())
+            fun = static_cast<const function_t*>(symbol.get_data());
+        if (fun == nullptr || fun->body == nullptr || active.count(fun) > 0) {
+            // external or recursive: anything the function may change takes any value
+            if (fun != nullptr)
+                for (const auto& changed : fun->changes)
+                    if (is_tracked(changed.get_type())) {
+                        flow.env[changed] = join(current(changed), declared(changed.get_type()));
+                        written.insert(changed);
+                    }
+            auto type = symbol.get_type();
+            for (uint32_t i = 1; i < expr.get_size() && i < type.size(); ++i)
+                if (type[i].is(REF) && !type[i].is_constant())
+                    write(expr[i], declared(expr[i].get_type()), expr);
+            return declared(expr.get_type());
+        }
+
+        auto type = symbol.get_type();
+        auto frame = fun->body->get_frame();
+        auto saved_aliases = aliases;
+        auto saved_returned = std::exchange(returned, flow_t{{}, false});
+        auto saved_result = std::exchange(result, range_type::make_empty());
+        for (uint32_t i = 0; i + 1 < type.size() && i < arguments.size(); ++i) {
+            auto parameter = frame[i];
+            if (type[i + 1].is(REF)) {
+                bool weak = expr[i + 1].get_kind() != IDENTIFIER;
+                auto target = resolve(root_of(expr[i + 1]), weak);
+                if (target != symbol_t{})
+                    aliases[parameter] = alias_t{target, weak};
+            } else if (is_tracked(parameter.get_type())) {
+                flow.env[parameter] = arguments[i];
+            }
+        }
+        active.insert(fun);
+        fun->body->accept(this);
+        active.erase(fun);
+        flow.join(returned);
+        auto value = result.empty() ? declared(expr.get_type()) : result;
+        aliases = std::move(saved_aliases);
+        returned = std::move(saved_returned);
+        result = saved_result;
+        return value;
+    }
+
+    void declare(frame_t frame)
+    {
+        for (uint32_t i = 0; i < frame.get_size(); ++i) {
+            auto symbol = frame[i];
+            // parameters have no data and are bound by the call
+            if (!is_tracked(symbol.get_type()) || symbol.get_data() == nullptr)
+                continue;
+            const auto& init = static_cast<const variable_t*>(symbol.get_data())->init;
+            flow.env[symbol] = initial(symbol.get_type(), init);
+        }
+    }
+
+    /**
+     * Iterates a loop to a fixpoint. The loop starts with the condition
+     * unless it is a do-while loop, the step is executed after the body.
+     * The iterator of a range loop takes any value of its type in each
+     * iteration. Violations are only reported once the ranges are stable.
+     */
+    void loop(const expression_t& cond, Statement* body, const expression_t& step, bool test_first,
+              const symbol_t* iterator = nullptr)
+    {
+        auto saved_breaks = std::exchange(breaks, {});
+        auto entry = flow;
+        auto head = flow;
+        auto iterate = [&] {
+            flow = head;
+            if (iterator != nullptr)
+                flow.env[*iterator] = declared(iterator->get_type());
+            auto saved_continues = std::exchange(continues, {});
+            if (test_first)
+                refine(cond, true);
+            if (flow.reachable)
+                body->accept(this);
+            for (const auto& next : continues)
+                flow.join(next);
+            continues = std::move(saved_continues);
+            if (!step.empty() && flow.reachable)
+                value(step);
+            if (!test_first && flow.reachable)
+                refine(cond, true);
+            flow.join(entry);
+        };
+        auto* report = std::exchange(violations, nullptr);
+        for (int iteration = 0;; ++iteration) {
+            iterate();
+            if (iteration >= widening_delay && head.reachable) {
+                for (auto& [symbol, range] : flow.env)
+                    if (auto it = head.env.find(symbol); it != head.env.end())
+                        range = widen(it->second, range, declared(symbol.get_type()));
+            }
+            if (flow == head)
+                break;
+            head = flow;
+        }
+        violations = report;
+        if (violations != nullptr) {
+            iterate();
+            flow = head;
+        }
+        if (!test_first && flow.reachable) {
+            // the exit of a do-while loop follows the body
+            auto saved_continues = std::exchange(continues, {});
+            body->accept(this);
+            for (const auto& next : continues)
+                flow.join(next);
+            continues = std::move(saved_continues);
+        }
+        refine(cond, false);
+        for (const auto& exit : breaks)
+            flow.join(exit);
+        breaks = std::move(saved_breaks);
+    }
+
+    int32_t visitBlock(BlockStatement* stat)
+    {
+        declare(stat->get_frame());
+        for (auto& child : *stat) {
+            if (!flow.reachable)
+                break;
+            child->accept(this);
+        }
+        return 0;
+    }
+
+public:
+    Interpreter(const ConstantEvaluator& evaluator, std::vector<ValueRanges::violation_t>* violations):
+        evaluator{evaluator}, violations{violations}
+    {}
+
+    flow_t& get_flow() { return flow; }
+    /** The variables assigned since the last call to clear_written(). */
+    const std::set<symbol_t>& get_written() const { return written; }
+    void clear_written() { written.clear(); }
+
+    /** Binds the reference parameters of a process to the variables given as arguments. */
+    void bind(const instance_t& process)
+    {
+        for (const auto& [parameter, argument] : process.mapping) {
+            if (!parameter.get_type().is(REF))
+                continue;
+            auto target = root_of(argument);
+            if (target != symbol_t{})
+                aliases[parameter] = alias_t{target, argument.get_kind() != IDENTIFIER};
+        }
+    }
+
+    /** Returns the declared range of the integer or boolean type, or the range of its elements. */
+    range_type declared(type_t type) const
+    {
+        while (type.is_array())
+            type = type.get_sub();
+        if (type.is(BOOL))
+            return boolean;
+        if (!type.is_range() || !type.is_integer())
+            return unknown;
+        auto [lower, upper] = type.get_range();
+        auto first = evaluator.evaluate(lower);
+        auto last = evaluator.evaluate(upper);
+        return {first.value_or(unknown.first()), last.value_or(unknown.last())};
+    }
+
+    /** Returns the initial values of a variable with the given initialiser. */
+    range_type initial(const type_t& type, const expression_t& init)
+    {
+        auto bounds = declared(type);
+        if (init.empty())
+            return bounds.contains(0) ? range_type{0} : bounds;
+        auto values = value(init) & bounds;
+        return values.empty() ? bounds : values;
+    }
+
+    /** Restricts the flow to the states where the condition has the given truth value. */
+    void refine(const expression_t& expr, bool truth)
+    {
+        if (expr.empty() || !flow.reachable)
+            return;
+        auto kind = expr.get_kind();
+        switch (kind) {
+        case AND:
+        case OR:
+            if ((kind == AND) == truth) {
+                refine(expr[0], truth);
+                refine(expr[1], truth);
+            } else {
+                branch([&] { refine(expr[0], truth); }, [&] { refine(expr[1], truth); });
+            }
+            return;
+        case NOT: refine(expr[0], !truth); return;
+        case LT:
+        case LE:
+        case GT:
+        case GE:
+        case EQ:
+        case NEQ: {
+            if (!expr[0].get_type().is_integral() || !expr[1].get_type().is_integral())
+                break;
+            auto op = truth ? kind : negate(kind);
+            auto left = value(expr[0]);
+            auto right = value(expr[1]);
+            constrain(expr[0], op, right);
+            constrain(expr[1], mirror(op), left);
+            break;
+        }
+        case IDENTIFIER:
+            if (expr.get_type().is_integral())
+                constrain(expr, truth ? NEQ : EQ, range_type{0});
+            break;
+        default: break;
+        }
+        if (!flow.reachable)
+            return;
+        if (auto values = value(expr); values.size() == 1 && (values.first() != 0) != truth)
+            flow.reachable = false;
+    }
+
+    /** Returns the values of the expression and applies its side effects to the flow. */
+    range_type value(const expression_t& expr)
+    {
+        if (expr.empty() || !flow.reachable)
+            return range_type::make_empty();
+        if (auto constant = evaluator.evaluate(expr))
+            return range_type{*constant};
+
+        auto kind = expr.get_kind();
+        switch (kind) {
+        case CONSTANT: return expr.get_type().is_integral() ? range_type{expr.get_value()} : unknown;
+        case IDENTIFIER:
+        case ARRAY:
+        case DOT: return read(expr);
+        case UNARY_MINUS: {
+            auto operand = value(expr[0]);
+            return operand.empty() ? operand : make_range(-int64_t{operand.last()}, -int64_t{operand.first()});
+        }
+        case ABS_F: {
+            auto operand = value(expr[0]);
+            if (operand.empty() || operand.first() >= 0)
+                return operand;
+            if (operand.last() <= 0)
+                return make_range(-int64_t{operand.last()}, -int64_t{operand.first()});
+            return make_range(0, std::max(-int64_t{operand.first()}, int64_t{operand.last()}));
+        }
+        case NOT: {
+            auto operand = value(expr[0]);
+            return operand.size() == 1 ? range_type{operand.first() == 0} : boolean;
+        }
+        case PLUS:
+        case MINUS:
+        case MULT:
+        case DIV:
+        case MOD:
+        case MIN:
+        case MAX:
+        case BIT_AND:
+        case BIT_OR:
+        case BIT_XOR:
+        case BIT_LSHIFT:
+        case BIT_RSHIFT: {
+            auto left = value(expr[0]);
+            auto right = value(expr[1]);
+            if (!expr.get_type().is_integral())
+                return unknown;
+            return arithmetic(kind, left, right);
+        }
+        case LT:
+        case LE:
+        case GT:
+        case GE:
+        case EQ:
+        case NEQ: {
+            auto left = value(expr[0]);
+            auto right = value(expr[1]);
+            if (!expr[0].get_type().is_integral() || !expr[1].get_type().is_integral())
+                return boolean;
+            return compare(kind, left, right);
+        }
+        case AND:
+        case OR: {
+            auto left = value(expr[0]);
+            if (left.size() == 1 && (kind == AND) == (left.first() == 0))
+                return range_type{kind == OR};
+            auto right = value(expr[1]);
+            if (right.size() == 1 && (kind == AND) == (right.first() == 0))
+                return range_type{kind == OR};
+            if (left.size() == 1 && right.size() == 1)
+                return range_type{right.first() != 0};
+            return boolean;
+        }
+        case INLINE_IF: {
+            auto cond = value(expr[0]);
+            if (cond.size() == 1)
+                return value(cond.first() != 0 ? expr[1] : expr[2]);
+            auto first = range_type::make_empty();
+            auto second = range_type::make_empty();
+            branch(
+                [&] {
+                    refine(expr[0], true);
+                    first = value(expr[1]);
+                },
+                [&] {
+                    refine(expr[0], false);
+                    second = value(expr[2]);
+                });
+            return join(first, second);
+        }
+        case COMMA: value(expr[0]); return value(expr[1]);
+        case ASSIGN: {
+            auto values = value(expr[1]);
+            write(expr[0], values, expr);
+            return values;
+        }
+        case ASS_PLUS:
+        case ASS_MINUS:
+        case ASS_DIV:
+        case ASS_MOD:
+        case ASS_MULT:
+        case ASS_AND:
+        case ASS_OR:
+        case ASS_XOR:
+        case ASS_LSHIFT:
+        case ASS_RSHIFT: {
+            auto values = arithmetic(arithmetic_of(kind), value(expr[0]), value(expr[1]));
+            write(expr[0], values, expr);
+            return values;
+        }
+        case PRE_INCREMENT:
+        case POST_INCREMENT:
+        case PRE_DECREMENT:
+        case POST_DECREMENT: {
+            auto old = value(expr[0]);
+            auto delta = range_type{kind == PRE_INCREMENT || kind == POST_INCREMENT ? 1 : -1};
+            auto values = arithmetic(PLUS, old, delta);
+            write(expr[0], values, expr);
+            return kind == PRE_INCREMENT || kind == PRE_DECREMENT ? values : old;
+        }
+        case LIST: {
+            auto values = range_type::make_empty();
+            for (uint32_t i = 0; i < expr.get_size(); ++i)
+                values = join(values, value(expr[i]));
+            return values;
+        }
+        case FUN_CALL: return call(expr);
+        default:
+            for (uint32_t i = 0; i < expr.get_size(); ++i)
+                value(expr[i]);
+            return expr.get_type().is_integral() ? declared(expr.get_type()) : unknown;
+        }
+    }
+
+    int32_t visitEmptyStatement(EmptyStatement*) override { return 0; }
+    int32_t visitExprStatement(ExprStatement* stat) override
+    {
+        value(stat->expr);
+        return 0;
+    }
+    int32_t visitAssertStatement(AssertStatement* stat) override
+    {
+        refine(stat->expr, true);
+        return 0;
+    }
+    int32_t visitForStatement(ForStatement* stat) override
+    {
+        value(stat->init);
+        loop(stat->cond, stat->stat.get(), stat->step, true);
+        return 0;
+    }
+    int32_t visitIterationStatement(IterationStatement* stat) override
+    {
+        loop({}, stat->stat.get(), {}, true, &stat->symbol);
+        return 0;
+    }
+    int32_t visitWhileStatement(WhileStatement* stat) override
+    {
+        loop(stat->cond, stat->stat.get(), {}, true);
+        return 0;
+    }
+    int32_t visitDoWhileStatement(DoWhileStatement* stat) override
+    {
+        loop(stat->cond, stat->stat.get(), {}, false);
+        return 0;
+    }
+    int32_t visitBlockStatement(BlockStatement* stat) override { return visitBlock(stat); }
+    int32_t visitSwitchStatement(SwitchStatement* stat) override
+    {
+        value(stat->cond);
+        auto saved_breaks = std::exchange(breaks, {});
+        auto entry = flow;
+        declare(stat->get_frame());
+        for (auto& child : *stat) {
+            // every case may be entered directly or by falling through from the previous one
+            flow.join(entry);
+            child->accept(this);
+        }
+        flow.join(entry);
+        for (const auto& exit : breaks)
+            flow.join(exit);
+        breaks = std::move(saved_breaks);
+        return 0;
+    }
+    int32_t visitCaseStatement(CaseStatement* stat) override { return visitBlock(stat); }
+    int32_t visitDefaultStatement(DefaultStatement* stat) override { return visitBlock(stat); }
+    int32_t visitIfStatement(IfStatement* stat) override
+    {
+        branch(
+            [&] {
+                refine(stat->cond, true);
+                if (flow.reachable)
+                    stat->trueCase->accept(this);
+            },
+            [&] {
+                refine(stat->cond, false);
+                if (flow.reachable && stat->falseCase)
+                    stat->falseCase->accept(this);
+            });
+        return 0;
+    }
+    int32_t visitBreakStatement(BreakStatement*) override
+    {
+        breaks.push_back(std::exchange(flow, flow_t{{}, false}));
+        return 0;
+    }
+    int32_t visitContinueStatement(ContinueStatement*) override
+    {
+        continues.push_back(std::exchange(flow, flow_t{{}, false}));
+        return 0;
+    }
+    int32_t visitReturnStatement(ReturnStatement* stat) override
+    {
+        if (!stat->value.empty())
+            result = join(result, value(stat->value));
+        returned.join(flow);
+        flow.reachable = false;
+        return 0;
+    }
+};
+
+/** A template together with the process instantiating it, if any. */
+struct context_t
+{
+    const template_t* templ;
+    const instance_t* process;
+    ConstantEvaluator evaluator;
+};
+}  // namespace
+
+ValueRanges::ValueRanges(Document& document)
+{
+    auto contexts = std::vector<context_t>{};
+    auto instantiated = std::set<const template_t*>{};
+    for (const auto& process : document.get_processes()) {
+        if (process.templ == nullptr)
+            continue;
+        contexts.push_back({process.templ, &process, ConstantEvaluator{process}});
+        instantiated.insert(process.templ);
+    }
+    for (const auto& templ : document.get_templates())
+        if (instantiated.count(&templ) == 0)
+            contexts.push_back({&templ, nullptr, ConstantEvaluator{}});
+    for (const auto* templ : document.get_dynamic_templates())
+        if (instantiated.count(templ) == 0)
+            contexts.push_back({templ, nullptr, ConstantEvaluator{}});
+
+    // The initial ranges and the declared ranges used for widening
+    auto global_evaluator = ConstantEvaluator{};
+    auto initial = env_t{};
+    auto bounds = env_t{};
+    auto add_variables = [&](const std::list<variable_t>& variables, const ConstantEvaluator& evaluator) {
+        auto interpreter = Interpreter{evaluator, nullptr};
+        for (const auto& var : variables) {
+            if (!is_tracked(var.uid.get_type()))
+                continue;
+            auto declared = interpreter.declared(var.uid.get_type());
+            auto values = interpreter.initial(var.uid.get_type(), var.init);
+            auto [it, inserted] = initial.emplace(var.uid, values);
+            if (!inserted)
+                it->second = join(it->second, values);
+            auto [bound, fresh] = bounds.emplace(var.uid, declared);
+            if (!fresh)
+                bound->second = join(bound->second, declared);
+        }
+    };
+    add_variables(document.get_globals().variables, global_evaluator);
+    for (const auto& context : contexts)
+        add_variables(context.templ->variables, context.evaluator);
+
+    /* Joins the values assigned by every edge (and the before/after
+     * updates) executed from the given state into the next state. The
+     * other variables keep their values, which are in the state already.
+     */
+    auto step = [&](const env_t& state, env_t& next, std::vector<violation_t>* report) {
+        auto execute = [&](Interpreter& interpreter, const auto& run) {
+            auto& flow = interpreter.get_flow();
+            flow = flow_t{state, true};
+            interpreter.clear_written();
+            run();
+            if (!flow.reachable)
+                return;
+            for (const auto& symbol : interpreter.get_written())
+                if (auto it = next.find(symbol); it != next.end())
+                    it->second = join(it->second, flow.env.at(symbol));
+        };
+        for (const auto& context : contexts) {
+            auto interpreter = Interpreter{context.evaluator, report};
+            if (context.process != nullptr)
+                interpreter.bind(*context.process);
+            for (const auto& edge : context.templ->edges) {
+                execute(interpreter, [&] {
+                    interpreter.refine(edge.guard, true);
+                    interpreter.value(edge.sync);
+                    interpreter.value(edge.assign);
+                });
+            }
+        }
+        auto interpreter = Interpreter{global_evaluator, report};
+        for (const auto& update : {document.get_before_update(), document.get_after_update()})
+            execute(interpreter, [&] { interpreter.value(update); });
+    };
+
+    auto state = initial;
+    for (int iteration = 0;; ++iteration) {
+        auto next = state;
+        step(state, next, nullptr);
+        if (next == state)
+            break;
+        if (iteration >= widening_delay)
+            for (auto& [symbol, range] : next)
+                range = widen(state.at(symbol), range, bounds.at(symbol));
+        state = std::move(next);
+    }
+    // The widened ranges may be larger than necessary, descend while staying above the reachable values
+    for (int iteration = 0; iteration < narrowing_steps; ++iteration) {
+        auto next = initial;
+        step(state, next, nullptr);
+        state = std::move(next);
+    }
+    auto unused = state;
+    step(state, unused, &violations);
+    ranges = std::move(state);
+}
+
+std::optional<range_type> ValueRanges::get_range(const symbol_t& variable) const
+{
+    if (auto it = ranges.find(variable); it != ranges.end())
+        return it->second;
+    return std::nullopt;
+}
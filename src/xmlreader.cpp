@@ -25,15 +25,21 @@
 
 #include "utap/utap.h"
 
+#include <libxml/SAX2.h>
 #include <libxml/parser.h>
 #include <libxml/xmlreader.h>
 #include <libxml/xmlstring.h>
 #include <libxml/xpath.h>
 
 #include <algorithm>
+#include <array>
+#include <exception>
+#include <functional>
 #include <list>
+#include <limits>
 #include <map>
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -210,36 +216,43 @@ static std::string_view symbol(std::string_view sv)
 class Path
 {
 private:
-    std::list<std::vector<tag_t>> path;
+    /** The most recent tag at a level and the number of siblings per tag so far */
+    struct level_t
+    {
+        bool empty{true};
+        tag_t tag{tag_t::NONE};
+        std::array<uint32_t, static_cast<size_t>(tag_t::NONE) + 1> count{};
+    };
+    std::vector<level_t> path;
+
+    static size_t count(const level_t& level, tag_t tag) { return level.count[static_cast<size_t>(tag)]; }
 
 public:
     Path() { path.emplace_back(); };
     void push(tag_t tag)
     {
-        path.back().push_back(tag);
+        auto& level = path.back();
+        level.empty = false;
+        level.tag = tag;
+        ++level.count[static_cast<size_t>(tag)];
         path.emplace_back();
     }
     tag_t pop()
     {
         path.pop_back();
-        return path.back().back();
+        return path.back().tag;
     }
     [[nodiscard]] std::string str(tag_t tag = tag_t::NONE) const;
 };
 
-static inline size_t count(const std::vector<tag_t>& level, tag_t tag)
-{
-    return std::count(std::begin(level), std::end(level), tag);
-}
-
 /** Returns the XPath encoding of the current path. */
 [[nodiscard]] std::string Path::str(tag_t tag) const
 {
     std::ostringstream str;
     for (auto&& level : path) {
-        if (level.empty())
+        if (level.empty)
             break;
-        switch (level.back()) {
+        switch (level.tag) {
         case tag_t::NTA: str << "/nta"; break;
         case tag_t::PROJECT: str << "/project"; break;
         case tag_t::IMPORTS: str << "/imports"; break;
@@ -285,13 +298,116 @@ static inline size_t count(const std::vector<tag_t>& level, tag_t tag)
             /* Strange tag on stack */
             throw xpath_corrupt_error{};
         }
-        if (level.back() == tag) {
+        if (level.tag == tag) {
             break;
         }
     }
     return str.str();
 }
 
+/**
+ * Follows the xmlTextReader through the raw XML buffer in order to
+ * locate the byte ranges of element contents without keeping a DOM.
+ * Start tags are matched in document order, thus element() must be
+ * called once for every element node reported by the reader.
+ */
+class SourceScanner
+{
+private:
+    std::string_view buffer;
+    size_t cursor{0};                      /**< Position after the last matched start tag */
+    size_t content{std::string_view::npos}; /**< Start of the contents of the current element */
+    bool empty{false};                      /**< True if the current element is <empty/> */
+
+    /** Returns the position of the next tag at or after from, skipping comments, CDATA etc. */
+    size_t next_tag(size_t from) const;
+    /** Returns the position after the given terminator, or npos. */
+    size_t skip(size_t from, std::string_view terminator) const
+    {
+        auto p = buffer.find(terminator, from);
+        return p == std::string_view::npos ? p : p + terminator.size();
+    }
+
+public:
+    SourceScanner() = default;
+    explicit SourceScanner(std::string_view buffer): buffer{buffer} {}
+    bool active() const { return !buffer.empty(); }
+    /** Moves past the start tag of the next element. */
+    void element();
+    /** Returns the text range of the current element up to its first child or closing tag. */
+    std::optional<position_index_t::source_t> contents() const;
+};
+
+size_t SourceScanner::next_tag(size_t from) const
+{
+    using namespace std::string_view_literals;
+    auto p = buffer.find('<', from);
+    while (p != std::string_view::npos) {
+        auto rest = buffer.substr(p);
+        if (rest.substr(0, 4) == "<!--"sv)
+            p = skip(p, "-->"sv);
+        else if (rest.substr(0, 9) == "<![CDATA["sv)
+            p = skip(p, "]]>"sv);
+        else if (rest.substr(0, 2) == "<?"sv)
+            p = skip(p, "?>"sv);
+        else if (rest.substr(0, 2) == "<!"sv)
+            p = skip(p, ">"sv);
+        else
+            return p;
+        if (p != std::string_view::npos)
+            p = buffer.find('<', p);
+    }
+    return p;
+}
+
+void SourceScanner::element()
+{
+    for (auto p = next_tag(cursor); p != std::string_view::npos; p = next_tag(cursor)) {
+        if (p + 1 < buffer.size() && buffer[p + 1] == '/') {  // closing tag
+            cursor = skip(p, ">");
+            if (cursor == std::string_view::npos)
+                break;
+            continue;
+        }
+        // find the end of the start tag, attribute values may contain '>'
+        auto quote = '\0';
+        for (++p; p < buffer.size(); ++p) {
+            const auto c = buffer[p];
+            if (quote != '\0') {
+                if (c == quote)
+                    quote = '\0';
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+            } else if (c == '>') {
+                empty = buffer[p - 1] == '/';
+                content = cursor = p + 1;
+                return;
+            }
+        }
+        break;
+    }
+    buffer = {};  // out of sync with the reader: stop recording
+}
+
+std::optional<position_index_t::source_t> SourceScanner::contents() const
+{
+    if (!active() || content == std::string_view::npos || content > std::numeric_limits<uint32_t>::max())
+        return std::nullopt;
+    auto end = content;
+    if (!empty) {
+        // the text ends at the first tag which is not CDATA or a comment
+        end = buffer.find('<', content);
+        while (end != std::string_view::npos && buffer.compare(end, 2, "<!") == 0) {
+            end = buffer.compare(end, 4, "<!--") == 0 ? skip(end, "-->") : skip(end, "]]>");
+            if (end != std::string_view::npos)
+                end = buffer.find('<', end);
+        }
+        if (end == std::string_view::npos || end > std::numeric_limits<uint32_t>::max())
+            return std::nullopt;
+    }
+    return position_index_t::source_t{static_cast<uint32_t>(content), static_cast<uint32_t>(end - content)};
+}
+
 /**
  * Implements a recursive descent parser for UPPAAL XML documents.
  * Uses the xmlTextReader API from libxml2.
@@ -299,31 +415,41 @@ static inline size_t count(const std::vector<tag_t>& level, tag_t tag)
 class XMLReader
 {
 private:
-    using elementmap_t = std::map<std::string, std::string>;
+    /** Map from id to name, keyed by ids interned in the reader dictionary (compared by address) */
+    using elementmap_t = std::unordered_map<const char*, std::string>;
     using xmlTextReader_ptr = std::unique_ptr<xmlTextReader, decltype(xmlFreeTextReader)&>;
     xmlTextReader_ptr reader; /**< The underlying xmlTextReader */
     elementmap_t names;       /**< Map from id to name */
+    /** Element names are interned in the reader dictionary, thus tags can be cached by address */
+    mutable std::unordered_map<const xmlChar*, tag_t> tags;
     ParserBuilder* parser;    /**< The parser builder to which to push the model. */
     bool newxta;              /**< True if we should use new syntax. */
     Path path;
+    SourceScanner scanner;   /**< Locates element contents when reading from a buffer */
     bool nta;                /**< True if the enclosing tag is "nta" (false if it is "project") */
+    /** The part of the project parsed by the next step() */
+    enum class stage_t { ROOT, DECLARATION, TEMPLATES, LSC_TEMPLATES, INSTANTIATION, SYSTEM, QUERIES, DONE };
+    stage_t stage{stage_t::ROOT};
+    size_t sections{0};      /**< Number of elements of the project read so far */
+    bool walking{false};     /**< True if the reader walks a tree instead of reading the input */
+    bool ended{false};       /**< True if a walked element without children is reported as closed */
     int bottomPrechart;      /**< y location of the prechart bottom */
     std::string currentType; /**< type of the current LSC template */
     std::string currentMode; /**< mode of the current LSC template */
 
     [[nodiscard]] tag_t getElement() const;
-    /** Reads an attribute value of the currently parsed tag with manual deallocation.
+    /** Reads an attribute value of the currently parsed tag without allocation.
      * @param name the name of the XML tag attribute
-     * @return the value of the attribute, remember to xmlFree() it!
+     * @return the value interned in the reader dictionary (valid as long as the reader,
+     * equal values have equal addresses), or nullptr if the attribute is missing.
      */
-    char* getAttribute(const char* name) const;
-    /** Reads an attribute value of the currently parsed tag with automatic deallocation.
-     * @param name the name of the XML tag attribute
-     * @return the value of the attribute.
-     */
-    std::string getAttributeStr(std::string_view name) const;
+    const char* getAttribute(const char* name) const;
 
     bool isEmpty() const;
+    /** Returns true if the parser builder does not accept more input. */
+    bool truncated() const { return parser->is_truncated(); }
+    /** Records the byte range of the current element contents under the given path. */
+    void add_source(std::string_view xpath);
     int getNodeType() const;
     void read();
     bool begin(tag_t, bool skipEmpty = true);
@@ -378,9 +504,9 @@ private:
     std::string readText(bool instanceLine = false);
     int readNumber();
     /** Parse obligatory source tag. */
-    std::string source();
+    const std::string& source();
     /** Parse obligatory target tag. */
-    std::string target();
+    const std::string& target();
     /** Parse optional transition. */
     bool transition();
     /** Parse optional template. */
@@ -391,13 +517,13 @@ private:
     bool instantiation();
     /** Parse required system tag. */
     void system();
-    std::string reference(const std::string& attributeName);
+    const std::string& reference(const char* attributeName);
 
     // LSC elements:
     /** Parse optional LSC template. */
     bool lscTempl();
     /** Parse obligatory anchor tag for update. */
-    std::string anchor();
+    const std::string& anchor();
     /** Parse obligatory anchor tag for condition. */
     std::vector<std::string> anchors();
     /** Parse optional type tag. */
@@ -426,19 +552,47 @@ private:
     bool result();
 
 public:
-    XMLReader(xmlTextReaderPtr reader, ParserBuilder* parser, bool newxta):
-        reader(reader, xmlFreeTextReader), parser{parser}, newxta{newxta}
+    /** The buffer, if given, must be the one the reader reads from and is used to build a source map. */
+    XMLReader(xmlTextReaderPtr reader, ParserBuilder* parser, bool newxta, std::string_view buffer = {}):
+        reader(reader, xmlFreeTextReader), parser{parser}, newxta{newxta}, scanner{buffer}
+    {
+        read();
+    }
+    /** The walker must walk a tree built by XMLModelStream, where self-closing tags are marked. */
+    XMLReader(xmlTextReaderPtr walker, ParserBuilder* parser, bool newxta, bool walking):
+        reader(walker, xmlFreeTextReader), parser{parser}, newxta{newxta}, walking{walking}
     {
         read();
     }
     /** Parse the project document (either NTA or PROJECT tag). */
     void project();
+    /**
+     * Parses the next part of the project, i.e. the root tag or a
+     * single element of the project, and returns false once the
+     * project is complete. The step reads the next element which is
+     * not skipped as unknown and moves to the node following it.
+     */
+    bool step();
+    /** Returns true once the global declarations have been parsed. */
+    bool declared() const { return stage > stage_t::DECLARATION; }
+    /** Returns the number of elements of the project the reader has moved into or past. */
+    size_t get_sections() const
+    {
+        return getNodeType() == XML_READER_TYPE_ELEMENT && xmlTextReaderDepth(reader.get()) == 1 ? sections - 1
+                                                                                                : sections;
+    }
 };
 
 static const auto non_unique_id = std::string{"$Non-unique_id_attribute_value: "};
 
+/** Marks the elements of a tree built by XMLModelStream which are written as self-closing tags */
+static constexpr unsigned short self_closing = 1;
+
 /** Returns the type of the current node. */
-int XMLReader::getNodeType() const { return xmlTextReaderNodeType(reader.get()); }
+int XMLReader::getNodeType() const
+{
+    return ended ? XML_READER_TYPE_END_ELEMENT : xmlTextReaderNodeType(reader.get());
+}
 
 /**
  * Returns the tag of the current element. Throws an exception if
@@ -446,31 +600,34 @@ int XMLReader::getNodeType() const { return xmlTextReaderNodeType(reader.get());
  */
 tag_t XMLReader::getElement() const
 {
-    const char* element = (const char*)xmlTextReaderConstLocalName(reader.get());
-    const auto tag = tag_map.find(element);
-    if (tag == std::end(tag_map)) {
-        /* Unknown element. */
-        return tag_t::NONE;
-    }
-    return tag->second;
-}
-
-char* XMLReader::getAttribute(const char* name) const
-{
-    return (char*)xmlTextReaderGetAttribute(reader.get(), (xmlChar*)name);
+    const xmlChar* element = xmlTextReaderConstLocalName(reader.get());
+    if (auto cached = tags.find(element); cached != tags.end())
+        return cached->second;
+    const auto tag = element ? tag_map.find((const char*)element) : std::end(tag_map);
+    /* Unknown element. */
+    const auto res = (tag == std::end(tag_map)) ? tag_t::NONE : tag->second;
+    tags.emplace(element, res);
+    return res;
 }
 
-std::string XMLReader::getAttributeStr(std::string_view name) const
+const char* XMLReader::getAttribute(const char* name) const
 {
-    char* value = getAttribute(name.data());
-    auto res = std::string{value};
-    xmlFree(value);
-    return res;
+    auto* r = reader.get();
+    if (xmlTextReaderMoveToAttribute(r, (const xmlChar*)name) != 1)
+        return nullptr;
+    const auto* value = xmlTextReaderConstString(r, xmlTextReaderConstValue(r));
+    xmlTextReaderMoveToElement(r);
+    return (const char*)value;
 }
 
 /** Returns true if the current element is an empty element. */
 bool XMLReader::isEmpty() const
 {
+    if (walking) {
+        // the walker reports every element without children as empty
+        const auto* node = xmlTextReaderCurrentNode(reader.get());
+        return getNodeType() == XML_READER_TYPE_ELEMENT && node->children == nullptr && node->extra == self_closing;
+    }
     int res = xmlTextReaderIsEmptyElement(reader.get());
     assert(0 <= res);
     assert(res <= 1);
@@ -535,16 +692,38 @@ void XMLReader::read()
             throw XMLDocError("Invalid nesting");
         }
     }
+    if (walking && !ended && getNodeType() == XML_READER_TYPE_ELEMENT && !isEmpty() &&
+        xmlTextReaderCurrentNode(reader.get())->children == nullptr) {
+        ended = true;  // report the closing tag like the reader of the input does
+        return;
+    }
+    ended = false;
     if (xmlTextReaderRead(reader.get()) != 1) {
         /* Premature end of document. */
         throw XMLReaderError(errno, std::system_category(), "$unexpected $end");
     }
 
     if (getNodeType() == XML_READER_TYPE_ELEMENT) {
+        if (xmlTextReaderDepth(reader.get()) == 1)
+            ++sections;
         path.push(getElement());
+        if (scanner.active())
+            scanner.element();
     }
 }
 
+void XMLReader::add_source(std::string_view xpath)
+{
+    if (!scanner.active())
+        return;
+    // the scanner is at the enclosing element only while reading its text or closing tag
+    const auto type = getNodeType();
+    if (type != XML_READER_TYPE_TEXT && type != XML_READER_TYPE_END_ELEMENT)
+        return;
+    if (auto range = scanner.contents())
+        parser->set_source(parser->add_path(xpath), range->offset, range->length);
+}
+
 const std::string& XMLReader::get_name(const char* id) const
 {
     if (id) {
@@ -556,7 +735,9 @@ const std::string& XMLReader::get_name(const char* id) const
 
 int XMLReader::parse(const xmlChar* text, xta_part_t syntax)
 {
-    return parse_XTA((const char*)text, parser, newxta, syntax, path.str());
+    const auto xpath = path.str();
+    add_source(xpath);
+    return parse_XTA((const char*)text, parser, newxta, syntax, xpath);
 }
 
 bool XMLReader::declaration()
@@ -575,7 +756,7 @@ bool XMLReader::label(bool required, const std::string& s_kind)
 {
     if (begin(tag_t::LABEL)) {
         /* Get kind attribute. */
-        char* kind = getAttribute("kind");
+        const char* kind = getAttribute("kind");
         if (kind == nullptr)
             throw TypeException("A label must have a \"kind\" attribute");
         read();
@@ -590,7 +771,6 @@ bool XMLReader::label(bool required, const std::string& s_kind)
             if (auto part = map.find(kind); part != map.end())
                 parse(text, part->second);
         }
-        xmlFree(kind);
         return true;
     } else if (required) {
         tracker.setPath(parser, path.str());
@@ -609,7 +789,7 @@ int XMLReader::invariant()
     int result = -1;
     if (begin(tag_t::LABEL)) {
         /* Get kind attribute. */
-        char* kind = getAttribute("kind");
+        const char* kind = getAttribute("kind");
         if (kind == nullptr)
             throw TypeException{"A label must have a \"kind\" attribute"};
         read();
@@ -627,7 +807,6 @@ int XMLReader::invariant()
                     result = 1;
             }
         }
-        xmlFree(kind);
     }
     return result;
 }
@@ -643,23 +822,21 @@ std::string XMLReader::name(bool instanceLine)
 std::string XMLReader::readText(bool instanceLine)
 {
     if (getNodeType() == XML_READER_TYPE_TEXT) {  // text content of a node
-        xmlChar* text = xmlTextReaderValue(reader.get());
+        const xmlChar* text = xmlTextReaderConstValue(reader.get());
         auto len = text ? std::strlen((const char*)text) : 0;
         auto text_sv = std::string_view{(const char*)text, len};
-        tracker.setPath(parser, path.str());
+        const auto xpath = path.str();
+        add_source(xpath);
+        tracker.setPath(parser, xpath);
         tracker.increment(parser, text_sv.size());
         try {
             std::string_view id = (instanceLine) ? text_sv : symbol(text_sv);
-            if (!is_keyword(id, syntax_t::OLD_PROPERTY)) {
-                auto res = std::string{id};
-                xmlFree(text);
-                return res;
-            }
+            if (!is_keyword(id, syntax_t::OLD_PROPERTY))
+                return std::string{id};
             parser->handle_error(TypeException{"$Keywords_are_not_allowed_here"});
         } catch (std::logic_error& str) {
             parser->handle_error(TypeException{str.what()});
         }
-        xmlFree(text);
     }
     return "";
 }
@@ -669,20 +846,17 @@ int XMLReader::readNumber()
     read();
     if (getNodeType() == XML_READER_TYPE_TEXT) {  // text content of a node
         tracker.setPath(parser, path.str());
-        xmlChar* text = xmlTextReaderValue(reader.get());
-        const char* pc = (const char*)text;
+        const char* pc = (const char*)xmlTextReaderConstValue(reader.get());
         auto len = std::strlen(pc);
         tracker.increment(parser, len);
         try {
             int value;
             if (auto [p, ec] = std::from_chars(pc, pc + len, value); ec != std::errc{})
                 throw std::logic_error{std::make_error_code(ec).category().name()};
-            xmlFree(text);
             return value;
         } catch (const char* str) {
             parser->handle_error(TypeException{str});
         }
-        xmlFree(text);
     }
     return -1;
 }
@@ -738,8 +912,8 @@ bool XMLReader::location()
         try {
             std::string l_path = path.str(tag_t::LOCATION);
             /* Extract ID attribute. */
-            auto l_id = getAttributeStr("id");
-            if (is_blank(l_id))
+            const char* l_id = getAttribute("id");
+            if (l_id == nullptr || is_blank(l_id))
                 throw TypeException{"Every location must have a unique id attribute value"};
             read();
             /* Get name of the location. */
@@ -756,7 +930,7 @@ bool XMLReader::location()
 
             // anonymous locations get an internal name based on the ID
             if (is_blank(l_name))
-                l_name = "_" + l_id;
+                l_name.append("_").append(l_id);
             /* Remember the mapping from id to name */
             if (auto [_, ins] = names.insert_or_assign(l_id, l_name); !ins)
                 parser->handle_warning(TypeException{non_unique_id + l_id});
@@ -790,9 +964,9 @@ bool XMLReader::instance()
         try {
             std::string i_path = path.str(tag_t::INSTANCE);
             /* Extract ID attribute. */
-            auto i_id = getAttributeStr("id");
+            const char* i_id = getAttribute("id");
             read();
-            if (is_blank(i_id))
+            if (i_id == nullptr || is_blank(i_id))
                 throw TypeException{"Instance tag must have a unique \"id\" attribute"};
 
             /* Get name of the instance. */
@@ -947,12 +1121,12 @@ bool XMLReader::branchpoint()
     if (begin(tag_t::BRANCHPOINT, false)) {
         try {
             std::string b_path = path.str(tag_t::BRANCHPOINT);
-            auto b_id = getAttributeStr("id");
-            if (is_blank(b_id)) {
+            const char* b_id = getAttribute("id");
+            if (b_id == nullptr || is_blank(b_id)) {
                 throw TypeException{"Branchpoint must have a unique \"id\" attribute"};
             }
             /* assign an internal name based on the ID of the branchpoint. */
-            std::string b_name = "_" + b_id;
+            auto b_name = std::string{"_"}.append(b_id);
             /* Remember the mapping from id to name */
             if (auto [_, ins] = names.insert_or_assign(b_id, b_name); !ins)
                 parser->handle_warning(TypeException{non_unique_id + b_id});
@@ -979,10 +1153,10 @@ bool XMLReader::init()
 {
     if (begin(tag_t::INIT, false)) {
         /* Get reference attribute. */
-        char* ref = getAttribute("ref");
+        const char* ref = getAttribute("ref");
         /* Find location name for the reference. */
         if (ref) {
-            std::string name = get_name(ref);
+            const auto& name = get_name(ref);
             try {
                 parser->proc_location_init(name.c_str());
             } catch (TypeException& te) {
@@ -991,7 +1165,6 @@ bool XMLReader::init()
         } else {
             parser->handle_error(TypeException{"$Missing_initial_location"});
         }
-        xmlFree(ref);
         read();
         return true;
     } else {
@@ -1000,30 +1173,28 @@ bool XMLReader::init()
     return false;
 }
 
-std::string XMLReader::reference(const std::string& attributeName)
+const std::string& XMLReader::reference(const char* attributeName)
 {
-    char* id = getAttribute(attributeName.c_str());
-    std::string name = get_name(id);
-    xmlFree(id);
+    const auto& name = get_name(getAttribute(attributeName));
     read();
     return name;
 }
 
-std::string XMLReader::source()
+const std::string& XMLReader::source()
 {
     if (begin(tag_t::SOURCE, false))
         return reference("ref");
     throw TypeException{"Missing source element"};
 }
 
-std::string XMLReader::target()
+const std::string& XMLReader::target()
 {
     if (begin(tag_t::TARGET, false))
         return reference("ref");
     throw TypeException{"Missing target element"};
 }
 
-std::string XMLReader::anchor()
+const std::string& XMLReader::anchor()
 {
     if (begin(tag_t::ANCHOR, false))
         return reference("instanceid");
@@ -1046,19 +1217,17 @@ bool XMLReader::transition()
     if (begin(tag_t::TRANSITION)) {
         /* Add dummy position mapping to the transition element. */
         try {
-            char* type = getAttribute("controllable");
+            const char* type = getAttribute("controllable");
             bool control = (type == nullptr || (strcmp(type, "true") == 0));
-            xmlFree(type);
 
-            char* id = getAttribute("action");
-            auto actname = std::string{id ? id : "SKIP"};
-            xmlFree(id);
+            const char* id = getAttribute("action");
+            const char* actname = id ? id : "SKIP";
 
             read();
-            std::string from = source();
-            std::string to = target();
+            const auto& from = source();
+            const auto& to = target();
 
-            parser->proc_edge_begin(from.c_str(), to.c_str(), control, actname.c_str());
+            parser->proc_edge_begin(from.c_str(), to.c_str(), control, actname);
             while (label())
                 ;
             while (begin(tag_t::NAIL))
@@ -1087,7 +1256,7 @@ int XMLReader::parameter()
 bool XMLReader::templ()
 {
     if (begin(tag_t::TEMPLATE)) {
-        auto t_path = std::make_shared<std::string>(path.str(tag_t::TEMPLATE));
+        const auto t_path = parser->add_path(path.str(tag_t::TEMPLATE));
         read();
         try {
             /* Get the name and the parameters of the template. */
@@ -1103,14 +1272,14 @@ bool XMLReader::templ()
             /* Parse declarations, locations, branchpoints,
              * the init tag and the transitions of the template. */
             declaration();
-            while (location())
+            while (!truncated() && location())
                 ;
-            while (branchpoint())
+            while (!truncated() && branchpoint())
                 ;
             tracker.setPath(parser, t_path);
             tracker.increment(parser, 1);
             init();
-            while (transition())
+            while (!truncated() && transition())
                 ;
 
             /* Push template end to parser builder. */
@@ -1248,6 +1417,7 @@ bool XMLReader::formula()
         if (!isEmpty()) {
             read();
             std::string xpath = path.str(tag_t::FORMULA);
+            add_source(xpath);
             parser->query_formula((const char*)xmlTextReaderConstValue(reader.get()), xpath.c_str());
             close(tag_t::FORMULA);
         } else
@@ -1276,8 +1446,6 @@ bool XMLReader::option()
         auto key = getAttribute("key");
         auto value = getAttribute("value");
         parser->query_options(key, value);
-        xmlFree(key);
-        xmlFree(value);
         close(tag_t::OPTION);
         return true;
     }
@@ -1295,10 +1463,10 @@ bool XMLReader::expectation()
             parser->expectation_value(outcome, type, value);
             zero_or_more(tag_t::EXPECT, [this] {
                 if (begin(tag_t::RESOURCE, false)) {
-                    auto type = getAttributeStr("type");
-                    auto value = getAttributeStr("value");
-                    auto unit = getAttributeStr("unit");
-                    parser->expect_resource(type.c_str(), value.c_str(), unit.c_str());
+                    auto type = getAttribute("type");
+                    auto value = getAttribute("value");
+                    auto unit = getAttribute("unit");
+                    parser->expect_resource(type ? type : "", value ? value : "", unit ? unit : "");
                     close(tag_t::RESOURCE);
                     return true;
                 }
@@ -1323,22 +1491,51 @@ bool XMLReader::result()
 
 void XMLReader::project()
 {
-    if (!begin(tag_t::NTA) && !begin(tag_t::PROJECT))
-        throw TypeException{"$Missing_nta_or_project_tag"};
-    nta = begin(tag_t::NTA);  // "nta" or "project"?
-    if (newxta)
-        parse((const xmlChar*)utap_builtin_declarations(), S_DECLARATION);
-    read();
-    declaration();
-    while (templ())
-        ;
-    while (lscTempl())
+    while (step())
         ;
-    instantiation();
-    system();
-    if ((nta && !end(tag_t::NTA)) || (!nta && !end(tag_t::PROJECT)))
-        queries();
-    parser->done();
+}
+
+bool XMLReader::step()
+{
+    switch (stage) {
+    case stage_t::ROOT:
+        if (!begin(tag_t::NTA) && !begin(tag_t::PROJECT))
+            throw TypeException{"$Missing_nta_or_project_tag"};
+        nta = begin(tag_t::NTA);  // "nta" or "project"?
+        if (newxta)
+            parse((const xmlChar*)utap_builtin_declarations(), S_DECLARATION);
+        read();
+        stage = stage_t::DECLARATION;
+        return true;
+    case stage_t::DECLARATION:
+        declaration();
+        stage = stage_t::TEMPLATES;
+        return true;
+    case stage_t::TEMPLATES:
+        if (truncated() || !templ())
+            stage = stage_t::LSC_TEMPLATES;
+        return true;
+    case stage_t::LSC_TEMPLATES:
+        if (truncated() || !lscTempl())
+            stage = truncated() ? stage_t::DONE : stage_t::INSTANTIATION;  // the remainder is not read
+        return stage != stage_t::DONE;
+    case stage_t::INSTANTIATION:
+        instantiation();
+        stage = stage_t::SYSTEM;
+        return true;
+    case stage_t::SYSTEM:
+        system();
+        stage = stage_t::QUERIES;
+        return true;
+    case stage_t::QUERIES:
+        if ((nta && !end(tag_t::NTA)) || (!nta && !end(tag_t::PROJECT)))
+            queries();
+        parser->done();
+        stage = stage_t::DONE;
+        return false;
+    case stage_t::DONE: break;
+    }
+    return false;
 }
 
 bool XMLReader::model_options()
@@ -1363,7 +1560,7 @@ int32_t parse_XML_fd(int fd, ParserBuilder* pb, bool newxta)
     if (reader == nullptr)
         return -1;
     XMLReader(reader, pb, newxta).project();
-    return 0;
+    return pb->is_truncated() ? PARSE_TRUNCATED : 0;
 }
 
 int32_t parse_XML_file(const char* filename, ParserBuilder* pb, bool newxta)
@@ -1373,7 +1570,7 @@ int32_t parse_XML_file(const char* filename, ParserBuilder* pb, bool newxta)
     if (reader == nullptr)
         return -1;
     XMLReader(reader, pb, newxta).project();
-    return 0;
+    return pb->is_truncated() ? PARSE_TRUNCATED : 0;
 }
 
 int32_t parse_XML_buffer(const char* buffer, ParserBuilder* pb, bool newxta)
@@ -1383,12 +1580,241 @@ int32_t parse_XML_buffer(const char* buffer, ParserBuilder* pb, bool newxta)
         xmlReaderForMemory(buffer, length, "", "", XML_PARSE_NOCDATA | XML_PARSE_HUGE | XML_PARSE_RECOVER);
     if (reader == nullptr)
         return -1;
-    XMLReader(reader, pb, newxta).project();
-    return 0;
+    XMLReader(reader, pb, newxta, std::string_view{buffer, length}).project();
+    return pb->is_truncated() ? PARSE_TRUNCATED : 0;
 }
 
 /**
- * Get the contents of the XML element with the specified path
+ * The stream builds a tree with the libxml2 push parser and walks it
+ * with an XMLReader, one step at a time. A step may read an element
+ * of the project only once the element is complete, i.e. once the
+ * push parser has started on the next element or closed the root.
+ */
+struct XMLModelStream::state_t
+{
+    std::unique_ptr<ParserBuilder> owned; /**< The builder if owned by the stream */
+    ParserBuilder* builder;
+    bool newxta;
+    hooks_t hooks;
+    xmlParserCtxtPtr context{nullptr}; /**< The push parser building the tree */
+    std::optional<XMLReader> reader;   /**< Walks the tree, created once the root element has started */
+    bool finished{false};              /**< No more input will be fed */
+    bool declared{false};              /**< The global declarations have been reported to the hooks */
+    bool done{false};                  /**< The reader does not read any further */
+    xmlNodePtr cursor{nullptr};        /**< The last top-level element read so far, examined by ready() */
+    size_t passed{0};                  /**< The number of top-level elements up to the cursor */
+    int32_t status{0};
+    std::exception_ptr error;
+
+    state_t(ParserBuilder* builder, bool newxta, hooks_t hooks):
+        builder{builder}, newxta{newxta}, hooks{std::move(hooks)},
+        context{xmlCreatePushParserCtxt(nullptr, nullptr, nullptr, 0, "")}
+    {
+        if (context != nullptr) {
+            xmlCtxtUseOptions(context, XML_PARSE_NOCDATA | XML_PARSE_HUGE | XML_PARSE_RECOVER);
+            context->sax->startElementNs = start_element;
+        }
+    }
+    state_t(const state_t&) = delete;
+    state_t& operator=(const state_t&) = delete;
+    ~state_t()
+    {
+        reader.reset();  // the walker does not own the tree
+        if (context != nullptr) {
+            xmlFreeDoc(context->myDoc);
+            xmlFreeParserCtxt(context);
+        }
+    }
+
+    /** Builds the tree like the default handler and marks the self-closing tags for the XMLReader. */
+    static void start_element(void* context, const xmlChar* localname, const xmlChar* prefix, const xmlChar* uri,
+                              int nb_namespaces, const xmlChar** namespaces, int nb_attributes, int nb_defaulted,
+                              const xmlChar** attributes)
+    {
+        xmlSAX2StartElementNs(context, localname, prefix, uri, nb_namespaces, namespaces, nb_attributes, nb_defaulted,
+                              attributes);
+        const auto* ctxt = static_cast<xmlParserCtxtPtr>(context);
+        if (ctxt->node != nullptr && ctxt->input != nullptr && ctxt->input->cur != nullptr &&
+            ctxt->input->cur[0] == '/' && ctxt->input->cur[1] == '>')
+            ctxt->node->extra = self_closing;
+    }
+    /** Returns the first element from the node on, or nullptr. */
+    static xmlNodePtr element(xmlNodePtr node)
+    {
+        while (node != nullptr && node->type != XML_ELEMENT_NODE)
+            node = node->next;
+        return node;
+    }
+    /** Returns true if the next step of the reader only reads complete elements. */
+    bool ready();
+    /** Takes the steps of the reader which are ready. */
+    void advance();
+};
+
+bool XMLModelStream::state_t::ready()
+{
+    auto* root = xmlDocGetRootElement(context->myDoc);
+    if (finished || (root != nullptr && context->nodeNr == 0))
+        return true;  // the root element is closed
+    if (root == nullptr)
+        return false;
+    // move the cursor past the elements read so far, the tree only grows at the end
+    for (const auto read = reader ? reader->get_sections() : 0; passed < read; ++passed) {
+        auto* next = element(cursor != nullptr ? cursor->next : root->children);
+        if (next == nullptr)
+            break;
+        cursor = next;
+    }
+    // the next element which is not unknown must be followed by another element
+    auto found = false;
+    for (auto* node = element(cursor != nullptr ? cursor->next : root->children); node != nullptr;
+         node = element(node->next)) {
+        if (found)
+            return true;
+        found = tag_map.count((const char*)node->name) > 0;
+    }
+    return false;
+}
+
+void XMLModelStream::state_t::advance()
+{
+    try {
+        while (!done && ready()) {
+            if (!reader) {
+                xmlTextReaderPtr walker = xmlReaderWalker(context->myDoc);
+                if (walker == nullptr) {
+                    status = -1;
+                    done = true;
+                    return;
+                }
+                reader.emplace(walker, builder, newxta, true);
+            }
+            done = !reader->step();
+            if (done)
+                status = builder->is_truncated() ? PARSE_TRUNCATED : 0;
+            if (!declared && (done || reader->declared())) {
+                declared = true;
+                if (hooks.on_globals && !builder->is_truncated())
+                    hooks.on_globals();
+            }
+        }
+    } catch (...) {
+        error = std::current_exception();
+        done = true;
+    }
+}
+
+XMLModelStream::XMLModelStream(std::unique_ptr<ParserBuilder> builder, bool newxta, hooks_t hooks):
+    state{std::make_unique<state_t>(builder.get(), newxta, std::move(hooks))}
+{
+    state->owned = std::move(builder);
+}
+
+XMLModelStream::XMLModelStream(ParserBuilder& builder, bool newxta):
+    state{std::make_unique<state_t>(&builder, newxta, hooks_t{})}
+{}
+
+XMLModelStream::~XMLModelStream() = default;
+
+void XMLModelStream::feed(const char* data, size_t size)
+{
+    if (state->done || state->finished || state->context == nullptr)
+        return;
+    for (size_t pos = 0; pos < size;) {  // xmlParseChunk takes an int size
+        const auto n = std::min(size - pos, static_cast<size_t>(std::numeric_limits<int>::max()));
+        xmlParseChunk(state->context, data + pos, static_cast<int>(n), 0);
+        pos += n;
+    }
+    state->advance();
+}
+
+int32_t XMLModelStream::finish()
+{
+    if (state->finished)
+        throw std::logic_error("XMLModelStream::finish called twice");
+    state->finished = true;
+    if (state->context == nullptr)
+        return -1;
+    if (!state->done) {
+        xmlParseChunk(state->context, nullptr, 0, 1);
+        if (state->context->myDoc == nullptr) {
+            state->status = -1;
+            state->done = true;
+        }
+        state->advance();
+    }
+    if (state->error)
+        std::rethrow_exception(state->error);
+    return state->hooks.on_finish ? state->hooks.on_finish(state->status) : state->status;
+}
+
+std::string unescape_XML(std::string_view text)
+{
+    using namespace std::string_view_literals;
+    auto res = std::string{};
+    res.reserve(text.size());
+    for (size_t i = 0; i < text.size();) {
+        const auto rest = text.substr(i);
+        if (rest.substr(0, 9) == "<![CDATA["sv) {
+            auto end = rest.find("]]>"sv);
+            res.append(rest.substr(9, end == std::string_view::npos ? end : end - 9));
+            i = end == std::string_view::npos ? text.size() : i + end + 3;
+        } else if (rest.substr(0, 4) == "<!--"sv) {
+            auto end = rest.find("-->"sv);
+            i = end == std::string_view::npos ? text.size() : i + end + 3;
+        } else if (rest[0] == '&' && rest.find(';') != std::string_view::npos) {
+            const auto name = rest.substr(1, rest.find(';') - 1);
+            if (name == "lt"sv)
+                res += '<';
+            else if (name == "gt"sv)
+                res += '>';
+            else if (name == "amp"sv)
+                res += '&';
+            else if (name == "quot"sv)
+                res += '"';
+            else if (name == "apos"sv)
+                res += '\'';
+            else if (name.size() > 1 && name[0] == '#') {
+                const auto hex = name[1] == 'x';
+                auto code = uint32_t{0};
+                const auto* first = name.data() + (hex ? 2 : 1);
+                const auto* last = name.data() + name.size();
+                if (auto [p, ec] = std::from_chars(first, last, code, hex ? 16 : 10); ec != std::errc{} || p != last)
+                    res.append(rest.substr(0, name.size() + 2));  // not a character reference, keep as is
+                else if (code < 0x80)
+                    res += static_cast<char>(code);
+                else if (code < 0x800) {
+                    res += static_cast<char>(0xC0 | (code >> 6));
+                    res += static_cast<char>(0x80 | (code & 0x3F));
+                } else if (code < 0x10000) {
+                    res += static_cast<char>(0xE0 | (code >> 12));
+                    res += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    res += static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                    res += static_cast<char>(0xF0 | (code >> 18));
+                    res += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                    res += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    res += static_cast<char>(0x80 | (code & 0x3F));
+                }
+            } else
+                res.append(rest.substr(0, name.size() + 2));  // unknown entity, keep as is
+            i += name.size() + 2;
+        } else if (rest[0] == '\r') {  // end-of-line normalization
+            res += '\n';
+            i += rest.substr(0, 2) == "\r\n"sv ? 2 : 1;
+        } else {
+            res += rest[0];
+            ++i;
+        }
+    }
+    return res;
+}
+
+/**
+ * Get the contents of the XML element with the specified path.
+ * This builds an XPath context per call; when the model was parsed with
+ * parse_XML_buffer, prefer the source map of the document, see
+ * Document::find_source() and unescape_XML().
  * @param xmlDocPtr - The XML document.
  * @param pos - The position path
  * @return res - The contents
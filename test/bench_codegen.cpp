@@ -0,0 +1,200 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+/**
+ * Compares the guards, invariants and updates compiled by CodeGenerator
+ * with the reference interpreter of interpreter.h, and measures both. States are visited
+ * by a random walk in which every process moves on its own, ignoring
+ * synchronisations, and clocks advance by random delays.
+ *
+ * Usage: bench_codegen [steps] model.xml...
+ */
+
+#include "interpreter.h"
+
+#include "utap/codegen.h"
+#include "utap/utap.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+using reference::element_t;
+using reference::Interpreter;
+using reference::Unsupported;
+
+using clock_type = std::chrono::steady_clock;
+
+/** A guard or update met during the walk. */
+struct sample_t
+{
+    const element_t* element;
+    const UTAP::expression_t* expr;
+    UTAP::native_guard_t guard;
+    UTAP::native_update_t update;
+    std::vector<int32_t> state;
+    std::vector<double> clocks;
+};
+
+int run(const std::string& path, size_t steps)
+{
+    auto doc = UTAP::Document{};
+    if (parse_XML_file(path.c_str(), &doc, true) != 0 || doc.has_errors()) {
+        std::cout << path << ": skipped, the model has errors" << std::endl;
+        return 0;
+    }
+    auto elements = std::vector<element_t>{};
+    try {
+        const auto layout = UTAP::StateLayout{doc};
+        auto interpreter = Interpreter{layout};
+        elements = reference::elements(doc, interpreter);
+
+        auto start = clock_type::now();
+        const auto generator = UTAP::CodeGenerator{doc, layout};
+        const auto module =
+            UTAP::NativeModule{generator.get_source(), std::filesystem::temp_directory_path() / "utap_bench_codegen"};
+        const auto compile_time = std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+        if (module.get_process_count() != elements.size())
+            throw std::logic_error("The module has " + std::to_string(module.get_process_count()) + " processes");
+
+        auto rng = std::mt19937{42};
+        const auto& fields = layout.get_fields();
+        auto state = std::vector<int32_t>(fields.size());
+        for (size_t f = 0; f < fields.size(); ++f)
+            state[f] = fields[f].lower <= 0 && 0 <= fields[f].upper ? 0 : fields[f].lower;
+        for (auto& element : elements) {
+            const auto* init = static_cast<const UTAP::location_t*>(element.bound.templ->init.get_data());
+            state[element.location] = init != nullptr ? init->nr : 0;
+        }
+        auto clocks = std::vector<double>(layout.get_clocks().size() + 1);
+        auto samples = std::vector<sample_t>{};
+        size_t mismatches = 0, interpreted = 0;
+        auto compare = [&](const element_t& element, const UTAP::expression_t& expr, UTAP::native_guard_t guard) {
+            auto native = guard(state.data(), clocks.data()) != 0;
+            try {
+                auto copy = state;
+                auto reference = interpreter.value(expr, &element, copy.data(), clocks.data()) != 0;
+                ++interpreted;
+                samples.push_back({&element, &expr, guard, nullptr, state, clocks});
+                if (native != reference) {
+                    ++mismatches;
+                    std::cout << "  " << element.prefix << ": " << expr.str() << " is " << native << " natively"
+                              << std::endl;
+                }
+            } catch (const Unsupported&) {
+            }
+            return native;
+        };
+        for (size_t step = 0; step < steps && !elements.empty(); ++step) {
+            auto p = std::uniform_int_distribution<size_t>{0, elements.size() - 1}(rng);
+            const auto& element = elements[p];
+            const auto& templ = *element.bound.templ;
+            for (auto& clock : clocks)
+                clock += std::uniform_real_distribution<double>{0, 2}(rng);
+            clocks[0] = 0;
+            auto location = state[element.location];
+            for (const auto& loc : templ.locations)
+                if (loc.nr == location && !loc.invariant.empty())
+                    if (auto invariant = module.get_invariant(p, loc.nr))
+                        compare(element, loc.invariant, invariant);
+            auto enabled = std::vector<size_t>{};
+            auto e = size_t{0};
+            for (const auto& edge : templ.edges) {
+                if (edge.src != nullptr && edge.src->nr == location && edge.dst != nullptr &&
+                    edge.select.get_size() == 0) {
+                    if (auto guard = module.get_guard(p, e); guard != nullptr && compare(element, edge.guard, guard))
+                        enabled.push_back(e);
+                }
+                ++e;
+            }
+            if (enabled.empty())
+                continue;
+            auto chosen = enabled[std::uniform_int_distribution<size_t>{0, enabled.size() - 1}(rng)];
+            const auto& edge = templ.edges[chosen];
+            auto update = module.get_update(p, chosen);
+            if (update == nullptr)
+                continue;  // the walk cannot follow the edge
+            auto reference = state;
+            auto reference_clocks = clocks;
+            try {
+                interpreter.value(edge.assign, &element, reference.data(), reference_clocks.data());
+                ++interpreted;
+                samples.push_back({&element, &edge.assign, nullptr, update, state, clocks});
+            } catch (const Unsupported&) {
+                reference.clear();
+            }
+            update(state.data(), clocks.data());
+            if (!reference.empty() && (reference != state || reference_clocks != clocks)) {
+                ++mismatches;
+                std::cout << "  " << element.prefix << ": " << edge.assign.str() << " differs natively" << std::endl;
+            }
+            state[element.location] = edge.dst->nr;
+        }
+
+        auto measure = [&](bool native) {
+            auto begin = clock_type::now();
+            auto sum = 0.0;
+            for (auto& sample : samples) {
+                auto s = sample.state;
+                auto c = sample.clocks;
+                if (native && sample.guard != nullptr)
+                    sum += sample.guard(s.data(), c.data());
+                else if (native)
+                    sample.update(s.data(), c.data());
+                else
+                    sum += interpreter.value(*sample.expr, sample.element, s.data(), c.data());
+            }
+            auto time = std::chrono::duration<double, std::milli>(clock_type::now() - begin).count();
+            return std::make_pair(time, sum);
+        };
+        auto [interpreter_time, interpreter_sum] = measure(false);
+        auto [native_time, native_sum] = measure(true);
+        std::cout << path << ": " << elements.size() << " processes, " << generator.get_unsupported().size()
+                  << " not compiled, compiled in " << compile_time << " ms, " << interpreted
+                  << " evaluations compared, " << mismatches << " mismatches; interpreter " << interpreter_time
+                  << " ms, native " << native_time << " ms (" << interpreter_sum << ", " << native_sum
+                  << ")" << std::endl;
+        return mismatches == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cout << path << ": skipped, " << e.what() << std::endl;
+        return 0;
+    }
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    auto first = 1;
+    auto steps = size_t{10000};
+    if (argc > 1 && std::isdigit(static_cast<unsigned char>(argv[1][0]))) {
+        steps = std::stoul(argv[1]);
+        first = 2;
+    }
+    auto res = 0;
+    for (auto i = first; i < argc; ++i)
+        res |= run(argv[i], steps);
+    return res;
+}
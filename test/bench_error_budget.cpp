@@ -0,0 +1,83 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+/**
+ * Measures parsing and type checking of a pathological model with tens of
+ * thousands of cascading type errors, with and without an error budget.
+ *
+ * Usage: bench_error_budget [templates] [budget]
+ */
+
+#include "utap/utap.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+static std::string broken_model(int templates)
+{
+    auto os = std::ostringstream{};
+    os << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<nta>\n<declaration>int a = 1;\n";
+    for (auto i = 0; i < templates; ++i)
+        os << "int g" << i << " = a;\n";  // not computable at compile time
+    os << "</declaration>\n";
+    for (auto i = 0; i < templates; ++i) {
+        os << "<template><name>T" << i << "</name><declaration>clock x; int v = a;</declaration>\n"
+           << "<location id=\"id" << i << "_0\"><label kind=\"invariant\">x &gt; true</label></location>\n"
+           << "<location id=\"id" << i << "_1\"/>\n<init ref=\"id" << i << "_0\"/>\n";
+        for (auto j = 0; j < 4; ++j)
+            os << "<transition><source ref=\"id" << i << "_0\"/><target ref=\"id" << i << "_1\"/>"
+               << "<label kind=\"guard\">x == 1.5 &amp;&amp; v</label>"
+               << "<label kind=\"assignment\">x = true, v = x</label></transition>\n";
+        os << "</template>\n";
+    }
+    os << "<system>";
+    for (auto i = 0; i < templates; ++i)
+        os << "P" << i << " = T" << i << "();\n";
+    os << "system ";
+    for (auto i = 0; i < templates; ++i)
+        os << (i ? ", P" : "P") << i;
+    os << ";</system>\n</nta>\n";
+    return os.str();
+}
+
+static void run(const std::string& model, const char* name, std::optional<UTAP::error_budget_t> budget)
+{
+    using clock = std::chrono::steady_clock;
+    auto doc = UTAP::Document{};
+    const auto start = clock::now();
+    const auto res = parse_XML_buffer(model.c_str(), &doc, true, {}, budget);
+    const auto time = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    std::cout << name << ": " << time << " ms, " << doc.get_errors().size() << " errors, "
+              << doc.get_warnings().size() << " warnings" << (res == UTAP::PARSE_TRUNCATED ? " (truncated)" : "")
+              << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    const auto templates = argc > 1 ? std::stoi(argv[1]) : 5000;
+    const auto limit = argc > 2 ? std::stoul(argv[2]) : 100ul;
+    const auto model = broken_model(templates);
+    std::cout << "Model with " << templates << " broken templates, " << model.size() << " bytes" << std::endl;
+    run(model, "unlimited", std::nullopt);
+    run(model, "budget", UTAP::error_budget_t{limit, limit});
+}
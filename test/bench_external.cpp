@@ -0,0 +1,124 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+/**
+ * Measures calls of the functions of the external_fn test library
+ * through the typed invokers of ExternalFunction, one call at a time
+ * and batched, against dispatching every call from the function type.
+ *
+ * Usage: bench_external [calls] [library]
+ */
+
+#include "utap/expression.h"
+#include "utap/external.h"
+#include "utap/library.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef EXTERNAL_FN_LIBRARY
+#define EXTERNAL_FN_LIBRARY "libexternal_fn"
+#endif
+
+using namespace UTAP;
+using namespace UTAP::Constants;
+
+using clock_type = std::chrono::steady_clock;
+
+struct benchmark_t
+{
+    std::string name;
+    type_t type;
+    std::vector<external_value_t> arguments;  ///< one row per call
+};
+
+static double elapsed(clock_type::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    const auto calls = argc > 1 ? std::stoul(argv[1]) : 1000000ul;
+    auto library = Library{argc > 2 ? argv[2] : EXTERNAL_FN_LIBRARY};
+
+    const auto int_type = type_t::create_primitive(INT);
+    const auto double_type = type_t::create_primitive(DOUBLE);
+    const auto index_type =
+        type_t::create_range(int_type, expression_t::create_constant(0), expression_t::create_constant(2));
+    const auto array_type = type_t::create_array(double_type, index_type);
+    auto functions = std::vector<benchmark_t>{
+        {"multiply", type_t::create_external_function(int_type, {int_type, int_type}, {"a", "b"}), {}},
+        {"power", type_t::create_external_function(double_type, {double_type, int_type}, {"c", "a"}), {}},
+        {"calc_sum", type_t::create_external_function(double_type, {int_type, array_type}, {"n", "d"}), {}}};
+
+    auto rng = std::mt19937{42};
+    auto digit = std::uniform_int_distribution<int32_t>{0, 9};
+    auto arrays = std::vector<double>(3 * calls);
+    for (auto& value : arrays)
+        value = digit(rng);
+    for (size_t i = 0; i < calls; ++i) {
+        functions[0].arguments.insert(functions[0].arguments.end(), {digit(rng), digit(rng)});
+        functions[1].arguments.insert(functions[1].arguments.end(), {1.0 + digit(rng) / 10.0, digit(rng)});
+        functions[2].arguments.insert(functions[2].arguments.end(), {int32_t{3}, &arrays[3 * i]});
+    }
+
+    auto res = 0;
+    for (const auto& function : functions) {
+        auto* symbol = library.get_symbol(function.name);
+        const auto arity = function.type.size() - 1;
+        auto value = [&function](const external_value_t& result) {
+            return function.type[0].is_double() ? result.d : result.i;
+        };
+
+        // the calling convention is derived from the type for every call
+        auto start = clock_type::now();
+        auto dynamic = 0.0;
+        for (size_t i = 0; i < calls; ++i)
+            dynamic += value(ExternalFunction{symbol, function.type}(&function.arguments[i * arity]));
+        auto dynamic_time = elapsed(start);
+
+        start = clock_type::now();
+        const auto invoker = ExternalFunction{symbol, function.type};
+        auto single = 0.0;
+        for (size_t i = 0; i < calls; ++i)
+            single += value(invoker(&function.arguments[i * arity]));
+        auto single_time = elapsed(start);
+
+        start = clock_type::now();
+        auto results = std::vector<external_value_t>(calls);
+        invoker.call(function.arguments.data(), calls, results.data());
+        auto batched = 0.0;
+        for (const auto& result : results)
+            batched += value(result);
+        auto batched_time = elapsed(start);
+
+        if (dynamic != single || dynamic != batched)
+            res = 1;
+        std::cout << function.name << ": " << calls << " calls, dynamic " << dynamic_time / calls << " ns, typed "
+                  << single_time / calls << " ns, batched " << batched_time / calls << " ns (" << dynamic << ", "
+                  << single << ", " << batched << ")" << std::endl;
+    }
+    return res;
+}
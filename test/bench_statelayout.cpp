@@ -0,0 +1,122 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+/**
+ * Measures hashing and comparing of states stored as naive int32_t
+ * arrays, as byte aligned states and as bit-packed states planned by
+ * StateLayout for a system of many small processes.
+ *
+ * Usage: bench_statelayout [processes] [states]
+ */
+
+#include "utap/statelayout.h"
+#include "utap/utap.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::string many_processes(int processes)
+{
+    auto os = std::ostringstream{};
+    os << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<nta>\n"
+       << "<declaration>int[0,3] turn; bool flag[" << processes << "];</declaration>\n"
+       << "<template><name>T</name><parameter>const int id</parameter>"
+       << "<declaration>int[0,7] count; int[-1,1] dir; bool done;</declaration>\n";
+    for (auto i = 0; i < 5; ++i)
+        os << "<location id=\"id" << i << "\"><name>L" << i << "</name></location>\n";
+    os << "<init ref=\"id0\"/>\n";
+    for (auto i = 0; i < 5; ++i)
+        os << "<transition><source ref=\"id" << i << "\"/><target ref=\"id" << (i + 1) % 5 << "\"/>"
+           << "<label kind=\"assignment\">count = (count + 1) % 8, flag[id] = !flag[id]</label></transition>\n";
+    os << "</template>\n<system>";
+    for (auto i = 0; i < processes; ++i)
+        os << "P" << i << " = T(" << i << ");\n";
+    os << "system ";
+    for (auto i = 0; i < processes; ++i)
+        os << (i ? ", P" : "P") << i;
+    os << ";</system>\n</nta>\n";
+    return os.str();
+}
+
+/** FNV-1a over the bytes of a state. */
+static uint64_t hash(const void* data, size_t size)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i)
+        h = (h ^ bytes[i]) * 1099511628211ull;
+    return h;
+}
+
+/** Hashes every state and compares it with its successor, states are stored back to back. */
+static void measure(const char* name, const uint8_t* states, size_t count, size_t size)
+{
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    uint64_t sum = 0;
+    size_t equal = 0;
+    for (size_t i = 0; i < count; ++i) {
+        sum += hash(states + i * size, size);
+        if (i + 1 < count && std::memcmp(states + i * size, states + (i + 1) * size, size) == 0)
+            ++equal;
+    }
+    const auto time = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    std::cout << name << ": " << size << " bytes per state, " << time << " ms (" << (sum & 0xff) << ", " << equal
+              << " equal)" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    const auto processes = argc > 1 ? std::stoi(argv[1]) : 100;
+    const auto count = argc > 2 ? std::stoul(argv[2]) : 200000ul;
+    auto doc = UTAP::Document{};
+    if (parse_XML_buffer(many_processes(processes).c_str(), &doc, true) != 0 || doc.has_errors()) {
+        std::cerr << "The generated model has errors" << std::endl;
+        return 1;
+    }
+    const auto layout = UTAP::StateLayout{doc};
+    const auto& fields = layout.get_fields();
+    std::cout << processes << " processes, " << fields.size() << " fields, " << count << " states" << std::endl;
+
+    auto rng = std::mt19937{42};
+    auto naive = std::vector<int32_t>(count * fields.size());
+    for (size_t i = 0; i < count; ++i)
+        for (size_t f = 0; f < fields.size(); ++f)
+            naive[i * fields.size() + f] =
+                std::uniform_int_distribution<int32_t>{fields[f].lower, fields[f].upper}(rng);
+
+    auto packed = std::vector<uint64_t>(count * layout.get_packed_words());
+    auto aligned = std::vector<uint8_t>(count * layout.get_aligned_bytes());
+    for (size_t i = 0; i < count; ++i) {
+        layout.pack(&naive[i * fields.size()], &packed[i * layout.get_packed_words()]);
+        layout.pack_aligned(&naive[i * fields.size()], &aligned[i * layout.get_aligned_bytes()]);
+    }
+
+    measure("int32 array", reinterpret_cast<const uint8_t*>(naive.data()), count, fields.size() * sizeof(int32_t));
+    measure("byte aligned", aligned.data(), count, layout.get_aligned_bytes());
+    measure("bit-packed", reinterpret_cast<const uint8_t*>(packed.data()), count,
+            layout.get_packed_words() * sizeof(uint64_t));
+}
@@ -0,0 +1,73 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+/**
+ * Measures loading of a template with many locations and transitions,
+ * dominated by the XML reader and the id to name resolution.
+ *
+ * Usage: bench_xmlreader [transitions] [locations] [repetitions]
+ */
+
+#include "utap/utap.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+static std::string large_template(int transitions, int locations)
+{
+    auto os = std::ostringstream{};
+    os << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<nta>\n<declaration>chan c; int v;</declaration>\n"
+       << "<template><name>P</name><declaration>clock x;</declaration>\n";
+    for (auto i = 0; i < locations; ++i)
+        os << "<location id=\"id" << i << "\" x=\"" << i << "\" y=\"0\"><name x=\"0\" y=\"0\">L" << i
+           << "</name></location>\n";
+    os << "<init ref=\"id0\"/>\n";
+    for (auto i = 0; i < transitions; ++i)
+        os << "<transition id=\"t" << i << "\"><source ref=\"id" << (i % locations) << "\"/><target ref=\"id"
+           << ((i * 7 + 1) % locations) << "\"/><label kind=\"guard\" x=\"0\" y=\"0\">x &gt;= " << (i % 10)
+           << "</label><label kind=\"synchronisation\" x=\"0\" y=\"0\">c" << (i % 2 ? '!' : '?')
+           << "</label><label kind=\"assignment\" x=\"0\" y=\"0\">v = " << i << "</label><nail x=\"1\" y=\"2\"/>"
+           << "</transition>\n";
+    os << "</template>\n<system>system P;</system>\n</nta>\n";
+    return os.str();
+}
+
+int main(int argc, char* argv[])
+{
+    using clock = std::chrono::steady_clock;
+    const auto transitions = argc > 1 ? std::stoi(argv[1]) : 50000;
+    const auto locations = argc > 2 ? std::stoi(argv[2]) : 1000;
+    const auto repetitions = argc > 3 ? std::stoi(argv[3]) : 3;
+    const auto model = large_template(transitions, locations);
+    std::cout << "Template with " << locations << " locations and " << transitions << " transitions, "
+              << model.size() << " bytes" << std::endl;
+    for (auto r = 0; r < repetitions; ++r) {
+        auto doc = UTAP::Document{};
+        const auto start = clock::now();
+        const auto res = parse_XML_buffer(model.c_str(), &doc, true);
+        const auto time = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        std::cout << "parse_XML_buffer: " << time << " ms, result " << res << ", "
+                  << doc.get_templates().front().edges.size() << " edges, " << doc.get_errors().size()
+                  << " errors" << std::endl;
+    }
+}
@@ -0,0 +1,110 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/activeclocks.h"
+#include "utap/clockbounds.h"
+#include "utap/utap.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+static std::ostream& print_bound(std::ostream& os, int32_t bound)
+{
+    if (bound == UTAP::clock_bound_t::none)
+        return os << "-";
+    if (bound == UTAP::clock_bound_t::infinity)
+        return os << "inf";
+    return os << bound;
+}
+
+template <typename Clocks>
+static std::ostream& print_clocks(std::ostream& os, const Clocks& clocks)
+{
+    os << "{";
+    auto sep = "";
+    for (const auto& clock : clocks) {
+        os << sep << clock.get_name();
+        sep = ", ";
+    }
+    return os << "}";
+}
+
+static void report(UTAP::Document& document)
+{
+    const auto& bounds = document.get_clock_bounds();
+    const auto& active = document.get_active_clocks();
+    std::cout << "Clock bounds (L, U):" << std::endl;
+    for (const auto& [clock, bound] : bounds.get_global()) {
+        std::cout << "  " << clock.get_name() << ": ";
+        print_bound(std::cout, bound.lower) << ", ";
+        print_bound(std::cout, bound.upper) << std::endl;
+    }
+    if (bounds.has_diagonals())
+        std::cout << "  (difference constraints: LU extrapolation does not apply)" << std::endl;
+    for (const auto& templ : document.get_templates()) {
+        if (!templ.is_TA)
+            continue;
+        std::cout << "Template " << templ.uid.get_name() << ":" << std::endl;
+        for (const auto& location : templ.locations) {
+            std::cout << "  " << location.uid.get_name() << " active ";
+            print_clocks(std::cout, active.get_active(location)) << std::endl;
+        }
+        for (const auto& cls : active.get_classes(templ)) {
+            if (cls.size() < 2)
+                continue;
+            std::cout << "  can share one clock: ";
+            print_clocks(std::cout, cls) << std::endl;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const auto command = std::filesystem::path{argv[0]}.filename().string();
+    if (argc != 2) {
+        std::cerr << command << " reports the clock bounds and the active clocks per location of a given model\n"
+                  << "Usage: " << command << " [model-file-path]" << std::endl;
+        return 1;
+    }
+    for (auto i = 1; i < argc; ++i) {
+        auto path = std::filesystem::path{argv[i]};
+        try {
+            if (!exists(path))
+                throw std::system_error{ENOENT, std::system_category(), path.string()};
+            auto ifs = std::ifstream{};
+            ifs.exceptions(std::ifstream::failbit | std::ifstream::badbit | std::ifstream::eofbit);
+            ifs.open(path);
+            auto content = std::string{std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{}};
+
+            auto document = std::make_unique<UTAP::Document>();
+            if (parse_XML_buffer(content.c_str(), document.get(), true) != 0 || document->has_errors())
+                throw std::runtime_error("the model has errors, see syntaxcheck");
+
+            std::cout << "UTAP clock checker" << std::endl;
+            std::cout << "Checking file: " << path << std::endl;
+            report(*document);
+        } catch (std::exception& ex) {
+            std::cerr << "Failed to process " << path << ":\n" << ex.what() << std::endl;
+        }
+    }
+}
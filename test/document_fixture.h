@@ -87,6 +87,16 @@ class template_fixture
     std::string name;
     std::string parameters{};
     std::string declarations{};
+    std::string init{};
+    std::string locations{};
+    std::string edges{};
+
+    static std::string label(const char* kind, const std::string& text)
+    {
+        if (text.empty())
+            return {};
+        return string_format(R"XML(<label kind="%s">%s</label>)XML", kind, escape_xml(text).c_str());
+    }
 
 public:
     template_fixture(std::string name): name{std::move(name)} {}
@@ -105,6 +115,27 @@ public:
         declarations += escape_xml(std::move(text));
         return *this;
     }
+    /** Adds a location, the first one is the initial location. Without locations there is a single one: id0 */
+    template_fixture& add_location(const std::string& id, const std::string& invariant = {})
+    {
+        if (init.empty())
+            init = id;
+        locations += string_format(R"XML(
+        <location id="%s" x="0" y="0"><name>%s</name>%s</location>)XML",
+                                   id.c_str(), id.c_str(), label("invariant", invariant).c_str());
+        return *this;
+    }
+    template_fixture& add_edge(const std::string& source, const std::string& target, const std::string& guard = {},
+                               const std::string& assignment = {}, const std::string& sync = {},
+                               const std::string& select = {})
+    {
+        edges += string_format(R"XML(
+        <transition><source ref="%s"/><target ref="%s"/>%s%s%s%s</transition>)XML",
+                               source.c_str(), target.c_str(), label("select", select).c_str(),
+                               label("guard", guard).c_str(),
+                               label("synchronisation", sync).c_str(), label("assignment", assignment).c_str());
+        return *this;
+    }
     std::string str() const
     {
         static constexpr const char* simple_template = R"XML("<template>
@@ -114,7 +145,16 @@ public:
         <location id="id0" x="0" y="0"/>
         <init ref="id0"/>
     </template>")XML";
-        return string_format(simple_template, name.c_str(), parameters.c_str(), declarations.c_str());
+        static constexpr const char* graph_template = R"XML(<template>
+        <name x="5" y="5">%s</name>
+        <parameter>%s</parameter>
+        <declaration>%s</declaration>%s
+        <init ref="%s"/>%s
+    </template>)XML";
+        if (locations.empty())
+            return string_format(simple_template, name.c_str(), parameters.c_str(), declarations.c_str());
+        return string_format(graph_template, name.c_str(), parameters.c_str(), declarations.c_str(),
+                             locations.c_str(), init.c_str(), edges.c_str());
     }
 
 private:
@@ -157,6 +197,7 @@ class QueryFixture
 public:
     QueryFixture(std::unique_ptr<UTAP::Document> new_doc): doc{std::move(new_doc)}, query_builder{*doc} {}
     auto get_errors() const { return doc->get_errors(); }
+    UTAP::Document& get_document() { return *doc; }
     const UTAP::PropInfo& parse_query(const char* query)
     {
         auto result = parseProperty(query, &query_builder);
@@ -213,7 +254,7 @@ public:
     {
         if (!processes.empty())
             processes += ", ";
-        processes += std::move(name);
+        processes += escape_xml(std::move(name));
         return *this;
     }
     /** Compiles an XML string representation of a document */
@@ -22,6 +22,8 @@
 
 #include "utap/featurechecker.h"
 
+#include "utap/costmodel.h"
+#include "utap/statement.h"
 #include "utap/utap.h"
 
 #include <filesystem>
@@ -29,15 +31,72 @@
 #include <iostream>
 #include <system_error>
 
+static std::ostream& print_cost(std::ostream& os, uint64_t cost)
+{
+    if (cost == UTAP::CostModel::unbounded)
+        return os << "unbounded";
+    return os << cost;
+}
+
+/** Prints the first line of the statement. */
+static std::ostream& print_head(std::ostream& os, const UTAP::Statement& stat)
+{
+    if (const auto* iteration = dynamic_cast<const UTAP::IterationStatement*>(&stat))
+        return os << "for (" << iteration->symbol.get_name() << " : " << iteration->symbol.get_type().str() << ")";
+    auto text = stat.str("");
+    return os << text.substr(0, text.find('\n'));
+}
+
+static void report_costs(UTAP::Document& document)
+{
+    const auto& costs = document.get_cost_model();
+    std::cout << "Estimated costs (operations):" << std::endl;
+    auto functions = [&costs](const UTAP::declarations_t& declarations, const std::string& indent) {
+        for (const auto& fun : declarations.functions) {
+            std::cout << indent << fun.uid.get_name() << "(): ";
+            print_cost(std::cout, costs.get_cost(fun)) << std::endl;
+            for (const auto& loop : costs.get_loops()) {
+                if (loop.function != &fun)
+                    continue;
+                std::cout << indent << "  ";
+                print_head(std::cout, *loop.statement) << " iterates ";
+                if (loop.trips)
+                    std::cout << "at most " << *loop.trips << " times" << std::endl;
+                else
+                    std::cout << "without bound" << std::endl;
+            }
+        }
+    };
+    functions(document.get_globals(), "  ");
+    for (const auto& templ : document.get_templates()) {
+        std::cout << "Template " << templ.uid.get_name() << ":" << std::endl;
+        functions(templ, "  ");
+        for (const auto& location : templ.locations) {
+            if (location.invariant.empty())
+                continue;
+            std::cout << "  invariant " << location.uid.get_name() << ": ";
+            print_cost(std::cout, costs.get_invariant_cost(location)) << std::endl;
+        }
+        for (const auto& edge : templ.edges) {
+            std::cout << "  edge " << edge.nr << ": guard ";
+            print_cost(std::cout, costs.get_guard_cost(edge)) << ", update ";
+            print_cost(std::cout, costs.get_update_cost(edge)) << std::endl;
+        }
+    }
+}
+
 int main(int argc, char** argv)
 {
     const auto command = std::filesystem::path{argv[0]}.filename().string();
-    if (argc != 2) {
+    const auto costs = argc == 3 && std::string{argv[1]} == "--cost";
+    if (argc != 2 && !costs) {
         std::cerr << command << " checks which features are supported by UPPAAL for a given model\n"
-                  << "Usage: " << command << " [model-file-path]" << std::endl;
+                  << "Usage: " << command << " [--cost] [model-file-path]\n"
+                  << "  --cost  reports the estimated costs of the functions, guards, invariants and updates"
+                  << std::endl;
         return 1;
     }
-    for (auto i = 1u; i < argc; ++i) {
+    for (auto i = costs ? 2 : 1; i < argc; ++i) {
         auto path = std::filesystem::path{argv[i]};
         try {
             if (!exists(path))
@@ -58,6 +117,10 @@ int main(int argc, char** argv)
             std::cout << "Supports symbolic: " << type.symbolic << std::endl;
             std::cout << "Supports concrete: " << type.concrete << std::endl;
             std::cout << "Supports stochastic: " << type.stochastic << std::endl;
+            if (costs && document->has_errors())
+                std::cout << "Costs are not estimated, the model has errors" << std::endl;
+            else if (costs)
+                report_costs(*document);
         } catch (std::exception& ex) {
             std::cerr << "Failed to process " << path << ":\n" << ex.what() << std::endl;
         }
@@ -0,0 +1,299 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+/**
+ * A straightforward AST interpreter of guards, invariants and updates,
+ * which looks up variables by their name in the StateLayout. It is the
+ * reference the code of CodeGenerator is compared with.
+ */
+
+#ifndef UTAP_TEST_INTERPRETER_H
+#define UTAP_TEST_INTERPRETER_H
+
+#include "utap/evaluator.h"
+#include "utap/statelayout.h"
+#include "utap/statement.h"
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace reference {
+using namespace UTAP::Constants;
+
+/** A process of the layout with its unbound parameters bound. */
+struct element_t
+{
+    UTAP::instance_t bound;
+    std::string prefix;
+    size_t location;
+};
+
+/** Thrown for expressions the interpreter does not support, e.g. loops in functions. */
+struct Unsupported : std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+class Interpreter
+{
+    std::map<std::string, size_t> fields;
+    std::map<std::string, size_t> clocks;
+    const UTAP::instance_t global{};
+    /** The parameters and local variables of the functions being called, innermost last. */
+    mutable std::vector<std::map<UTAP::symbol_t, double>> calls;
+
+    double* local(const UTAP::expression_t& expr) const
+    {
+        if (calls.empty() || expr.get_kind() != IDENTIFIER)
+            return nullptr;
+        auto it = calls.back().find(expr.get_symbol());
+        return it != calls.back().end() ? &it->second : nullptr;
+    }
+
+    int32_t constant(const UTAP::expression_t& expr, const UTAP::instance_t& scope) const
+    {
+        auto value = UTAP::ConstantEvaluator{scope}.evaluate(expr);
+        if (!value)
+            throw Unsupported("Not constant: " + expr.str());
+        return *value;
+    }
+
+    /** Returns the name of the variable (element) in the layout. */
+    std::string name(const UTAP::expression_t& expr, const element_t* element, int32_t* s, double* c) const
+    {
+        const auto& scope = element != nullptr ? element->bound : global;
+        switch (expr.get_kind()) {
+        case IDENTIFIER: {
+            auto symbol = expr.get_symbol();
+            // references are bound to global variables, mutable parameters are variables of the process
+            if (auto it = scope.mapping.find(symbol); it != scope.mapping.end() && symbol.get_type().is(REF))
+                return name(it->second, nullptr, s, c);
+            if (element != nullptr && (element->bound.templ->frame.contains(symbol) ||
+                                       element->bound.templ->parameters.contains(symbol)))
+                return element->prefix + "." + symbol.get_name();
+            return symbol.get_name();
+        }
+        case ARRAY: {
+            auto lower = constant(expr[0].get_type().get_array_size().get_range().first, scope);
+            auto index = static_cast<int32_t>(value(expr[1], element, s, c)) - lower;
+            return name(expr[0], element, s, c) + "[" + std::to_string(index) + "]";
+        }
+        case DOT:
+            if (!expr[0].get_type().is_record())
+                throw Unsupported("Not a record: " + expr.str());
+            return name(expr[0], element, s, c) + "." + expr[0].get_type().get_record_label(expr.get_index());
+        default: throw Unsupported("Not a variable: " + expr.str());
+        }
+    }
+
+    double variable(const UTAP::expression_t& expr, const element_t* element, int32_t* s, double* c) const
+    {
+        if (const auto* value = local(expr))
+            return *value;
+        auto variable = name(expr, element, s, c);
+        if (auto it = clocks.find(variable); it != clocks.end())
+            return c[it->second + 1];
+        if (auto it = fields.find(variable); it != fields.end())
+            return s[it->second];
+        throw Unsupported("Unknown variable: " + variable);
+    }
+
+    void store(const UTAP::expression_t& expr, const element_t* element, int32_t* s, double* c, double value) const
+    {
+        if (auto* variable = local(expr)) {
+            *variable = static_cast<int32_t>(value);
+            return;
+        }
+        auto variable = name(expr, element, s, c);
+        if (auto it = clocks.find(variable); it != clocks.end())
+            c[it->second + 1] = value;
+        else if (auto it = fields.find(variable); it != fields.end())
+            s[it->second] = static_cast<int32_t>(value);
+        else
+            throw Unsupported("Unknown variable: " + variable);
+    }
+
+    /** Executes the statement of a function body, returns the value returned, if any. */
+    std::optional<double> execute(UTAP::Statement* stat, const element_t* element, int32_t* s, double* c) const
+    {
+        if (auto* block = dynamic_cast<UTAP::BlockStatement*>(stat)) {
+            auto frame = block->get_frame();
+            for (uint32_t i = 0; i < frame.get_size(); ++i) {
+                const auto* var = static_cast<const UTAP::variable_t*>(frame[i].get_data());
+                if (var != nullptr && calls.back().count(frame[i]) == 0)
+                    calls.back()[frame[i]] = var->init.empty() ? 0 : value(var->init, element, s, c);
+            }
+            for (auto& inner : *block)
+                if (auto res = execute(inner.get(), element, s, c))
+                    return res;
+            return std::nullopt;
+        }
+        if (auto* expr = dynamic_cast<UTAP::ExprStatement*>(stat)) {
+            value(expr->expr, element, s, c);
+            return std::nullopt;
+        }
+        if (auto* ret = dynamic_cast<UTAP::ReturnStatement*>(stat))
+            return ret->value.empty() ? 0 : value(ret->value, element, s, c);
+        if (auto* branch = dynamic_cast<UTAP::IfStatement*>(stat)) {
+            auto* taken = value(branch->cond, element, s, c) != 0 ? branch->trueCase.get() : branch->falseCase.get();
+            return taken != nullptr ? execute(taken, element, s, c) : std::nullopt;
+        }
+        if (dynamic_cast<UTAP::EmptyStatement*>(stat) != nullptr)
+            return std::nullopt;
+        throw Unsupported("Unsupported statement: " + stat->str(""));
+    }
+
+    /** Calls a function with integer parameters passed by value. */
+    double call(const UTAP::expression_t& expr, const element_t* element, int32_t* s, double* c) const
+    {
+        const auto* fun = static_cast<const UTAP::function_t*>(expr[0].get_symbol().get_data());
+        if (fun == nullptr || dynamic_cast<const UTAP::ExternalBlockStatement*>(fun->body.get()) != nullptr)
+            throw Unsupported("Unsupported function: " + expr.str());
+        auto type = fun->uid.get_type();
+        auto frame = fun->body->get_frame();
+        auto arguments = std::map<UTAP::symbol_t, double>{};
+        for (uint32_t i = 1; i < expr.get_size(); ++i) {
+            auto parameter = type[i];
+            if (parameter.is_array() || parameter.is_record() || (parameter.is(REF) && !parameter.is_constant()))
+                throw Unsupported("Unsupported parameter: " + expr.str());
+            arguments[frame[i - 1]] = value(expr[i], element, s, c);
+        }
+        calls.push_back(std::move(arguments));
+        try {
+            auto res = execute(fun->body.get(), element, s, c);
+            calls.pop_back();
+            return res.value_or(0);
+        } catch (...) {
+            calls.pop_back();
+            throw;
+        }
+    }
+
+public:
+    explicit Interpreter(const UTAP::StateLayout& layout)
+    {
+        for (size_t i = 0; i < layout.get_fields().size(); ++i)
+            fields.emplace(layout.get_fields()[i].name, i);
+        for (size_t i = 0; i < layout.get_clocks().size(); ++i)
+            clocks.emplace(layout.get_clocks()[i].name, i);
+    }
+
+    size_t find(const std::string& field) const { return fields.at(field); }
+
+    double value(const UTAP::expression_t& expr, const element_t* element, int32_t* s, double* c) const
+    {
+        if (expr.empty())
+            return 1;  // an empty guard holds, an empty update does nothing
+        const auto& scope = element != nullptr ? element->bound : global;
+        auto type = expr.get_type();
+        if ((type.is(INT) || type.is(BOOL)) && !expr.changes_any_variable()) {
+            if (auto value = UTAP::ConstantEvaluator{scope}.evaluate(expr))
+                return *value;
+        }
+        auto v = [&](uint32_t i) { return value(expr[i], element, s, c); };
+        auto i = [&](uint32_t i) { return static_cast<int32_t>(value(expr[i], element, s, c)); };
+        switch (expr.get_kind()) {
+        case CONSTANT: return expr.get_value();
+        case IDENTIFIER:
+        case ARRAY:
+        case DOT: return variable(expr, element, s, c);
+        case PLUS: return v(0) + v(1);
+        case MINUS: return v(0) - v(1);
+        case MULT: return v(0) * v(1);
+        case DIV: return i(0) / i(1);
+        case MOD: return i(0) % i(1);
+        case BIT_AND: return i(0) & i(1);
+        case BIT_OR: return i(0) | i(1);
+        case BIT_XOR: return i(0) ^ i(1);
+        case BIT_LSHIFT: return i(0) << i(1);
+        case BIT_RSHIFT: return i(0) >> i(1);
+        case AND: return v(0) != 0 && v(1) != 0;
+        case OR: return v(0) != 0 || v(1) != 0;
+        case XOR: return (v(0) != 0) != (v(1) != 0);
+        case MIN: return std::min(v(0), v(1));
+        case MAX: return std::max(v(0), v(1));
+        case LT: return v(0) < v(1);
+        case LE: return v(0) <= v(1);
+        case EQ: return v(0) == v(1);
+        case NEQ: return v(0) != v(1);
+        case GE: return v(0) >= v(1);
+        case GT: return v(0) > v(1);
+        case NOT: return v(0) == 0;
+        case UNARY_MINUS: return -v(0);
+        case INLINE_IF: return v(0) != 0 ? v(1) : v(2);
+        case COMMA: return v(0), v(1);
+        case FUN_CALL: return call(expr, element, s, c);
+        case ASSIGN: {
+            auto res = v(1);
+            store(expr[0], element, s, c, res);
+            return res;
+        }
+        case ASS_PLUS:
+        case ASS_MINUS:
+        case ASS_MULT: {
+            auto old = v(0);
+            auto kind = expr.get_kind();
+            auto res = kind == ASS_PLUS ? old + v(1) : kind == ASS_MINUS ? old - v(1) : old * v(1);
+            store(expr[0], element, s, c, res);
+            return res;
+        }
+        case PRE_INCREMENT:
+        case PRE_DECREMENT:
+        case POST_INCREMENT:
+        case POST_DECREMENT: {
+            auto old = v(0);
+            auto kind = expr.get_kind();
+            auto res = old + (kind == PRE_INCREMENT || kind == POST_INCREMENT ? 1 : -1);
+            store(expr[0], element, s, c, res);
+            return kind == PRE_INCREMENT || kind == PRE_DECREMENT ? res : old;
+        }
+        default: throw Unsupported("Unsupported: " + expr.str());
+        }
+    }
+};
+
+/** Returns the processes of the layout with the unbound parameters of process sets bound, in the order of the
+ * code generator. */
+std::vector<element_t> elements(UTAP::Document& doc, const Interpreter& interpreter)
+{
+    auto res = std::vector<element_t>{};
+    for (const auto& process : doc.get_processes()) {
+        if (process.templ == nullptr)
+            continue;
+        for (const auto& arguments : UTAP::StateLayout::enumerate_arguments(process)) {
+            auto& element = res.emplace_back(element_t{process, process.uid.get_name(), 0});
+            for (size_t i = 0; i < arguments.size(); ++i) {
+                element.bound.mapping[process.parameters[i]] = UTAP::expression_t::create_constant(arguments[i]);
+                element.prefix += (i == 0 ? "(" : ",") + std::to_string(arguments[i]);
+                element.prefix += i + 1 == arguments.size() ? ")" : "";
+            }
+            element.location = interpreter.find(element.prefix + ".location");
+        }
+    }
+    return res;
+}
+}  // namespace reference
+
+#endif /* UTAP_TEST_INTERPRETER_H */
@@ -20,8 +20,10 @@
 */
 
 #include "utap/utap.h"
+#include "utap/valueranges.h"
 
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -31,34 +33,74 @@ using std::cout;
 using std::cerr;
 using std::vector;
 
+static void print_usage()
+{
+    std::cerr << "Synopsis: check [-b] [-r] [--max-errors N] [--max-warnings N] <filename>\n"
+              << "  -b                 use the old (3.x) syntax\n"
+              << "  -r                 warn about assignments which are always out of range\n"
+              << "  --max-errors N     stop after N errors (0 means no limit)\n"
+              << "  --max-warnings N   stop after N warnings (0 means no limit)" << std::endl;
+}
+
 int main(int argc, char* argv[])
 {
     using namespace std::literals::string_literals;
     try {
-        if (argc < 2 || argc > 3) {
-            std::cerr << "Synopsis: check [-b] <filename>" << std::endl;
+        auto old = false;
+        auto ranges = false;
+        auto budget = UTAP::error_budget_t{};
+        auto args = vector<std::string>{argv + 1, argv + argc};
+        auto name = std::string{};
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (args[i] == "-b") {
+                old = true;
+            } else if (args[i] == "-r") {
+                ranges = true;
+            } else if (args[i] == "--max-errors" && i + 1 < args.size()) {
+                budget.errors = std::stoul(args[++i]);
+            } else if (args[i] == "--max-warnings" && i + 1 < args.size()) {
+                budget.warnings = std::stoul(args[++i]);
+            } else if (name.empty() && args[i][0] != '-') {
+                name = args[i];
+            } else {
+                print_usage();
+                return 1;
+            }
+        }
+        if (name.empty()) {
+            print_usage();
             return 1;
         }
-        auto old = ("-b"s == argv[1]);
 
         Document system;
-        auto name = std::string{argv[argc - 1]};
 
-        if (name.substr(name.length() - 4) == ".xml") {
-            parse_XML_file(name.c_str(), &system, !old);
+        if (name.length() > 4 && name.substr(name.length() - 4) == ".xml") {
+            parse_XML_file(name.c_str(), &system, !old, {}, budget);
         } else {
             FILE* file = fopen(name.c_str(), "r");
             if (!file) {
                 perror("check");
                 return 1;
             }
-            parse_XTA(file, &system, !old);
+            parse_XTA(file, &system, !old, budget);
             fclose(file);
         }
+        if (ranges && !system.has_errors()) {
+            for (const auto& violation : system.get_value_ranges().get_violations()) {
+                auto os = std::ostringstream{};
+                os << "Assigned values " << violation.value << " are outside of the declared range "
+                   << violation.declared;
+                system.add_warning(violation.expr.get_position(), os.str(), violation.expr.str());
+            }
+        }
         for (const auto& err : system.get_errors())
             cerr << err << endl;
         for (const auto& warn : system.get_warnings())
             cerr << warn << endl;
+        if (system.is_truncated()) {
+            cerr << "Checking stopped early (truncated): too many errors or warnings" << endl;
+            return 2;
+        }
         return system.get_errors().empty() && system.get_warnings().empty() ? 0 : 2;
     } catch (std::exception& e) {
         cerr << e.what() << endl;
@@ -0,0 +1,1062 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "document_fixture.h"
+#include "interpreter.h"
+
+#include "utap/activeclocks.h"
+#include "utap/clockbounds.h"
+#include "utap/codegen.h"
+#include "utap/costmodel.h"
+#include "utap/edgeindex.h"
+#include "utap/evaluator.h"
+#include "utap/guardform.h"
+#include "utap/hashcons.h"
+#include "utap/inliner.h"
+#include "utap/priority.h"
+#include "utap/selectexpansion.h"
+#include "utap/simplifier.h"
+#include "utap/slicing.h"
+#include "utap/specialiser.h"
+#include "utap/statelayout.h"
+#include "utap/symmetry.h"
+#include "utap/valueranges.h"
+
+#include <doctest/doctest.h>
+
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+using UTAP::clock_bound_t;
+
+static UTAP::symbol_t find_symbol(const UTAP::frame_t& frame, const std::string& name)
+{
+    auto index = frame.get_index_of(name);
+    REQUIRE(index);
+    return frame[*index];
+}
+
+static const UTAP::template_t& find_template(UTAP::Document& doc, const std::string& name)
+{
+    for (const auto& templ : doc.get_templates())
+        if (templ.uid.get_name() == name)
+            return templ;
+    FAIL("No template named " << name);
+    throw std::logic_error("unreachable");
+}
+
+static const UTAP::location_t& find_location(const UTAP::template_t& templ, const std::string& name)
+{
+    for (const auto& location : templ.locations)
+        if (location.uid.get_name() == name)
+            return location;
+    FAIL("No location named " << name);
+    throw std::logic_error("unreachable");
+}
+
+TEST_SUITE("Constant evaluation")
+{
+    TEST_CASE("Constants, arrays and arithmetic")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("const int N = 3;\nconst int A[N] = {4, 5, 6};\n"
+                           "int v;\nint x = A[N - 1] * 2 + (N > 2 ? 1 : 0);\nint y = v + 1;");
+        auto doc = df.add_default_process().parse();
+        REQUIRE(doc->get_errors().empty());
+        auto& variables = doc->get_globals().variables;
+        auto evaluator = UTAP::ConstantEvaluator{};
+        auto it = std::next(variables.begin(), 3);
+        CHECK(evaluator.evaluate(it->init) == 13);
+        CHECK_FALSE(evaluator.evaluate(std::next(it)->init));
+    }
+}
+
+TEST_SUITE("Clock bounds")
+{
+    TEST_CASE("Lower and upper bounds")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("clock x, y;\nconst int N = 7;");
+        df.add_template(template_fixture{"T"}
+                            .add_location("A", "x <= 10")
+                            .add_location("B")
+                            .add_location("C")
+                            .add_edge("A", "B", "x >= 3 && y > N", "x = 0")
+                            .add_edge("B", "C", "x < 4")
+                            .str());
+        df.add_system_decl("P = T();");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        auto x = find_symbol(doc->get_globals().frame, "x");
+        auto y = find_symbol(doc->get_globals().frame, "y");
+        const auto& bounds = doc->get_clock_bounds();
+        CHECK(bounds.get_global(x) == clock_bound_t{3, 10});
+        CHECK(bounds.get_global(y) == clock_bound_t{7, clock_bound_t::none});
+        CHECK(bounds.get_global(x).get_max() == 10);
+        CHECK_FALSE(bounds.has_diagonals());
+
+        const auto& templ = find_template(*doc, "T");
+        CHECK(bounds.get_template(templ).at(x) == clock_bound_t{3, 10});
+        // x is reset on the way from A to B, so the bound x < 4 does not reach A
+        CHECK(bounds.get_location(find_location(templ, "A")).at(x) == clock_bound_t{3, 10});
+        CHECK(bounds.get_location(find_location(templ, "B")).at(x) == clock_bound_t{clock_bound_t::none, 4});
+        CHECK(bounds.get_location(find_location(templ, "C")).count(x) == 0);
+    }
+
+    TEST_CASE("Template parameters and clock arrays")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("clock c[2];\nclock z;");
+        df.add_template(template_fixture{"T"}
+                            .add_parameter("const int D")
+                            .add_parameter("clock& w")
+                            .add_location("A", "w <= 2 * D")
+                            .add_location("B")
+                            .add_edge("A", "B", "c[0] > D")
+                            .str());
+        df.add_system_decl("P1 = T(3, z);\nP2 = T(5, z);");
+        df.add_process("P1").add_process("P2");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        const auto& frame = doc->get_globals().frame;
+        const auto& bounds = doc->get_clock_bounds();
+        CHECK(bounds.get_global(find_symbol(frame, "z")) == clock_bound_t{clock_bound_t::none, 10});
+        CHECK(bounds.get_global(find_symbol(frame, "c")) == clock_bound_t{5, clock_bound_t::none});
+    }
+
+    TEST_CASE("Mutable value parameters")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("clock x;");
+        df.add_template(template_fixture{"T"}
+                            .add_parameter("int[0,5] n")
+                            .add_location("A")
+                            .add_edge("A", "A", "x < n && n < 5", "n++")
+                            .str());
+        df.add_system_decl("P = T(2);");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        // n grows, the argument is only its initial value, the range bounds it
+        const auto& process = doc->get_processes().front();
+        CHECK_FALSE(UTAP::ConstantEvaluator{process}.evaluate(process.templ->edges.front().guard[0][1]));
+        const auto& bounds = doc->get_clock_bounds();
+        auto x = find_symbol(doc->get_globals().frame, "x");
+        CHECK(bounds.get_global(x) == clock_bound_t{clock_bound_t::none, 5});
+    }
+
+    TEST_CASE("Non-constant and difference constraints")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("clock x, y;\nint v;");
+        df.add_template(template_fixture{"T"}
+                            .add_location("A")
+                            .add_location("B")
+                            .add_edge("A", "B", "x < v && x - y <= -3")
+                            .str());
+        df.add_system_decl("P = T();");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        const auto& frame = doc->get_globals().frame;
+        const auto& bounds = doc->get_clock_bounds();
+        CHECK(bounds.has_diagonals());
+        CHECK(bounds.get_global(find_symbol(frame, "x")) == clock_bound_t{3, clock_bound_t::infinity});
+        CHECK(bounds.get_global(find_symbol(frame, "y")) == clock_bound_t{3, 3});
+    }
+}
+
+TEST_SUITE("Active clocks")
+{
+    TEST_CASE("Clocks are inactive until read after a reset")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("clock g;");
+        df.add_template(template_fixture{"T"}
+                            .add_declaration("clock x, y, z;\nvoid restart() { x = 0; }")
+                            .add_location("A", "x <= 3")
+                            .add_location("B")
+                            .add_location("C")
+                            .add_location("D")
+                            .add_edge("A", "B", "x >= 2", "y = 0")
+                            .add_edge("B", "C", "y > 5", "z = 0, restart()")
+                            .add_edge("C", "D", "z > g && x < 1")
+                            .str());
+        df.add_system_decl("P = T();");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        const auto& templ = find_template(*doc, "T");
+        auto x = find_symbol(templ.frame, "x");
+        auto y = find_symbol(templ.frame, "y");
+        auto z = find_symbol(templ.frame, "z");
+        auto g = find_symbol(doc->get_globals().frame, "g");
+        const auto& active = doc->get_active_clocks();
+        using clocks_t = UTAP::ActiveClocks::clocks_t;
+        CHECK(active.get_active(find_location(templ, "A")) == clocks_t{x, g});
+        // the reset of x in restart() is only a possible write, thus x stays active
+        CHECK(active.get_active(find_location(templ, "B")) == clocks_t{x, y, g});
+        CHECK(active.get_active(find_location(templ, "C")) == clocks_t{x, z, g});
+        CHECK(active.get_active(find_location(templ, "D")).empty());
+        CHECK(active.get_used(templ) == clocks_t{x, y, z, g});
+        // y and z are never active together
+        const auto& classes = active.get_classes(templ);
+        REQUIRE(classes.size() == 2);
+        CHECK(classes[0] == std::vector<UTAP::symbol_t>{x});
+        CHECK(classes[1] == std::vector<UTAP::symbol_t>{y, z});
+    }
+
+    TEST_CASE("Clocks active within an update interfere")
+    {
+        auto df = document_fixture{};
+        df.add_template(template_fixture{"T"}
+                            .add_declaration("clock u, v, w;")
+                            .add_location("A", "u <= 5")
+                            .add_location("B")
+                            .add_location("C")
+                            .add_edge("A", "B", "", "v = 0, w = u")
+                            .add_edge("B", "C", "v > 1 && w > 1")
+                            .str());
+        df.add_system_decl("P = T();");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        const auto& templ = find_template(*doc, "T");
+        auto u = find_symbol(templ.frame, "u");
+        auto v = find_symbol(templ.frame, "v");
+        auto w = find_symbol(templ.frame, "w");
+        const auto& active = doc->get_active_clocks();
+        using clocks_t = UTAP::ActiveClocks::clocks_t;
+        CHECK(active.get_active(find_location(templ, "A")) == clocks_t{u});
+        CHECK(active.get_active(find_location(templ, "B")) == clocks_t{v, w});
+        // u and v are never active in the same location, but sharing them would reset u before it is copied to w
+        const auto& classes = active.get_classes(templ);
+        REQUIRE(classes.size() == 2);
+        CHECK(classes[0] == std::vector<UTAP::symbol_t>{u, w});
+        CHECK(classes[1] == std::vector<UTAP::symbol_t>{v});
+    }
+}
+
+TEST_SUITE("Value ranges")
+{
+    TEST_CASE("Guards, functions and out of range assignments")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("int[0,100] i;\nint[0,10] b;\nint[-50,50] k = 3;\nint[0,3] m;\n"
+                           "void inc(int& x) { x++; }\n"
+                           "void fill() { int j; for (j = 0; j < 3; j++) m = j; }");
+        df.add_template(template_fixture{"T"}
+                            .add_location("A")
+                            .add_location("B")
+                            .add_edge("A", "A", "i < 5", "i++")
+                            .add_edge("A", "B", "i == 5", "b = i * 4")
+                            .add_edge("A", "A", "k < 10", "inc(k)")
+                            .add_edge("A", "A", "", "fill()")
+                            .str());
+        df.add_system_decl("P = T();");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        const auto& frame = doc->get_globals().frame;
+        const auto& ranges = doc->get_value_ranges();
+        using range_type = UTAP::ValueRanges::range_type;
+        CHECK(ranges.get_range(find_symbol(frame, "i")) == range_type{0, 5});
+        CHECK(ranges.get_range(find_symbol(frame, "k")) == range_type{3, 10});
+        CHECK(ranges.get_range(find_symbol(frame, "m")) == range_type{0, 2});
+        // b = 20 always fails, thus b keeps its initial value
+        CHECK(ranges.get_range(find_symbol(frame, "b")) == range_type{0});
+        const auto& violations = ranges.get_violations();
+        REQUIRE(violations.size() == 1);
+        CHECK(violations[0].value == range_type{20});
+        CHECK(violations[0].declared == range_type{0, 10});
+    }
+}
+
+TEST_SUITE("State layout")
+{
+    TEST_CASE("Fields, offsets and packing")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("int[0,3] a[2];\nbool f;\nint[-5,250] w;\nconst int C = 4;\nclock x;\n"
+                           "typedef struct { int[0,1] p; int[10,10] q; } R;\nR r;");
+        df.add_template(template_fixture{"T"}
+                            .add_declaration("int[0,7] v;\nclock y;")
+                            .add_location("A")
+                            .add_location("B")
+                            .add_location("C")
+                            .add_edge("A", "B")
+                            .str());
+        df.add_system_decl("P1 = T();\nP2 = T();");
+        df.add_process("P1").add_process("P2");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        auto layout = UTAP::StateLayout{*doc};
+        const auto& fields = layout.get_fields();
+        auto names = std::vector<std::string>{};
+        auto widths = std::vector<uint32_t>{};
+        for (const auto& field : fields) {
+            names.push_back(field.name);
+            widths.push_back(field.width);
+        }
+        CHECK(names == std::vector<std::string>{"a[0]", "a[1]", "f", "w", "r.p", "r.q", "P1.location", "P1.v",
+                                                "P2.location", "P2.v"});
+        CHECK(widths == std::vector<uint32_t>{2, 2, 1, 8, 1, 0, 2, 3, 2, 3});
+        auto clocks = std::vector<std::string>{};
+        for (const auto& clock : layout.get_clocks())
+            clocks.push_back(clock.name);
+        CHECK(clocks == std::vector<std::string>{"x", "P1.y", "P2.y"});
+        CHECK(layout.get_packed_words() == 1);
+        CHECK(layout.get_aligned_bytes() == 9);
+        // the widest field comes first
+        CHECK(fields[3].bit_offset == 0);
+        CHECK(fields[3].byte_offset == 0);
+
+        auto values = std::vector<int32_t>{3, 0, 1, -5, 1, 10, 2, 7, 1, 0};
+        auto packed = std::vector<uint64_t>(layout.get_packed_words());
+        auto unpacked = std::vector<int32_t>(fields.size());
+        layout.pack(values.data(), packed.data());
+        layout.unpack(packed.data(), unpacked.data());
+        CHECK(unpacked == values);
+        layout.set(packed.data(), 3, 250);
+        CHECK(layout.get(packed.data(), 3) == 250);
+        CHECK(layout.get(packed.data(), 2) == 1);
+
+        auto aligned = std::vector<uint8_t>(layout.get_aligned_bytes());
+        layout.pack_aligned(values.data(), aligned.data());
+        layout.unpack_aligned(aligned.data(), unpacked.data());
+        CHECK(unpacked == values);
+    }
+
+    TEST_CASE("Mutable parameters and doubles")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("int g;");
+        df.add_template(template_fixture{"T"}
+                            .add_parameter("int[0,3] n")
+                            .add_parameter("const int k")
+                            .add_parameter("int& r")
+                            .add_location("A")
+                            .add_edge("A", "A", "n < k", "n++")
+                            .str());
+        df.add_system_decl("P = T(0, 3, g);");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        auto layout = UTAP::StateLayout{*doc};
+        auto names = std::vector<std::string>{};
+        for (const auto& field : layout.get_fields())
+            names.push_back(field.name);
+        CHECK(names == std::vector<std::string>{"g", "P.location", "P.n"});
+
+        auto with_double = document_fixture{};
+        with_double.add_global_decl("double d;");
+        auto rejected = with_double.add_default_process().parse();
+        REQUIRE(rejected->get_errors().empty());
+        CHECK_THROWS_AS(UTAP::StateLayout{*rejected}, std::logic_error);
+    }
+}
+
+TEST_SUITE("Edge index")
+{
+    TEST_CASE("Outgoing edges and channels")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("chan c;\nchan d[3];\nint v;");
+        df.add_template(template_fixture{"T"}
+                            .add_location("A")
+                            .add_location("B")
+                            .add_location("C")
+                            .add_edge("A", "B", "", "", "c!")
+                            .add_edge("A", "C", "", "", "d[1]?")
+                            .add_edge("B", "A", "", "", "d[v]?")
+                            .add_edge("A", "A")
+                            .str());
+        df.add_system_decl("P = T();");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        const auto& frame = doc->get_globals().frame;
+        const auto& templ = find_template(*doc, "T");
+        const auto& index = doc->get_edge_index().get(templ);
+        auto nrs = [](UTAP::edge_view_t edges) {
+            auto res = std::vector<int>{};
+            for (const auto* edge : edges)
+                res.push_back(edge->nr);
+            return res;
+        };
+        CHECK(nrs(index.get_outgoing(find_location(templ, "A"))) == std::vector<int>{0, 1, 3});
+        CHECK(nrs(index.get_outgoing(find_location(templ, "B"))) == std::vector<int>{2});
+        CHECK(index.get_outgoing(find_location(templ, "C")).empty());
+        auto c = find_symbol(frame, "c");
+        auto d = find_symbol(frame, "d");
+        CHECK(nrs(index.get_senders(c)) == std::vector<int>{0});
+        CHECK(index.get_receivers(c).empty());
+        // d[v] may be any element
+        CHECK(nrs(index.get_receivers(d, 0)) == std::vector<int>{2});
+        CHECK(nrs(index.get_receivers(d, 1)) == std::vector<int>{1, 2});
+        CHECK(nrs(index.get_receivers(d, 2)) == std::vector<int>{2});
+        CHECK(index.get_senders(d, 1).empty());
+        CHECK(nrs(index.get_unsynchronised()) == std::vector<int>{3});
+    }
+}
+
+TEST_SUITE("Guard normal form")
+{
+    TEST_CASE("Data predicates, clock constraints and residuals")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("const int N = 3;\nclock x, y;\nclock z[2];\nint v;");
+        df.add_template(template_fixture{"T"}
+                            .add_location("A", "x <= N")
+                            .add_location("B")
+                            .add_edge("A", "B", "x > 2 && v == 1 && true && x - y < N + 1")
+                            .add_edge("A", "B", "N >= z[1] && z[v] == 2")
+                            .add_edge("B", "A", "v > 0 && (x < 1 || y > 2)")
+                            .add_edge("B", "A", "v > 0 && N < 2")
+                            .str());
+        df.add_system_decl("P = T();");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        const auto& frame = doc->get_globals().frame;
+        auto x = find_symbol(frame, "x");
+        auto y = find_symbol(frame, "y");
+        auto z = find_symbol(frame, "z");
+        const auto& templ = find_template(*doc, "T");
+        const auto& forms = doc->get_guard_forms();
+        auto edge = templ.edges.begin();
+
+        const auto& invariant = forms.get_invariant(find_location(templ, "A"));
+        REQUIRE(invariant.clocks.size() == 1);
+        CHECK(invariant.clocks[0].first.clock == x);
+        CHECK(invariant.clocks[0].second.is_reference());
+        CHECK(invariant.clocks[0].bound.get_value() == 3);
+        CHECK(!invariant.clocks[0].strict);
+        CHECK(invariant.data.empty());
+
+        // x > 2 becomes 0 - x < -2
+        const auto& first = forms.get_guard(*edge++);
+        CHECK(first.data.str() == "v == 1");
+        REQUIRE(first.clocks.size() == 2);
+        CHECK(first.clocks[0].first.is_reference());
+        CHECK(first.clocks[0].second.clock == x);
+        CHECK(first.clocks[0].bound.get_value() == -2);
+        CHECK(first.clocks[0].strict);
+        CHECK(first.clocks[1].first.clock == x);
+        CHECK(first.clocks[1].second.clock == y);
+        CHECK(first.clocks[1].bound.get_value() == 4);
+        CHECK(first.is_simple());
+        CHECK(!first.unsatisfiable);
+
+        // equality gives both bounds, z[v] is not resolved
+        const auto& second = forms.get_guard(*edge++);
+        REQUIRE(second.clocks.size() == 3);
+        CHECK(second.clocks[0].first.clock == z);
+        CHECK(second.clocks[0].first.element == 1);
+        CHECK(second.clocks[0].bound.get_value() == 3);
+        CHECK(second.clocks[1].first.element == UTAP::clock_term_t::any_element);
+        CHECK(second.clocks[1].bound.get_value() == 2);
+        CHECK(second.clocks[2].second.element == UTAP::clock_term_t::any_element);
+        CHECK(second.clocks[2].bound.get_value() == -2);
+
+        const auto& third = forms.get_guard(*edge++);
+        CHECK(third.data.str() == "v > 0");
+        CHECK(third.clocks.empty());
+        CHECK(!third.is_simple());
+
+        CHECK(forms.get_guard(*edge++).unsatisfiable);
+    }
+}
+
+TEST_SUITE("Symmetry")
+{
+    TEST_CASE("Scalarsets and canonical states")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("typedef scalar[3] id_t;\nint[0,3] a[id_t];\nid_t owner;\nint[0,1] b;");
+        df.add_template(template_fixture{"T"}
+                            .add_parameter("const id_t id")
+                            .add_declaration("int[0,2] v;\nclock y;")
+                            .add_location("A")
+                            .add_location("B")
+                            .add_edge("A", "B", "", "a[id] = 1, owner = id")
+                            .str());
+        df.add_process("T");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        const auto& frame = doc->get_globals().frame;
+        const auto& symmetry = doc->get_symmetry();
+        REQUIRE(symmetry.get_scalarsets().size() == 1);
+        const auto& ids = symmetry.get_scalarsets().front();
+        CHECK(ids.name == "id_t");
+        CHECK(ids.size == 3);
+        CHECK(ids.processes.size() == 1);
+        CHECK(ids.arrays == std::vector<UTAP::symbol_t>{find_symbol(frame, "a")});
+        CHECK(ids.values == std::vector<UTAP::symbol_t>{find_symbol(frame, "owner")});
+
+        // the process set is expanded into one process per element
+        auto layout = UTAP::StateLayout{*doc};
+        auto names = std::vector<std::string>{};
+        for (const auto& field : layout.get_fields())
+            names.push_back(field.name);
+        CHECK(names == std::vector<std::string>{"a[0]", "a[1]", "a[2]", "owner", "b", "T(0).location", "T(0).v",
+                                                "T(1).location", "T(1).v", "T(2).location", "T(2).v"});
+
+        auto canonicaliser = UTAP::Canonicaliser{symmetry, layout};
+        auto canonical = [&](std::vector<int32_t> values, std::vector<uint32_t>* clocks = nullptr) {
+            auto packed = std::vector<uint64_t>(layout.get_packed_words());
+            layout.pack(values.data(), packed.data());
+            canonicaliser.canonicalise(packed.data(), clocks);
+            layout.unpack(packed.data(), values.data());
+            return values;
+        };
+        auto clocks = std::vector<uint32_t>{};
+        auto expected = std::vector<int32_t>{1, 2, 3, 2, 1, 0, 2, 0, 1, 1, 0};
+        CHECK(canonical({3, 1, 2, 0, 1, 1, 0, 0, 2, 0, 1}, &clocks) == expected);
+        CHECK(clocks == std::vector<uint32_t>{0, 2, 3, 1});
+        // elements 0 and 2 swapped
+        CHECK(canonical({2, 1, 3, 2, 1, 0, 1, 0, 2, 1, 0}) == expected);
+        CHECK(canonical(expected) == expected);
+    }
+}
+
+TEST_SUITE("Slicing")
+{
+    TEST_CASE("Cone of influence of queries")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("int a, b, c;\nchan go;\nurgent chan hurry;\nclock x;");
+        df.add_template(template_fixture{"T"}
+                            .add_declaration("int[0,3] n;")
+                            .add_location("A")
+                            .add_location("B")
+                            .add_edge("A", "B", "a > 0", "n = n + 1, c = 1")
+                            .add_edge("B", "A", "", "", "go?")
+                            .str());
+        df.add_template(
+            template_fixture{"U"}.add_location("A").add_location("B").add_edge("A", "B", "", "a = b", "go!").str());
+        df.add_template(
+            template_fixture{"V"}.add_location("A", "x <= 2").add_location("B").add_edge("A", "B", "", "c = 2").str());
+        df.add_template(
+            template_fixture{"W"}.add_location("A").add_location("B").add_edge("A", "B", "", "", "hurry!").str());
+        df.add_system_decl("P1 = T();\nP2 = T();\nQ = U();\nR = V();\nS = W();");
+        df.add_process("P1").add_process("P2").add_process("Q").add_process("R").add_process("S");
+        auto fixture = df.build_query_fixture();
+        auto& doc = fixture.get_document();
+        const auto& frame = doc.get_globals().frame;
+        auto processes = std::vector<const UTAP::instance_t*>{};
+        for (const auto& process : doc.get_processes())
+            processes.push_back(&process);
+        REQUIRE(processes.size() == 5);
+        auto relevant = [&processes](const UTAP::Slice& slice) {
+            auto res = std::vector<bool>{};
+            for (const auto* process : processes)
+                res.push_back(slice.is_relevant(*process));
+            return res;
+        };
+        const auto& templ = find_template(doc, "T");
+        auto n = find_symbol(templ.frame, "n");
+
+        // P2 competes for the synchronisation on go, Q writes a
+        auto slice = UTAP::Slice{doc, fixture.parse_query("E<> P1.n > 2").intermediate};
+        CHECK(relevant(slice) == std::vector<bool>{true, true, true, false, false});
+        CHECK(slice.is_relevant(processes[0], n));
+        CHECK(!slice.is_relevant(processes[1], n));
+        CHECK(slice.is_relevant(nullptr, find_symbol(frame, "a")));
+        CHECK(slice.is_relevant(nullptr, find_symbol(frame, "b")));
+        CHECK(slice.is_relevant(nullptr, find_symbol(frame, "go")));
+        CHECK(!slice.is_relevant(nullptr, find_symbol(frame, "c")));
+        CHECK(!slice.is_relevant(nullptr, find_symbol(frame, "x")));
+        const auto& assign = templ.edges.front().assign;
+        CHECK(slice.is_relevant_update(*processes[0], assign[0]));
+        CHECK(!slice.is_relevant_update(*processes[0], assign[1]));
+
+        // S may prevent delays by its urgent synchronisation
+        slice = UTAP::Slice{doc, fixture.parse_query("E<> R.B").intermediate};
+        CHECK(relevant(slice) == std::vector<bool>{false, false, false, true, true});
+        CHECK(slice.is_relevant(nullptr, find_symbol(frame, "x")));
+        CHECK(slice.is_relevant(nullptr, find_symbol(frame, "hurry")));
+        CHECK(!slice.is_relevant(nullptr, find_symbol(frame, "c")));
+
+        // liveness properties are not sliced
+        slice = UTAP::Slice{doc, fixture.parse_query("A<> P1.n > 2").intermediate};
+        CHECK(slice.is_complete());
+        CHECK(relevant(slice) == std::vector<bool>{true, true, true, true, true});
+        CHECK(slice.is_relevant(nullptr, find_symbol(frame, "c")));
+        CHECK(slice.is_relevant_update(*processes[0], assign[1]));
+        slice = UTAP::Slice{doc, fixture.parse_query("P1.B --> R.B").intermediate};
+        CHECK(slice.is_complete());
+    }
+
+    TEST_CASE("Systems with priorities are not sliced")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("int a, b;\nchan go;\nchan priority go < default;");
+        df.add_template(
+            template_fixture{"T"}.add_location("A").add_location("B").add_edge("A", "B", "", "a = 1").str());
+        df.add_template(
+            template_fixture{"U"}.add_location("A").add_location("B").add_edge("A", "B", "", "b = 1", "go!").str());
+        df.add_system_decl("P = T();\nQ = U();");
+        df.add_process("P").add_process("Q");
+        auto fixture = df.build_query_fixture();
+        auto& doc = fixture.get_document();
+        REQUIRE(doc.has_priority_declaration());
+        auto slice = UTAP::Slice{doc, fixture.parse_query("E<> P.B").intermediate};
+        CHECK(slice.is_complete());
+        for (const auto& process : doc.get_processes())
+            CHECK(slice.is_relevant(process));
+        CHECK(slice.is_relevant(nullptr, find_symbol(doc.get_globals().frame, "b")));
+    }
+}
+
+TEST_SUITE("Simplification")
+{
+    TEST_CASE("Constant guards and unreachable locations")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("const int MODE = 2;\nint x;");
+        df.add_template(template_fixture{"T"}
+                            .add_location("A", "MODE > 1")
+                            .add_location("B")
+                            .add_location("C")
+                            .add_location("D")
+                            .add_edge("A", "B", "MODE == 2 && x > 3", "x = MODE + 1")
+                            .add_edge("A", "C", "MODE == 1")
+                            .add_edge("C", "D")
+                            .add_edge("B", "A", "MODE == 2")
+                            .str());
+        df.add_system_decl("P = T();");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        auto changes = UTAP::simplify(*doc);
+        const auto& templ = find_template(*doc, "T");
+        CHECK(find_location(templ, "A").invariant.empty());
+        REQUIRE(templ.edges.size() == 2);
+        const auto& first = templ.edges.front();
+        CHECK(first.nr == 0);
+        CHECK(first.dst == &find_location(templ, "B"));
+        CHECK(first.guard.str() == "x > 3");
+        CHECK(first.assign.str() == "x = 3");
+        CHECK(templ.edges.back().nr == 1);
+        CHECK(templ.edges.back().guard.empty());
+
+        auto originals = [&changes](UTAP::simplification_kind_t kind) {
+            auto res = std::vector<std::string>{};
+            for (const auto& change : changes)
+                if (change.kind == kind)
+                    res.push_back(change.original);
+            return res;
+        };
+        CHECK(originals(UTAP::simplification_kind_t::RemovedEdge) == std::vector<std::string>{"MODE == 1"});
+        CHECK(originals(UTAP::simplification_kind_t::UnreachableLocation) == std::vector<std::string>{"C", "D"});
+        CHECK(originals(UTAP::simplification_kind_t::Folded).size() == 5);
+    }
+
+    TEST_CASE("Neutral constants keep the truth value of integers")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("const int MODE = 2;\nint x;\nbool b;");
+        df.add_template(template_fixture{"T"}
+                            .add_location("A")
+                            .add_location("B")
+                            .add_edge("A", "B", "MODE == 2 && x")
+                            .add_edge("B", "A", "MODE == 1 || b")
+                            .str());
+        df.add_system_decl("P = T();");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        UTAP::simplify(*doc);
+        const auto& templ = find_template(*doc, "T");
+        REQUIRE(templ.edges.size() == 2);
+        CHECK(templ.edges.front().guard.str() == "x != 0");
+        CHECK(templ.edges.front().guard.get_type().is(UTAP::Constants::BOOL));
+        CHECK(templ.edges.back().guard.str() == "b");
+    }
+}
+
+TEST_SUITE("Specialisation")
+{
+    TEST_CASE("Residual templates of parameterised processes")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("typedef int[0,2] id_t;\nint a[3];\nint x, y;");
+        df.add_template(template_fixture{"Worker"}
+                            .add_parameter("const id_t id")
+                            .add_parameter("int& v")
+                            .add_location("A")
+                            .add_location("B")
+                            .add_edge("A", "B", "id == 0 && a[id] > 3")
+                            .add_edge("B", "A", "", "v = a[id] + 1")
+                            .str());
+        df.add_system_decl("P0 = Worker(0, x);\nP1 = Worker(1, y);\nP2 = Worker(1, y);");
+        df.add_process("P0").add_process("P1").add_process("P2");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        auto processes = std::vector<const UTAP::instance_t*>{};
+        for (const auto& process : doc->get_processes())
+            processes.push_back(&process);
+        REQUIRE(processes.size() == 3);
+
+        auto specialiser = UTAP::Specialiser{*doc};
+        CHECK(specialiser.get_templates().size() == 2);
+        const auto& first = specialiser.get(*processes[0]);
+        REQUIRE(first.edges.size() == 2);
+        CHECK(first.edges[0].guard.str() == "a[0] > 3");
+        CHECK(first.edges[1].assign.str() == "x = a[0] + 1");
+        const auto& second = specialiser.get(*processes[1]);
+        CHECK(&second == &specialiser.get(*processes[2]));
+        REQUIRE(second.edges.size() == 1);
+        CHECK(second.edges[0].edge->nr == 1);
+        CHECK(second.edges[0].assign.str() == "y = a[1] + 1");
+
+        auto limited = UTAP::Specialiser{*doc, {1, 100}};
+        CHECK(!limited.get(*processes[0]).generic);
+        const auto& generic = limited.get(*processes[1]);
+        CHECK(generic.generic);
+        CHECK(generic.edges.size() == 2);
+        CHECK(generic.edges[1].assign.str() == "v = a[id] + 1");
+    }
+}
+
+TEST_SUITE("Common subexpressions")
+{
+    TEST_CASE("Shared guards and updates")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("int a[3];\nint i, x;");
+        df.add_template(template_fixture{"T"}
+                            .add_location("A")
+                            .add_location("B")
+                            .add_edge("A", "B", "a[i] > 5", "x = a[i] + 1")
+                            .add_edge("B", "A", "a[i] > 5 && x < 2", "i = a[i] + 1")
+                            .str());
+        df.add_system_decl("P = T();");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        auto& templ = doc->get_templates().front();
+        auto common = UTAP::eliminate_common_subexpressions(templ, doc->get_expression_table());
+        auto texts = std::vector<std::string>{};
+        for (const auto& expr : common)
+            texts.push_back(expr.str());
+        // a[i] + 1 in the second update reads i, which the update writes
+        CHECK(texts == std::vector<std::string>{"a[i] > 5", "a[i]"});
+        const auto& first = templ.edges.front();
+        const auto& second = templ.edges.back();
+        CHECK(first.guard == second.guard[0]);
+        CHECK(first.assign[1] == second.assign[1]);
+    }
+}
+
+TEST_SUITE("Select expansion")
+{
+    TEST_CASE("Edge instances and binding tables")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("int a[3];\nchan c[3];");
+        df.add_template(template_fixture{"T"}
+                            .add_location("A")
+                            .add_location("B")
+                            .add_edge("A", "B", "a[i] > 0 && i != 1", "a[i] = 0", "c[i]!", "i : int[0,2]")
+                            .add_edge("B", "A", "", "", "", "j : int[0,2], k : int[0,2]")
+                            .add_edge("B", "B")
+                            .str());
+        df.add_system_decl("P = T();");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        const auto& templ = find_template(*doc, "T");
+        REQUIRE(templ.edges.size() == 3);
+        const auto& first = templ.edges[0];
+        const auto& second = templ.edges[1];
+        auto expansion = UTAP::SelectExpansion{templ, UTAP::ConstantEvaluator{}, 4};
+
+        REQUIRE(expansion.is_expanded(first));
+        const auto& instances = expansion.get_instances(first);
+        REQUIRE(instances.size() == 2);
+        CHECK(instances[0].values == std::vector<int32_t>{0});
+        CHECK(instances[0].guard.str() == "a[0] > 0");
+        CHECK(instances[0].sync.str() == "c[0]!");
+        CHECK(instances[1].values == std::vector<int32_t>{2});
+        CHECK(instances[1].assign.str() == "a[2] = 0");
+
+        CHECK(!expansion.is_expanded(second));
+        const auto& bindings = expansion.get_bindings(second);
+        REQUIRE(bindings.size() == 9);
+        int32_t values[2];
+        bindings.get(5, values);
+        CHECK(values[0] == 1);
+        CHECK(values[1] == 2);
+
+        REQUIRE(expansion.is_expanded(templ.edges[2]));
+        CHECK(expansion.get_instances(templ.edges[2]).size() == 1);
+        CHECK(expansion.get_bindings(templ.edges[2]).size() == 1);
+    }
+
+    TEST_CASE("Binding counts saturate")
+    {
+        auto df = document_fixture{};
+        df.add_template(template_fixture{"T"}
+                            .add_location("A")
+                            .add_edge("A", "A", "", "", "",
+                                      "i : int[-32768,32767], j : int[-32768,32767], k : int[-32768,32767], "
+                                      "l : int[-32768,32767]")
+                            .str());
+        df.add_system_decl("P = T();");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        const auto& templ = find_template(*doc, "T");
+        // 2^64 bindings would wrap around to 0
+        auto expansion = UTAP::SelectExpansion{templ, UTAP::ConstantEvaluator{}, UTAP::select_bindings_t::unbounded};
+        CHECK(!expansion.is_expanded(templ.edges.front()));
+        CHECK(expansion.get_bindings(templ.edges.front()).size() == UTAP::select_bindings_t::unbounded);
+        CHECK(UTAP::select_bindings_t{{{0, 2}, {1, 0}, {INT32_MIN, INT32_MAX}, {INT32_MIN, INT32_MAX}}}.size() == 0);
+    }
+}
+
+TEST_SUITE("Code generation")
+{
+    TEST_CASE("Guards, updates and unsupported functions")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("int[0,10] x;\nint b[2];\nclock c;\nint sum(int v[2]) { return v[0] + v[1]; }");
+        df.add_template(template_fixture{"T"}
+                            .add_parameter("const int id")
+                            .add_location("A")
+                            .add_location("B")
+                            .add_edge("A", "B", "x < id + 2 && c >= 1", "x = x + id, c = 0")
+                            .add_edge("B", "A", "sum(b) > id")
+                            .str());
+        df.add_system_decl("P1 = T(1);\nP2 = T(2);");
+        df.add_process("P1").add_process("P2");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        auto layout = UTAP::StateLayout{*doc};
+        auto generator = UTAP::CodeGenerator{*doc, layout};
+        const auto& source = generator.get_source();
+        // x is field 0, c is clock 1 after the reference clock
+        CHECK(source.find("return ((s[0] < 3) && (c[1 + 0] >= 1));") != std::string::npos);
+        CHECK(source.find("return ((s[0] < 4) && (c[1 + 0] >= 1));") != std::string::npos);
+        CHECK(source.find("(s[0] = (s[0] + 2))") != std::string::npos);
+        CHECK(source.find("extern \"C\" const uint32_t utap_process_count = 2;") != std::string::npos);
+        CHECK(source.find("extern \"C\" const uint32_t utap_edges[] = {0, 2, 4, 0};") != std::string::npos);
+        // the function with an array parameter is generated once, the guards calling it are left out
+        CHECK(generator.get_unsupported() ==
+              std::vector<std::string>{"sum: Parameter v", "P1.edge1.guard: Function sum",
+                                       "P2.edge1.guard: Function sum"});
+    }
+
+    TEST_CASE("Native code agrees with the interpreter")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("int[0,10] x;\nint[0,3] b[2];\nclock c;\nint twice(int v) { return 2 * v; }");
+        df.add_template(template_fixture{"T"}
+                            .add_parameter("const int id")
+                            .add_parameter("int[0,5] n")
+                            .add_location("A", "c <= 5")
+                            .add_location("B")
+                            .add_edge("A", "B", "x < id + 5 && c >= 1",
+                                      "x = x + id, b[id - 1] = twice(b[0]) % 4, c = 0")
+                            .add_edge("B", "A", "b[id - 1] < 3 || x > 8", "b[0] = (b[0] + 1) % 4, x = x % 7")
+                            .add_edge("A", "A", "n < 5", "n++")
+                            .str());
+        df.add_system_decl("P1 = T(1, 0);\nP2 = T(2, 3);");
+        df.add_process("P1").add_process("P2");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        auto layout = UTAP::StateLayout{*doc};
+        auto generator = UTAP::CodeGenerator{*doc, layout};
+        // n is a variable of the process, not its argument
+        CHECK(generator.get_unsupported().empty());
+        const auto module =
+            UTAP::NativeModule{generator.get_source(), std::filesystem::temp_directory_path() / "utap_test_codegen"};
+        auto interpreter = reference::Interpreter{layout};
+        const auto elements = reference::elements(*doc, interpreter);
+        REQUIRE(module.get_process_count() == elements.size());
+
+        // a random walk of the processes on their own, comparing every guard, invariant and update met
+        auto rng = std::mt19937{42};
+        auto state = std::vector<int32_t>(layout.get_fields().size());
+        auto clocks = std::vector<double>(layout.get_clocks().size() + 1);
+        auto compared = 0;
+        auto compare = [&](const reference::element_t& element, const UTAP::expression_t& expr,
+                           UTAP::native_guard_t guard) {
+            auto copy = state;
+            auto native = guard(state.data(), clocks.data()) != 0;
+            CHECK(native == (interpreter.value(expr, &element, copy.data(), clocks.data()) != 0));
+            ++compared;
+            return native;
+        };
+        for (auto step = 0; step < 200; ++step) {
+            auto p = std::uniform_int_distribution<size_t>{0, elements.size() - 1}(rng);
+            const auto& element = elements[p];
+            const auto& templ = *element.bound.templ;
+            clocks[1] += std::uniform_real_distribution<double>{0, 2}(rng);
+            auto location = state[element.location];
+            for (const auto& loc : templ.locations)
+                if (auto invariant = module.get_invariant(p, loc.nr); loc.nr == location && invariant != nullptr)
+                    compare(element, loc.invariant, invariant);
+            auto enabled = std::vector<size_t>{};
+            for (size_t e = 0; e < templ.edges.size(); ++e) {
+                const auto& edge = templ.edges[e];
+                if (auto guard = module.get_guard(p, e); edge.src->nr == location && guard != nullptr)
+                    if (compare(element, edge.guard, guard) && module.get_update(p, e) != nullptr)
+                        enabled.push_back(e);
+            }
+            if (enabled.empty())
+                continue;
+            auto chosen = enabled[std::uniform_int_distribution<size_t>{0, enabled.size() - 1}(rng)];
+            auto reference = state;
+            auto reference_clocks = clocks;
+            interpreter.value(templ.edges[chosen].assign, &element, reference.data(), reference_clocks.data());
+            module.get_update(p, chosen)(state.data(), clocks.data());
+            CHECK(state == reference);
+            CHECK(clocks == reference_clocks);
+            state[element.location] = templ.edges[chosen].dst->nr;
+        }
+        CHECK(compared > 200);
+    }
+}
+
+TEST_SUITE("Cost model")
+{
+    TEST_CASE("Loop bounds and operation counts")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("int a[4];\n"
+                           "int total() { int s = 0; for (i : int[0,3]) { s = s + a[i]; } return s; }\n"
+                           "void fill(int n) { int i; for (i = 0; i < 4; i++) a[i] = n; }\n"
+                           "void spin() { while (a[0] > 0) { a[0]--; } }");
+        df.add_template(template_fixture{"T"}
+                            .add_location("A")
+                            .add_edge("A", "A", "total() > 2", "fill(1)")
+                            .add_edge("A", "A", "", "spin()")
+                            .str());
+        df.add_system_decl("P = T();");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        const auto& costs = doc->get_cost_model();
+        const auto& functions = doc->get_globals().functions;
+        REQUIRE(functions.size() == 3);
+        auto fun = functions.begin();
+        // four iterations of s = s + a[i], three operations each
+        CHECK(costs.get_cost(*fun++) == 12);
+        // i = 0 and i < 4, then four times a[i] = n, i++ and i < 4
+        CHECK(costs.get_cost(*fun++) == 18);
+        CHECK(costs.get_cost(*fun) == UTAP::CostModel::unbounded);
+
+        const auto& loops = costs.get_loops();
+        REQUIRE(loops.size() == 3);
+        CHECK(loops[0].trips == 4u);
+        CHECK(loops[1].trips == 4u);
+        CHECK(!loops[2].trips);
+
+        const auto& templ = find_template(*doc, "T");
+        const auto& first = templ.edges.front();
+        CHECK(costs.get_guard_cost(first) == 14);
+        CHECK(costs.get_update_cost(first) == 19);
+        CHECK(costs.get_update_cost(templ.edges.back()) == UTAP::CostModel::unbounded);
+        CHECK(costs.get_invariant_cost(find_location(templ, "A")) == 0);
+    }
+}
+
+TEST_SUITE("Priority tables")
+{
+    TEST_CASE("Channel elements, default and process priorities")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("chan a, b[2][3];\nbroadcast chan c;\nchan priority a, b[0][1] < default < b[1] < c;");
+        df.add_template(template_fixture{"T"}.add_location("A").str());
+        df.add_system_decl("P = T();\nQ = T();\nR = T();");
+        df.add_process("P < Q").add_process("R");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        const auto& table = doc->get_priority_table();
+        CHECK(table.has_priorities());
+        // a, b[0][0] ... b[1][2], c and tau
+        CHECK(table.get_tau() == 8);
+        CHECK(table.get_channel_priorities() == std::vector<uint32_t>{0, 1, 0, 1, 2, 2, 2, 3, 1});
+        const auto& globals = doc->get_globals().frame;
+        CHECK(table.get_channel(find_symbol(globals, "b"), 5) == 6u);
+        CHECK(!table.get_channel(find_symbol(globals, "b"), 6));
+        CHECK(table.get_process_priorities() == std::vector<uint32_t>{0, 1, 1});
+        uint32_t enabled[] = {0, 1, table.get_tau()};
+        CHECK(table.max_channel_priority(enabled, 3) == 1);
+        size_t processes[] = {0, 2};
+        CHECK(table.max_process_priority(processes, 2) == 1);
+    }
+
+    TEST_CASE("Channel indices out of range")
+    {
+        for (const auto* priority : {"chan priority c[3];", "chan priority c[-1];"}) {
+            CAPTURE(priority);
+            auto df = document_fixture{};
+            df.add_global_decl(std::string{"chan c[3];\n"} + priority);
+            auto doc = df.add_default_process().parse();
+            CHECK_THROWS_AS(doc->get_priority_table(), std::logic_error);
+        }
+    }
+}
+
+TEST_SUITE("Inlining")
+{
+    TEST_CASE("Pure functions, nested and recursive calls")
+    {
+        auto df = document_fixture{};
+        df.add_global_decl("int q[3];\n"
+                           "bool can_send(int i) { return q[i] < 3; }\n"
+                           "int clamp(int v) { if (v > 2) return 2; return v; }\n"
+                           "int next(int i) { return clamp(i + 1); }\n"
+                           "int fact(int n) { return n <= 1 ? 1 : n * fact(n - 1); }\n"
+                           "void push(int i) { q[i]++; }");
+        df.add_template(template_fixture{"T"}
+                            .add_location("A")
+                            .add_edge("A", "A", "can_send(1)", "q[0] = next(q[1])")
+                            .add_edge("A", "A", "fact(q[0]) > 1", "push(2)")
+                            .str());
+        df.add_system_decl("P = T();");
+        df.add_process("P");
+        auto doc = df.parse();
+        REQUIRE(doc->get_errors().empty());
+        const auto& templ = find_template(*doc, "T");
+        const auto& first = templ.edges.front();
+        CHECK(UTAP::inline_calls(first.guard, {4}).str() == "can_send(1)");
+        auto calls = UTAP::inline_functions(*doc);
+        CHECK(first.guard.str() == "q[1] < 3");
+        CHECK(first.assign.str() == "q[0] = q[1] + 1 > 2 ? 2 : q[1] + 1");
+        // the inlined body is placed at the call
+        CHECK(first.guard.get_position().start == calls.front().position.start);
+        CHECK(first.guard.get_position().end == calls.front().position.end);
+        CHECK(templ.edges.back().guard.str() == "fact(q[0]) > 1");
+        CHECK(templ.edges.back().assign.str() == "push(2)");
+        auto functions = std::vector<std::string>{};
+        for (const auto& call : calls)
+            functions.push_back(call.function);
+        CHECK(functions == std::vector<std::string>{"can_send", "clamp", "next"});
+    }
+}
@@ -20,6 +20,7 @@
 */
 
 #include "utap/expression.h"
+#include "utap/hashcons.h"
 
 #include <doctest/doctest.h>
 
@@ -199,3 +200,32 @@ TEST_CASE("Expression to string conversion")
         CHECK(p.str() == "(2 * 3) ** (5 * 7)");
     }
 }
+
+TEST_CASE("Structural hash and hash-consing")
+{
+    using exp_t = UTAP::expression_t;
+    using namespace UTAP::Constants;
+    const auto int_type = UTAP::type_t::create_primitive(INT);
+    auto sum = [&int_type](int a, int b) {
+        return exp_t::create_binary(PLUS, exp_t::create_constant(a), exp_t::create_constant(b), {}, int_type);
+    };
+    auto a = sum(2, 3);
+    auto b = sum(2, 3);
+    REQUIRE(!(a == b));
+    CHECK(a.hash() == b.hash());
+    CHECK(a.hash() != sum(3, 2).hash());
+    auto c = a.clone();
+    c[1] = exp_t::create_constant(4);
+    CHECK(c.hash() == sum(2, 4).hash());
+    CHECK(a.hash() == b.hash());
+
+    auto table = UTAP::ExpressionTable{};
+    auto product = exp_t::create_binary(MULT, a, b, {}, int_type);
+    auto shared = table.intern(product);
+    CHECK(shared.equal(product));
+    CHECK(shared[0] == shared[1]);
+    CHECK(table.intern(b) == shared[0]);
+    CHECK(table.intern(sum(2, 3)) == shared[0]);
+    // constants 2 and 3, the sum and the product
+    CHECK(table.size() == 4);
+}
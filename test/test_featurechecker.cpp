@@ -26,8 +26,11 @@
 
 #include <doctest/doctest.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <string>
+#include <vector>
 
 TEST_CASE("Simple system")
 {
@@ -184,4 +187,57 @@ TEST_CASE("Channel priorities disable concrete simulator and smc")
     CHECK(checker.get_supported_methods().symbolic);
     CHECK(!checker.get_supported_methods().stochastic);
     CHECK(!checker.get_supported_methods().concrete);
-}
\ No newline at end of file
+}
+TEST_CASE("Pipeline reports the same features as a separate traversal")
+{
+    for (const auto* model : {"simpleSystem.xml", "simpleSMCSystem.xml", "simpleHandshakeSystem.xml", "dynamic.xml",
+                              "clock_rate2.xml", "rate_expression.xml", "channel_priorities.xml"}) {
+        CAPTURE(model);
+        auto doc = std::make_unique<UTAP::Document>();
+        parse_XML_buffer(read_content(model).c_str(), doc.get(), true);
+        auto checker = UTAP::FeatureChecker{*doc};
+        const auto& fused = doc->get_supported_methods();
+        CHECK(fused.symbolic == checker.get_supported_methods().symbolic);
+        CHECK(fused.stochastic == checker.get_supported_methods().stochastic);
+        CHECK(fused.concrete == checker.get_supported_methods().concrete);
+    }
+}
+
+struct trace_visitor : UTAP::DocumentVisitor
+{
+    std::string name;
+    std::vector<std::string>& trace;
+    bool accept_templates{true};
+    trace_visitor(std::string name, std::vector<std::string>& trace): name{std::move(name)}, trace{trace} {}
+    void visitDocBefore(UTAP::Document&) override { trace.push_back(name + ":begin"); }
+    void visitDocAfter(UTAP::Document&) override { trace.push_back(name + ":end"); }
+    bool visitTemplateBefore(UTAP::template_t&) override { return accept_templates; }
+    void visitLocation(UTAP::location_t&) override { trace.push_back(name + ":location"); }
+};
+
+TEST_CASE("Pipeline runs independent visitors in a single traversal")
+{
+    auto doc = std::make_unique<UTAP::Document>();
+    parse_XML_buffer(read_content("simpleSystem.xml").c_str(), doc.get(), true);
+    auto trace = std::vector<std::string>{};
+    auto a = trace_visitor{"a", trace};
+    auto b = trace_visitor{"b", trace};
+    auto c = trace_visitor{"c", trace};
+    b.accept_templates = false;
+    auto pipeline = UTAP::DocumentVisitorPipeline{};
+    pipeline.add(a).add(b).add(c, {&a});
+    REQUIRE(pipeline.get_stage_count() == 2);
+    pipeline.run(*doc);
+    REQUIRE(trace.size() >= 8);
+    // first stage: a and b are interleaved element by element
+    CHECK(trace[0] == "a:begin");
+    CHECK(trace[1] == "b:begin");
+    CHECK(trace[2] == "a:location");
+    CHECK(std::count(trace.begin(), trace.end(), "b:location") == 0);
+    // second stage: c starts only after a has seen the whole document
+    auto a_end = std::find(trace.begin(), trace.end(), "a:end");
+    auto c_begin = std::find(trace.begin(), trace.end(), "c:begin");
+    CHECK(a_end < c_begin);
+    CHECK(std::count(trace.begin(), trace.end(), "a:location") ==
+          std::count(trace.begin(), trace.end(), "c:location"));
+}
@@ -22,6 +22,9 @@
 
 #include <doctest/doctest.h>
 
+#include <random>
+#include <sstream>
+
 TEST_CASE("Double Serialization Test")
 {
     auto doc = read_document("if_statement.xml");
@@ -80,6 +83,55 @@ TEST_CASE("External functions")
     doc->accept(checker);
     REQUIRE(errs.size() == 3);  // no new errors
     CHECK(warns.size() == 0);
+
+    // the functions which were found get typed invokers
+    auto invoker = [&doc](const std::string& name) -> const ExternalFunction* {
+        for (const auto& fun : doc->get_globals().functions)
+            if (fun.uid.get_name() == name)
+                if (const auto* body = dynamic_cast<const ExternalBlockStatement*>(fun.body.get()))
+                    return body->get_invoker();
+        return nullptr;
+    };
+    CHECK(invoker("absent") == nullptr);
+    const auto* multiply = invoker("multiply");
+    REQUIRE(multiply != nullptr);
+    external_value_t factors[] = {3, 7};
+    CHECK((*multiply)(factors).i == 21);
+    const auto* calc_sum = invoker("calc_sum");
+    REQUIRE(calc_sum != nullptr);
+    CHECK(calc_sum->get_result() == external_kind_t::Double);
+    CHECK(calc_sum->get_parameters() == std::vector{external_kind_t::Int, external_kind_t::Pointer});
+    double values[] = {3, 5, 7};
+    external_value_t sum_arguments[] = {3, values};
+    CHECK((*calc_sum)(sum_arguments).d == 15.0);
+    const auto* square = invoker("square");
+    REQUIRE(square != nullptr);
+    external_value_t numbers[] = {1, 2, 3};
+    external_value_t squares[3];
+    square->call(numbers, 3, squares);
+    CHECK(squares[0].i == 1);
+    CHECK(squares[2].i == 9);
+}
+
+TEST_CASE("Shared external libraries")
+{
+    using namespace UTAP;
+    auto first = read_document("external_fn.xml");
+    auto second = read_document("external_fn.xml");
+    REQUIRE(first);
+    REQUIRE(second);
+    // the documents share the library and the cached failures
+    CHECK(&first->last_library() == &second->last_library());
+    const auto& errs = first->get_errors();
+    REQUIRE(second->get_errors().size() == errs.size());
+    for (size_t i = 0; i < errs.size(); ++i)
+        CHECK(second->get_errors()[i].msg == errs[i].msg);
+    CHECK(first->last_library().get_symbol("multiply") == second->last_library().get_symbol("multiply"));
+    CHECK_THROWS_AS(second->last_library().get_symbol("absent"), std::runtime_error);
+    // the library stays loaded while a document refers to it
+    auto& library = second->last_library();
+    first.reset();
+    CHECK(library.get_symbol("multiply") != nullptr);
 }
 
 TEST_CASE("Error location")
@@ -98,8 +150,108 @@ TEST_CASE("Error location")
     doc->add_error(pos, "Non-deterministic input", "c?");
     REQUIRE(errs.size() == 1);
     const auto& error = errs.front();
-    REQUIRE(error.start.path != nullptr);
-    CHECK(*error.start.path == "/nta/template[1]/transition[1]/label[1]");
+    CHECK(error.get_path() == "/nta/template[1]/transition[1]/label[1]");
+}
+
+TEST_CASE("Source map locates label text in the buffer")
+{
+    const auto content = read_content("smc_non-deterministic_input2.xml");
+    auto doc = std::make_unique<UTAP::Document>();
+    REQUIRE(parse_XML_buffer(content.c_str(), doc.get(), true) == 0);
+    const auto& edges = doc->get_templates().front().edges;
+    REQUIRE(edges.size() > 0);
+    doc->add_error(edges.front().sync.get_position(), "Non-deterministic input", "c?");
+    const auto source = doc->get_errors().front().get_source();
+    REQUIRE(source);
+    CHECK(source->text(content) == "c?");
+    CHECK(doc->find_source("/nta/template[1]/transition[1]/label[1]")->offset == source->offset);
+    CHECK_FALSE(doc->find_source("/nta/template[42]"));
+    SUBCASE("Escaped text")
+    {
+        const auto decl = doc->find_source("/nta/declaration");
+        REQUIRE(decl);
+        CHECK(unescape_XML(decl->text(content)) == "broadcast chan c, m;");
+        CHECK(unescape_XML("x &lt; 3 &amp;&amp; y &gt;= 2&#33;") == "x < 3 && y >= 2!");
+        CHECK(unescape_XML("<![CDATA[a < b]]>\r\n") == "a < b\n");
+    }
+}
+
+/** Summary of a parsed document for comparing the results of different parse functions */
+static std::string document_summary(UTAP::Document& doc)
+{
+    auto os = std::ostringstream{};
+    doc.get_globals().print(os, true);
+    for (const auto& templ : doc.get_templates()) {
+        os << templ.uid.get_name() << ' ' << templ.locations.size() << '\n';
+        static_cast<const UTAP::declarations_t&>(templ).print(os);
+        for (const auto& edge : templ.edges)
+            os << edge.str() << '\n';
+    }
+    os << doc.get_processes().size() << ' ' << doc.get_queries().size() << '\n';
+    for (const auto& error : doc.get_errors())
+        os << error.msg << '\n';
+    for (const auto& warning : doc.get_warnings())
+        os << warning.msg << '\n';
+    return os.str();
+}
+
+TEST_CASE("XML model stream fed in random chunks")
+{
+    auto gen = std::mt19937{42};  // NOLINT: deterministic on purpose
+    for (const auto* name : {"simpleSystem.xml", "lsc_example.xml", "smc_non-deterministic_input2.xml",
+                             "dynamic.xml", "channel_priorities.xml", "if_statement.xml"}) {
+        CAPTURE(name);
+        const auto content = read_content(name);
+        auto expected = std::make_unique<UTAP::Document>();
+        const auto expected_res = parse_XML_buffer(content.c_str(), expected.get(), true);
+        for (auto max_chunk : {1u, 7u, 64u, 4096u}) {
+            CAPTURE(max_chunk);
+            auto doc = std::make_unique<UTAP::Document>();
+            auto stream = UTAP::XMLModelStream{*doc, true};
+            auto dist = std::uniform_int_distribution<size_t>{1, max_chunk};
+            for (auto pos = size_t{0}; pos < content.size();) {
+                const auto n = std::min(dist(gen), content.size() - pos);
+                stream.feed(content.data() + pos, n);
+                pos += n;
+            }
+            CHECK(stream.finish() == expected_res);
+            CHECK(document_summary(*doc) == document_summary(*expected));
+        }
+    }
+}
+
+TEST_CASE("XML model stream type checks the global declarations early")
+{
+    auto doc = std::make_unique<UTAP::Document>();
+    auto stream = UTAP::XMLModelStream{*doc, true};
+    const auto head = std::string{"<nta><declaration>clock c; int x = c;</declaration><template>"};
+    stream.feed(head.data(), head.size());
+    // the global declarations are complete once the next element has started
+    CHECK(doc->get_globals().frame.contains("x"));
+    CHECK(doc->get_errors().size() == 1);
+    CHECK(doc->get_templates().empty());
+    const auto tail = std::string{"<name>T</name><location id=\"a\"/><init ref=\"a\"/></template>"
+                                  "<system>system T;</system></nta>"};
+    stream.feed(tail.data(), tail.size());
+    CHECK(stream.finish() == 0);
+    CHECK(doc->get_templates().size() == 1);
+    CHECK(doc->get_errors().size() == 1);
+}
+
+TEST_CASE("XML model stream destroyed before finish")
+{
+    auto doc = std::make_unique<UTAP::Document>();
+    {
+        auto stream = UTAP::XMLModelStream{*doc, true};
+        const auto head = std::string{"<nta><declaration>int x;</declaration><template><name>T</name><location"};
+        stream.feed(head.data(), head.size());
+        CHECK(doc->get_globals().frame.contains("x"));
+    }
+    // the incomplete template is neither reported nor type checked
+    CHECK(doc->get_templates().empty());
+    CHECK(doc->get_processes().empty());
+    CHECK(doc->get_errors().empty());
+    CHECK(doc->get_warnings().empty());
 }
 
 TEST_CASE("SMC bounds in queries")
@@ -536,4 +688,19 @@ TEST_CASE("Increment with multiple array subscripting and dot accessing")
                    .parse();
 
     CHECK_MESSAGE(doc->get_errors().size() == 0, doc->get_errors().at(0).msg);
-}
\ No newline at end of file
+}
+TEST_CASE("Error budget stops parsing early")
+{
+    auto df = document_fixture{};
+    for (auto i = 0; i < 50; ++i)
+        df.add_template(template_fixture{"T" + std::to_string(i)}.add_declaration("int x = undefined;").str());
+    df.add_default_process();
+    const auto text = df.str();
+    auto doc = std::make_unique<UTAP::Document>();
+    auto res = parse_XML_buffer(text.c_str(), doc.get(), true, {}, UTAP::error_budget_t{10, 0});
+    CHECK(res == UTAP::PARSE_TRUNCATED);
+    CHECK(doc->is_truncated());
+    CHECK(doc->get_errors().size() == 10);
+    const auto& templates = doc->get_templates();
+    CHECK(templates.size() < 50);  // the remaining templates were not read
+}
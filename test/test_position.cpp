@@ -0,0 +1,95 @@
+// -*- mode: C++; c-file-style: "stroustrup"; c-basic-offset: 4; indent-tabs-mode: nil; -*-
+
+/* libutap - Uppaal Timed Automata Parser.
+   Copyright (C) 2023 Aalborg University.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation; either version 2.1 of
+   the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+   USA
+*/
+
+#include "utap/position.h"
+
+#include <doctest/doctest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using UTAP::position_index_t;
+
+TEST_CASE("Position index interns paths")
+{
+    auto index = position_index_t{};
+    CHECK(index.add_path("") == position_index_t::no_path);
+    const auto a = index.add_path("/nta/template[1]/declaration");
+    const auto b = index.add_path("/nta/template[2]/declaration");
+    CHECK(a != b);
+    CHECK(index.add_path("/nta/template[1]/declaration") == a);
+    CHECK(index.get_path(a) == "/nta/template[1]/declaration");
+    CHECK(index.get_path(b) == "/nta/template[2]/declaration");
+    CHECK(index.get_path_count() == 3);
+}
+
+TEST_CASE("Position index finds lines across blocks")
+{
+    auto index = position_index_t{};
+    auto expected = std::vector<position_index_t::line_t>{};
+    auto position = uint32_t{0};
+    for (auto label = 0u; label < 100; ++label) {
+        // mimic PositionTracker: setPath followed by a few newlines
+        const auto path = index.add_path("/nta/template[1]/transition[" + std::to_string(label + 1) + "]/label[1]");
+        ++position;
+        auto offset = uint32_t{0};
+        for (auto line = 1u; line <= label % 7 + 1; ++line) {
+            index.add(position, offset, line, path);
+            expected.emplace_back(position, offset, line, path);
+            position += 10 + line;
+            offset += 10 + line;
+        }
+    }
+    REQUIRE(index.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const auto& e = expected[i];
+        const auto end = (i + 1 < expected.size()) ? expected[i + 1].position : e.position + 100;
+        for (auto p : {e.position, (e.position + end) / 2, end - 1}) {
+            const auto l = index.find(p);
+            REQUIRE(l.position == e.position);
+            CHECK(l.offset == e.offset);
+            CHECK(l.line == e.line);
+            CHECK(l.path == e.path);
+        }
+    }
+    CHECK(index.memory_usage() < expected.size() * sizeof(position_index_t::line_t));
+}
+
+TEST_CASE("Position index rejects decreasing positions")
+{
+    auto index = position_index_t{};
+    CHECK_THROWS_AS(index.find(0), std::logic_error);
+    index.add(10, 0, 1, position_index_t::no_path);
+    CHECK_THROWS_AS(index.add(5, 0, 1, position_index_t::no_path), std::logic_error);
+}
+
+TEST_CASE("Errors resolve lines on demand")
+{
+    auto index = std::make_shared<position_index_t>();
+    const auto path = index->add_path("/nta/declaration");
+    index->add(1, 0, 1, path);
+    index->add(20, 19, 2, path);
+    auto error = UTAP::error_t{index, {22, 25}, "$syntax_error"};
+    CHECK(error.get_path() == "/nta/declaration");
+    CHECK(error.get_start().line == 2);
+    CHECK(error.str() == "$syntax_error in /nta/declaration at line 2 column 2 to line 2 column 5");
+}
@@ -23,6 +23,9 @@
 
 #include <doctest/doctest.h>
 
+#include <map>
+#include <string>
+
 TEST_SUITE("Quantifier sum")
 {
     TEST_CASE("sum expression")
@@ -473,4 +476,100 @@ TEST_CASE("Nested structs")
     CHECK(warns.size() == 0);
     auto errs = doc->get_errors();
     CHECK(errs.size() == 1);
-}
\ No newline at end of file
+}
+TEST_CASE("Error budget stops type checking early")
+{
+    auto df = document_fixture{};
+    df.add_global_decl("int a = 1;");
+    for (auto i = 0; i < 100; ++i)
+        df.add_global_decl("int b" + std::to_string(i) + " = a;");  // not computable at compile time
+    df.add_default_process();
+    const auto text = df.str();
+    SUBCASE("Without budget all errors are reported")
+    {
+        auto doc = std::make_unique<UTAP::Document>();
+        CHECK(parse_XML_buffer(text.c_str(), doc.get(), true) == 0);
+        CHECK(doc->get_errors().size() == 100);
+        CHECK_FALSE(doc->is_truncated());
+    }
+    SUBCASE("Budget set on the document")
+    {
+        auto doc = std::make_unique<UTAP::Document>();
+        doc->set_error_budget({5, 0});
+        CHECK(parse_XML_buffer(text.c_str(), doc.get(), true) == UTAP::PARSE_TRUNCATED);
+        CHECK(doc->get_errors().size() == 5);
+        CHECK(doc->is_truncated());
+    }
+    SUBCASE("Budget given to the parse call")
+    {
+        auto doc = std::make_unique<UTAP::Document>();
+        CHECK(parse_XML_buffer(text.c_str(), doc.get(), true, {}, UTAP::error_budget_t{3, 0}) ==
+              UTAP::PARSE_TRUNCATED);
+        CHECK(doc->get_errors().size() == 3);
+        CHECK(doc->is_truncated());
+    }
+    SUBCASE("Clearing keeps the truncation of the other messages")
+    {
+        auto doc = std::make_unique<UTAP::Document>();
+        doc->set_error_budget({2, 2});
+        for (auto i = 0; i < 3; ++i)
+            doc->add_warning({}, "warning");
+        doc->add_error({}, "error");
+        REQUIRE(doc->is_truncated());
+        doc->clear_errors();
+        CHECK(doc->is_truncated());
+        doc->clear_warnings();
+        CHECK_FALSE(doc->is_truncated());
+        doc->add_error({}, "error");
+        doc->add_error({}, "error");
+        doc->clear_warnings();
+        CHECK_FALSE(doc->is_truncated());
+        doc->add_error({}, "error");
+        REQUIRE(doc->is_truncated());
+        doc->clear_warnings();
+        CHECK(doc->is_truncated());
+        doc->clear_errors();
+        CHECK_FALSE(doc->is_truncated());
+        // warnings filling their budget were not dropped
+        doc->add_warning({}, "warning");
+        doc->add_warning({}, "warning");
+        for (auto i = 0; i < 3; ++i)
+            doc->add_error({}, "error");
+        REQUIRE(doc->is_truncated());
+        doc->clear_errors();
+        CHECK_FALSE(doc->is_truncated());
+    }
+}
+
+TEST_CASE("Side effect queries")
+{
+    auto df = document_fixture{};
+    df.add_global_decl("int g;\nint h;\n"
+                       "void set() { g = 1; }\n"
+                       "int get() { return g; }\n"
+                       "void inc(int& x) { x++; }\n"
+                       "int same(const int& x) { return x; }\n"
+                       "int k = get();");
+    auto doc = df.add_default_process().parse();
+    CHECK(doc->get_errors().size() == 0);
+    auto& globals = doc->get_globals();
+    auto side_effects = std::map<std::string, bool>{};
+    for (const auto& fun : globals.functions)
+        side_effects[fun.uid.get_name()] = fun.has_side_effects;
+    CHECK(side_effects["set"]);
+    CHECK(!side_effects["get"]);
+    CHECK(side_effects["inc"]);
+    CHECK(!side_effects["same"]);
+
+    auto g = globals.frame[*globals.frame.get_index_of("g")];
+    auto h = globals.frame[*globals.frame.get_index_of("h")];
+    const auto& init = globals.variables.back().init;
+    REQUIRE(init.get_kind() == UTAP::Constants::FUN_CALL);
+    CHECK(!init.changes_any_variable());
+    CHECK(init.depends_on({g}));
+    CHECK(!init.depends_on({h}));
+    auto reads = 0;
+    CHECK(init.depends_on_if([&reads](UTAP::symbol_t) { return ++reads > 0; }));
+    CHECK(reads == 1);
+    CHECK(!init.changes_variable_if([](UTAP::symbol_t) { return true; }));
+}